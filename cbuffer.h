@@ -74,6 +74,16 @@ struct ViewTransformData {
   float4    color;                          // float3 in HLSL, float4 in C++ to pad for alignment
 };
 
+/*! @struct ObjectTransformData
+
+*/
+// Per object part of ViewTransformData, fits in the 128 bytes of push 
+// constants every Vulkan device supports.
+struct ObjectTransformData {
+  float4x4  model_matrix;                   // float4x4 in HLSL and C++
+  float4x4  model_view_projection_matrix;   // float4x4 in HLSL and C++
+};
+
 /*! @class ViewTransformBuffer
 
 */
@@ -46,6 +46,7 @@ using float4x3 = glm::mat4x3;
 
 const char*           k_app_name = "ChessSet";
 const uint32_t        k_image_count = 3;
+const uint32_t        k_frame_count = 2;
 #if defined(TINY_RENDERER_GGP)
 const tr::fs::path   k_asset_dir = "./demos/assets/";
 #elif defined(TINY_RENDERER_LINUX)
@@ -58,8 +59,7 @@ const uint32_t k_window_width  = 1920;
 const uint32_t k_window_height = 1080;
 
 tr_renderer*          g_renderer = nullptr;
-tr_cmd_pool*          g_cmd_pool = nullptr;
-tr_cmd**              g_cmds = nullptr;
+tr_frame_context*     g_frame_context = nullptr;
 
 tr::BlinnPhongEntity  g_chess_board_1_solid;
 tr::BlinnPhongEntity  g_chess_board_2_solid;
@@ -73,7 +73,6 @@ tr_shader_program*    g_normal_wireframe_shader = nullptr;
 
 uint32_t              g_window_width;
 uint32_t              g_window_height;
-uint64_t              g_frame_count = 0;
 
 tr::Camera            g_camera;
 
@@ -188,8 +187,7 @@ void init_tiny_renderer(GLFWwindow* window)
 
     // Command buffers
     {
-      tr_create_cmd_pool(g_renderer, g_renderer->graphics_queue, false, &g_cmd_pool);
-      tr_create_cmd_n(g_cmd_pool, false, k_image_count, &g_cmds);
+      tr_create_frame_context(g_renderer, g_renderer->graphics_queue, k_frame_count, &g_frame_context);
     }
   }
     
@@ -228,6 +226,7 @@ void init_tiny_renderer(GLFWwindow* window)
     entity_create_info.shader_program                   = g_phong_shader;
     entity_create_info.vertex_layout                    = tr::Mesh::DefaultVertexLayout();
     entity_create_info.render_target                    = g_renderer->swapchain_render_targets[0];
+    entity_create_info.frame_count                      = k_frame_count;
     entity_create_info.pipeline_settings.primitive_topo = tr_primitive_topo_tri_list;
     entity_create_info.pipeline_settings.depth          = true;
     entity_create_info.pipeline_settings.cull_mode      = tr_cull_mode_back;
@@ -242,6 +241,7 @@ void init_tiny_renderer(GLFWwindow* window)
     entity_create_info.shader_program                   = g_normal_wireframe_shader;
     entity_create_info.vertex_layout                    = tr::Mesh::DefaultVertexLayout();
     entity_create_info.render_target                    = g_renderer->swapchain_render_targets[0];
+    entity_create_info.frame_count                      = k_frame_count;
     entity_create_info.pipeline_settings.primitive_topo = tr_primitive_topo_tri_list;
     entity_create_info.pipeline_settings.depth          = true;
 
@@ -252,20 +252,36 @@ void init_tiny_renderer(GLFWwindow* window)
 
   // Vertex data
   {
+    // Optimized models are cached as .trmesh next to the OBJs
+    tr::Mesh::SetCacheDirectory((k_asset_dir / "ChessSet/models").str());
+
+    // Logs the vertex cache gain of the optimization done at load
+    auto load_mesh = [](const tr::fs::path& file_path, tr::Mesh* p_mesh) {
+      bool result = tr::Mesh::Load(file_path, p_mesh);
+      assert(result == true);
+      const tr::MeshCacheStats& stats = p_mesh->GetCacheStats();
+      LOG(file_path.str() << " : ACMR " << stats.acmr_before << " -> " << stats.acmr_after 
+                             << ", ATVR " << stats.atvr_before << " -> " << stats.atvr_after);
+      if (p_mesh->GetCacheStatus() == tr::MESH_CACHE_STATUS_WRITE_FAILED) {
+        LOG(file_path.str() << " : couldn't write the mesh cache");
+      }
+    };
+
+    tr::Mesh mesh;
     // Chess board 1
-    tr::fs::path file_path = k_asset_dir / "ChessSet/models/board1.obj";
-    g_chess_board_1_solid.LoadVertexBuffers(file_path);     
+    load_mesh(k_asset_dir / "ChessSet/models/board1.obj", &mesh);
+    g_chess_board_1_solid.SetVertexBuffers(mesh);     
     // Chess board 2
-    file_path = k_asset_dir / "ChessSet/models/board2.obj";
-    g_chess_board_2_solid.LoadVertexBuffers(file_path);
+    load_mesh(k_asset_dir / "ChessSet/models/board2.obj", &mesh);
+    g_chess_board_2_solid.SetVertexBuffers(mesh);
     // Chest pieces 1
-    file_path = k_asset_dir / "ChessSet/models/pieces1.obj";
-    g_chess_pieces_1_solid.LoadVertexBuffers(file_path);
-    g_chess_pieces_1_wireframe.LoadVertexBuffers(file_path);   
+    load_mesh(k_asset_dir / "ChessSet/models/pieces1.obj", &mesh);
+    g_chess_pieces_1_solid.SetVertexBuffers(mesh);
+    g_chess_pieces_1_wireframe.SetVertexBuffers(mesh);   
     // Chest pieces 2
-    file_path = k_asset_dir / "ChessSet/models/pieces2.obj";
-    g_chess_pieces_2_solid.LoadVertexBuffers(file_path);
-    g_chess_pieces_2_wireframe.LoadVertexBuffers(file_path);
+    load_mesh(k_asset_dir / "ChessSet/models/pieces2.obj", &mesh);
+    g_chess_pieces_2_solid.SetVertexBuffers(mesh);
+    g_chess_pieces_2_wireframe.SetVertexBuffers(mesh);
   }
 
   // Update descriptors
@@ -281,21 +297,16 @@ void init_tiny_renderer(GLFWwindow* window)
 
 void destroy_tiny_renderer()
 {
+    tr_destroy_frame_context(g_renderer, g_frame_context);
     tr_destroy_renderer(g_renderer);
 }
 
 void draw_frame()
 {
-    uint32_t frameIdx = g_frame_count % g_renderer->settings.swapchain.image_count;
-
-    tr_fence* image_acquired_fence = g_renderer->image_acquired_fences[frameIdx];
-    tr_semaphore* image_acquired_semaphore = g_renderer->image_acquired_semaphores[frameIdx];
-    tr_semaphore* render_complete_semaphores = g_renderer->render_complete_semaphores[frameIdx];
-
-    tr_acquire_next_image(g_renderer, image_acquired_semaphore, image_acquired_fence);
-
-    uint32_t swapchain_image_index = g_renderer->swapchain_image_index;
-    tr_render_target* render_target = g_renderer->swapchain_render_targets[swapchain_image_index];
+    tr_cmd* cmd = nullptr;
+    tr_render_target* render_target = nullptr;
+    tr_begin_frame(g_frame_context, &cmd, &render_target);
+    uint32_t frame_index = g_frame_context->frame_index;
 
     float3 eye = float3(0, 7, 12);
     float3 look_at = float3(0, 0, 0);
@@ -327,14 +338,13 @@ void draw_frame()
     g_chess_pieces_1_wireframe.SetTransform(transform);
     g_chess_pieces_2_wireframe.SetTransform(transform);
 
-    g_chess_board_1_solid.UpdateGpuBuffers();
-    g_chess_board_2_solid.UpdateGpuBuffers();
-    g_chess_pieces_1_solid.UpdateGpuBuffers();
-    g_chess_pieces_2_solid.UpdateGpuBuffers();
-    g_chess_pieces_1_wireframe.UpdateGpuBuffers();
-    g_chess_pieces_2_wireframe.UpdateGpuBuffers();
+    g_chess_board_1_solid.UpdateGpuBuffers(frame_index);
+    g_chess_board_2_solid.UpdateGpuBuffers(frame_index);
+    g_chess_pieces_1_solid.UpdateGpuBuffers(frame_index);
+    g_chess_pieces_2_solid.UpdateGpuBuffers(frame_index);
+    g_chess_pieces_1_wireframe.UpdateGpuBuffers(frame_index);
+    g_chess_pieces_2_wireframe.UpdateGpuBuffers(frame_index);
 
-    tr_cmd* cmd = g_cmds[frameIdx];
     tr_begin_cmd(cmd);
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_present, tr_texture_usage_color_attachment); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_sampled_image, tr_texture_usage_depth_stencil_attachment);
@@ -346,25 +356,22 @@ void draw_frame()
     tr_cmd_clear_depth_stencil_attachment(cmd, &g_depth_stencil_clear_value);
     // Draw phong
     {
-      g_chess_board_1_solid.Draw(cmd);
-      g_chess_board_2_solid.Draw(cmd);
-      g_chess_pieces_1_solid.Draw(cmd);
-      g_chess_pieces_2_solid.Draw(cmd);
+      g_chess_board_1_solid.DrawIndexed(cmd);
+      g_chess_board_2_solid.DrawIndexed(cmd);
+      g_chess_pieces_1_solid.DrawIndexed(cmd);
+      g_chess_pieces_2_solid.DrawIndexed(cmd);
     }
     // Draw normal wireframe 
     {
-      g_chess_pieces_1_wireframe.Draw(cmd);
-      g_chess_pieces_2_wireframe.Draw(cmd);
+      g_chess_pieces_1_wireframe.DrawIndexed(cmd);
+      g_chess_pieces_2_wireframe.DrawIndexed(cmd);
     }
     tr_cmd_end_render(cmd);
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_color_attachment, tr_texture_usage_present); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_depth_stencil_attachment, tr_texture_usage_sampled_image);
     tr_end_cmd(cmd);
 
-    tr_queue_submit(g_renderer->graphics_queue, 1, &cmd, 1, &image_acquired_semaphore, 1, &render_complete_semaphores);
-    tr_queue_present(g_renderer->present_queue, 1, &render_complete_semaphores);
-
-    tr_queue_wait_idle(g_renderer->graphics_queue);
+    tr_end_frame(g_frame_context);
 }
 
 int main(int argc, char **argv)
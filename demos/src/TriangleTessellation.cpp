@@ -33,6 +33,7 @@ using namespace tr;
 
 const char*         k_app_name = "TriangleTessellation";
 const uint32_t      k_image_count = 3;
+const uint32_t      k_frame_count = 2;
 #if defined(TINY_RENDERER_GGP)
 const tr::fs::path   k_asset_dir = "./demos/assets/";
 #elif defined(TINY_RENDERER_LINUX)
@@ -54,8 +55,7 @@ using TessBlinnPhongEntity  = tr::EntityT<tr::BlinnPhongBuffer, TessParams>;
 using TessBasicEntity       = tr::EntityT<NullBuffer,TessParams>;
 
 tr_renderer*          g_renderer = nullptr;
-tr_cmd_pool*          g_cmd_pool = nullptr;
-tr_cmd**              g_cmds = nullptr;
+tr_frame_context*     g_frame_context = nullptr;
 
 tr::BlinnPhongEntity  g_chess_pieces_base;
 tr::BasicEntity       g_chess_pieces_base_wireframe;
@@ -69,10 +69,11 @@ tr_shader_program*    g_tess_wireframe_shader = nullptr;
 
 tr_buffer*            g_vertex_buffer = nullptr;
 uint32_t              g_vertex_count = 0;
+tr_buffer*            g_index_buffer = nullptr;
+uint32_t              g_index_count = 0;
 
 uint32_t              g_window_width;
 uint32_t              g_window_height;
-uint64_t              g_frame_count = 0;
 
 tr::Camera            g_camera;
 
@@ -200,8 +201,7 @@ void init_tiny_renderer(GLFWwindow* window)
 #endif
     tr_create_renderer(k_app_name, &settings, &g_renderer);
 
-    tr_create_cmd_pool(g_renderer, g_renderer->graphics_queue, false, &g_cmd_pool);
-    tr_create_cmd_n(g_cmd_pool, false, k_image_count, &g_cmds);
+    tr_create_frame_context(g_renderer, g_renderer->graphics_queue, k_frame_count, &g_frame_context);
     
 #if defined(TINY_RENDERER_VK)
     tr::fs::path base_vs_file_path            = k_asset_dir / "TriangleTessellation/shaders/base.vs.spv"; 
@@ -261,6 +261,7 @@ void init_tiny_renderer(GLFWwindow* window)
       entity_create_info.shader_program                   = g_base_shader;
       entity_create_info.vertex_layout                    = tr::Mesh::DefaultVertexLayout();
       entity_create_info.render_target                    = g_renderer->swapchain_render_targets[0];
+      entity_create_info.frame_count                      = k_frame_count;
       entity_create_info.pipeline_settings.primitive_topo = tr_primitive_topo_tri_list;
       entity_create_info.pipeline_settings.depth          = true;
       entity_create_info.pipeline_settings.cull_mode      = tr_cull_mode_back;
@@ -296,17 +297,17 @@ void init_tiny_renderer(GLFWwindow* window)
     // Vertex data
     {
       tr::fs::path file_path = k_asset_dir / "TriangleTessellation/models/chess_pieces_shared_normals.obj";
-      bool result = tr::Mesh::Load(file_path, g_renderer, &g_vertex_buffer, &g_vertex_count);
+      bool result = tr::Mesh::Load(file_path, g_renderer, &g_vertex_buffer, &g_vertex_count, &g_index_buffer, &g_index_count);
       assert(result == true);
 
       // Base chess pieces
-      g_chess_pieces_base.SetVertexBuffers(g_vertex_buffer, g_vertex_count);
+      g_chess_pieces_base.SetVertexBuffers(g_vertex_buffer, g_vertex_count, g_index_buffer, g_index_count);
       // Base wireframe chess pieces
-      g_chess_pieces_base_wireframe.SetVertexBuffers(g_vertex_buffer, g_vertex_count);
+      g_chess_pieces_base_wireframe.SetVertexBuffers(g_vertex_buffer, g_vertex_count, g_index_buffer, g_index_count);
       // Tessellated chess pieces
-      g_chess_pieces_tess.SetVertexBuffers(g_vertex_buffer, g_vertex_count);
+      g_chess_pieces_tess.SetVertexBuffers(g_vertex_buffer, g_vertex_count, g_index_buffer, g_index_count);
       // Tessellated wireframe chess pieces
-      g_chess_pieces_tess_wireframe.SetVertexBuffers(g_vertex_buffer, g_vertex_count);
+      g_chess_pieces_tess_wireframe.SetVertexBuffers(g_vertex_buffer, g_vertex_count, g_index_buffer, g_index_count);
     }
 
     // Update descriptors
@@ -320,21 +321,16 @@ void init_tiny_renderer(GLFWwindow* window)
 
 void destroy_tiny_renderer()
 {
+    tr_destroy_frame_context(g_renderer, g_frame_context);
     tr_destroy_renderer(g_renderer);
 }
 
 void draw_frame()
 {
-    uint32_t frameIdx = g_frame_count % g_renderer->settings.swapchain.image_count;
-
-    tr_fence* image_acquired_fence = g_renderer->image_acquired_fences[frameIdx];
-    tr_semaphore* image_acquired_semaphore = g_renderer->image_acquired_semaphores[frameIdx];
-    tr_semaphore* render_complete_semaphores = g_renderer->render_complete_semaphores[frameIdx];
-
-    tr_acquire_next_image(g_renderer, image_acquired_semaphore, image_acquired_fence);
-
-    uint32_t swapchain_image_index = g_renderer->swapchain_image_index;
-    tr_render_target* render_target = g_renderer->swapchain_render_targets[swapchain_image_index];
+    tr_cmd* cmd = nullptr;
+    tr_render_target* render_target = nullptr;
+    tr_begin_frame(g_frame_context, &cmd, &render_target);
+    uint32_t frame_index = g_frame_context->frame_index;
 
     float3 eye = float3(0, 8, 8);
     float3 look_at = float3(0, 1, 0);
@@ -359,8 +355,8 @@ void draw_frame()
       // Color
       g_chess_pieces_base.SetColor(float3(0.45f, 0.4f, 0.8f));
       // Constant buffers
-      g_chess_pieces_base.UpdateGpuBuffers();
-      g_chess_pieces_base_wireframe.UpdateGpuBuffers();
+      g_chess_pieces_base.UpdateGpuBuffers(frame_index);
+      g_chess_pieces_base_wireframe.UpdateGpuBuffers(frame_index);
     }
 
     // Update tess transform and constant buffers
@@ -381,11 +377,10 @@ void draw_frame()
       g_chess_pieces_tess.GetTessParams().data.tess_factor = float4(float3(3.0f), 0);
       g_chess_pieces_tess_wireframe.GetTessParams().data.tess_factor = float4(float3(3.0f), 0);
       // Constant buffers
-      g_chess_pieces_tess.UpdateGpuBuffers();
-      g_chess_pieces_tess_wireframe.UpdateGpuBuffers();
+      g_chess_pieces_tess.UpdateGpuBuffers(frame_index);
+      g_chess_pieces_tess_wireframe.UpdateGpuBuffers(frame_index);
     }
 
-    tr_cmd* cmd = g_cmds[frameIdx];
     tr_begin_cmd(cmd);
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_present, tr_texture_usage_color_attachment); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_sampled_image, tr_texture_usage_depth_stencil_attachment);
@@ -397,23 +392,20 @@ void draw_frame()
     tr_cmd_set_line_width(cmd, 1.0f);
     {
       // Draw base
-      g_chess_pieces_base.Draw(cmd);
+      g_chess_pieces_base.DrawIndexed(cmd);
       // Draw base wireframe
-      g_chess_pieces_base_wireframe.Draw(cmd);
+      g_chess_pieces_base_wireframe.DrawIndexed(cmd);
       // Draw tess
-      g_chess_pieces_tess.Draw(cmd);
+      g_chess_pieces_tess.DrawIndexed(cmd);
       // Draw tess wireframe
-      g_chess_pieces_tess_wireframe.Draw(cmd);
+      g_chess_pieces_tess_wireframe.DrawIndexed(cmd);
     }
     tr_cmd_end_render(cmd);
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_color_attachment, tr_texture_usage_present); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_depth_stencil_attachment, tr_texture_usage_sampled_image);
     tr_end_cmd(cmd);
 
-    tr_queue_submit(g_renderer->graphics_queue, 1, &cmd, 1, &image_acquired_semaphore, 1, &render_complete_semaphores);
-    tr_queue_present(g_renderer->present_queue, 1, &render_complete_semaphores);
-
-    tr_queue_wait_idle(g_renderer->graphics_queue);
+    tr_end_frame(g_frame_context);
 }
 
 int main(int argc, char **argv)
@@ -28,6 +28,11 @@ enum EntityDescriptorBinding {
   ENTITY_DESCRIPTOR_BINDING_COUNT,
 };
 
+// D3D12 register of the pushed ObjectTransformData
+enum EntityPushConstantBinding {
+  ENTITY_PUSH_CONSTANT_BINDING_OBJECT_TRANSFORM = ENTITY_DESCRIPTOR_BINDING_COUNT,
+};
+
 struct ShaderCreateInfo {
   std::vector<uint8_t>  code;
   std::string           entry_point;
@@ -41,6 +46,12 @@ struct EntityCreateInfo {
   std::vector<uint32_t> buffer_bindings;
   tr_render_target*     render_target;
   tr_pipeline_settings  pipeline_settings;
+  // Frames in flight, each frame gets its own constant buffers. 0 means 1.
+  uint32_t              frame_count;
+  // Pushes ObjectTransformData with every draw, the shaders must read the
+  // model and MVP matrices from push constants. The view transform buffer
+  // is then only rewritten when the view changes.
+  bool                  push_object_transform;
 };
 
 /*! @class EntityT
@@ -55,6 +66,8 @@ public:
   void Destroy();
 
   bool SetVertexBuffers(tr_buffer* p_buffer, uint32_t vertex_count);
+  bool SetVertexBuffers(tr_buffer* p_vertex_buffer, uint32_t vertex_count, tr_buffer* p_index_buffer, uint32_t index_count);
+  bool SetVertexBuffers(tr_buffer* p_vertex_buffer, uint32_t vertex_count, tr_buffer* p_index_buffer, uint32_t index_count, const std::vector<tr::Submesh>& submeshes);
   bool SetVertexBuffers(const tr::Mesh& mesh);
   bool LoadVertexBuffers(const tr::fs::path& file_path);
   bool SetTexture(uint32_t binding, tr_texture* p_texture);
@@ -72,22 +85,31 @@ public:
   const TessParamsT&      GetTessParams() const;
 
   void UpdateGpuDescriptorSets();
-  void UpdateGpuBuffers();
+  // Writes the constant buffers of frame_index, which the following 
+  // Draw calls bind until the next UpdateGpuBuffers.
+  void UpdateGpuBuffers(uint32_t frame_index = 0);
 
   void Draw(tr_cmd* p_cmd, uint32_t vertex_count = UINT32_MAX);
   void DrawIndexed(tr_cmd* p_cmd, uint32_t index_count = UINT32_MAX);
+  // Binds once and issues one draw per listed submesh
+  void DrawSubmeshes(tr_cmd* p_cmd, uint32_t submesh_count, const uint32_t* p_submesh_indices);
+
+  const std::vector<tr::Submesh>& GetSubmeshes() const;
 
 private:
   void SetViewDirty(bool value);
   void SetTranformDirty(bool value);
+  void BindIndexedGeometry(tr_cmd* p_cmd);
+  void PushObjectTransform(tr_cmd* p_cmd);
 
 private:
   // Renderer
   tr_renderer*                m_renderer = nullptr;
   // Pipeline
   EntityCreateInfo            m_create_info = {};
-  tr_descriptor_set*          m_descriptor_set = nullptr;
+  std::vector<tr_descriptor_set*> m_descriptor_sets;
   tr_pipeline*                m_pipeline = nullptr;
+  uint32_t                    m_frame_index = 0;
   // Textures
   struct TextureBinding {
     uint32_t    binding;
@@ -99,18 +121,22 @@ private:
   uint32_t                    m_index_count = UINT32_MAX;
   std::vector<tr_buffer*>     m_vertex_buffers;
   uint32_t                    m_vertex_count = UINT32_MAX;
+  std::vector<tr::Submesh>    m_submeshes;
   // Transform
   tr::Transform               m_transform;
   bool                        m_view_dirty = false;
   bool                        m_transform_dirty = false;
   ViewTransformBuffer         m_cpu_view_transform;
-  tr_buffer*                  m_gpu_view_transform = nullptr;
+  std::vector<tr_buffer*>     m_gpu_view_transforms;
+  // Bit N is set while frame N's buffer holds an older view, only used with push_object_transform
+  uint32_t                    m_view_transform_stale_frames = 0;
+  ObjectTransformData         m_cpu_object_transform = {};
   // Lighting
   LightingParamsT             m_cpu_lighting_params;
-  tr_buffer*                  m_gpu_lighting_params = nullptr;
+  std::vector<tr_buffer*>     m_gpu_lighting_params;
   // Tessellation
   TessParamsT                 m_cpu_tess_params;
-  tr_buffer*                  m_gpu_tess_params = nullptr;
+  std::vector<tr_buffer*>     m_gpu_tess_params;
 };
 
 /*! @fn EntityT<CpuLightingBufferT>::EntityT */
@@ -143,6 +169,12 @@ bool EntityT<LightingParamsT, TessParamsT>::Create(tr_renderer* p_renderer, cons
 
   // Copy create info
   m_create_info = create_info;
+  if (m_create_info.frame_count == 0) {
+    m_create_info.frame_count = 1;
+  }
+  uint32_t frame_count = m_create_info.frame_count;
+  // One bit per frame in m_view_transform_stale_frames
+  assert(frame_count <= 32);
 
   // Minimum size must be 4 bytes. Just note that empty C++ structs
   // are always 1 byte in size.
@@ -212,19 +244,33 @@ bool EntityT<LightingParamsT, TessParamsT>::Create(tr_renderer* p_renderer, cons
       ++index;
     }
 
-    tr_create_descriptor_set(p_renderer,
-                              (uint32_t)descriptors.size(),
-                              descriptors.data(),
-                              &m_descriptor_set);
-    assert(m_descriptor_set != nullptr);
+    m_descriptor_sets.resize(frame_count, nullptr);
+    for (auto& p_descriptor_set : m_descriptor_sets) {
+      tr_create_descriptor_set(p_renderer,
+                                (uint32_t)descriptors.size(),
+                                descriptors.data(),
+                                &p_descriptor_set);
+      assert(p_descriptor_set != nullptr);
+    }
   }
 
   // Pipeline
   {
+    if (m_create_info.push_object_transform) {
+      tr_pipeline_settings& settings = m_create_info.pipeline_settings;
+      assert(settings.push_constant_range_count < tr_max_push_constant_ranges);
+      tr_push_constant_range& range = settings.push_constant_ranges[settings.push_constant_range_count];
+      range.shader_stages = tr_shader_stage_all_graphics;
+      range.offset        = 0;
+      range.size          = sizeof(ObjectTransformData);
+      range.binding       = ENTITY_PUSH_CONSTANT_BINDING_OBJECT_TRANSFORM;
+      ++settings.push_constant_range_count;
+    }
+
     tr_create_pipeline(m_renderer,
                        m_create_info.shader_program,
                        &m_create_info.vertex_layout,
-                       m_descriptor_set,
+                       m_descriptor_sets[0],
                        m_create_info.render_target,
                        &m_create_info.pipeline_settings,
                        &m_pipeline);
@@ -235,29 +281,38 @@ bool EntityT<LightingParamsT, TessParamsT>::Create(tr_renderer* p_renderer, cons
   {
     if (has_view_transform) {
       uint32_t buffer_size = m_cpu_view_transform.GetDataSize();
-      tr_create_uniform_buffer(m_renderer, 
-                               buffer_size, 
-                               true, 
-                               &m_gpu_view_transform);
-      assert(m_gpu_view_transform != nullptr);
+      m_gpu_view_transforms.resize(frame_count, nullptr);
+      for (auto& p_buffer : m_gpu_view_transforms) {
+        tr_create_uniform_buffer(m_renderer, 
+                                 buffer_size, 
+                                 true, 
+                                 &p_buffer);
+        assert(p_buffer != nullptr);
+      }
     }
 
     if (has_lighting) {
       uint32_t buffer_size = m_cpu_lighting_params.GetDataSize();
-      tr_create_uniform_buffer(m_renderer, 
-                               buffer_size, 
-                               true, 
-                               &m_gpu_lighting_params);
-      assert(m_gpu_lighting_params != nullptr);
+      m_gpu_lighting_params.resize(frame_count, nullptr);
+      for (auto& p_buffer : m_gpu_lighting_params) {
+        tr_create_uniform_buffer(m_renderer, 
+                                 buffer_size, 
+                                 true, 
+                                 &p_buffer);
+        assert(p_buffer != nullptr);
+      }
     }
 
     if (has_tess) {
       uint32_t buffer_size = m_cpu_tess_params.GetDataSize();
-      tr_create_uniform_buffer(m_renderer, 
-                               buffer_size, 
-                               true, 
-                               &m_gpu_tess_params);
-      assert(m_gpu_tess_params != nullptr);
+      m_gpu_tess_params.resize(frame_count, nullptr);
+      for (auto& p_buffer : m_gpu_tess_params) {
+        tr_create_uniform_buffer(m_renderer, 
+                                 buffer_size, 
+                                 true, 
+                                 &p_buffer);
+        assert(p_buffer != nullptr);
+      }
     }
   }
 
@@ -279,6 +334,27 @@ bool EntityT<LightingParamsT, TessParamsT>::SetVertexBuffers(tr_buffer* p_buffer
   return true;
 }
 
+/*! @fn EntityT<CpuLightingBufferT>::SetVertexBuffers */
+template <typename LightingParamsT, typename TessParamsT>
+bool EntityT<LightingParamsT, TessParamsT>::SetVertexBuffers(tr_buffer* p_vertex_buffer, uint32_t vertex_count, tr_buffer* p_index_buffer, uint32_t index_count)
+{
+  m_vertex_buffers = { p_vertex_buffer };
+  m_vertex_count = vertex_count;
+  m_index_buffer = p_index_buffer;
+  m_index_count = index_count;
+  m_submeshes.clear();
+  return true;
+}
+
+/*! @fn EntityT<CpuLightingBufferT>::SetVertexBuffers */
+template <typename LightingParamsT, typename TessParamsT>
+bool EntityT<LightingParamsT, TessParamsT>::SetVertexBuffers(tr_buffer* p_vertex_buffer, uint32_t vertex_count, tr_buffer* p_index_buffer, uint32_t index_count, const std::vector<tr::Submesh>& submeshes)
+{
+  SetVertexBuffers(p_vertex_buffer, vertex_count, p_index_buffer, index_count);
+  m_submeshes = submeshes;
+  return true;
+}
+
 /*! @fn EntityT<CpuLightingBufferT>::SetVertexBuffers */
 template <typename LightingParamsT, typename TessParamsT>
 bool EntityT<LightingParamsT, TessParamsT>::SetVertexBuffers(const tr::Mesh& mesh)
@@ -291,6 +367,18 @@ bool EntityT<LightingParamsT, TessParamsT>::SetVertexBuffers(const tr::Mesh& mes
 
   m_vertex_buffers = { p_buffer };
   m_vertex_count = mesh.GetVertexCount();
+
+  if (mesh.GetIndexCount() > 0) {
+    tr_buffer* p_index_buffer = nullptr;
+    tr_create_index_buffer(m_renderer, mesh.GetIndexDataSize(), true, mesh.GetIndexType(), &p_index_buffer);
+    assert(p_index_buffer != nullptr);
+
+    mesh.CopyIndexData(p_index_buffer->cpu_mapped_address);
+
+    m_index_buffer = p_index_buffer;
+    m_index_count = mesh.GetIndexCount();
+  }
+  m_submeshes = mesh.GetSubmeshes();
   return true;
 }
 
@@ -298,12 +386,18 @@ bool EntityT<LightingParamsT, TessParamsT>::SetVertexBuffers(const tr::Mesh& mes
 template <typename LightingParamsT, typename TessParamsT>
 bool EntityT<LightingParamsT, TessParamsT>::LoadVertexBuffers(const tr::fs::path& file_path)
 {
-  tr::Mesh mesh;
-  bool mesh_load_res = tr::Mesh::Load(file_path, &mesh);
+  // Goes through the buffer overload so a cached mesh is copied straight
+  // into the GPU buffers.
+  tr_buffer* p_vertex_buffer = nullptr;
+  uint32_t vertex_count = 0;
+  tr_buffer* p_index_buffer = nullptr;
+  uint32_t index_count = 0;
+  std::vector<tr::Submesh> submeshes;
+  bool mesh_load_res = tr::Mesh::Load(file_path, m_renderer, &p_vertex_buffer, &vertex_count, &p_index_buffer, &index_count, &submeshes);
   if (!mesh_load_res) {
     return false;
   }
-  bool set_res = SetVertexBuffers(mesh);
+  bool set_res = SetVertexBuffers(p_vertex_buffer, vertex_count, p_index_buffer, index_count, submeshes);
   return set_res;
 }
 
@@ -394,42 +488,50 @@ void tr::EntityT<LightingParamsT, TessParamsT>::SetColor(const float3& color)
 template <typename LightingParamsT, typename TessParamsT>
 void EntityT<LightingParamsT, TessParamsT>::UpdateGpuDescriptorSets()
 {
-  uint32_t index = 0;
-  if (m_gpu_view_transform != nullptr) {
-    m_descriptor_set->descriptors[index].uniform_buffers[0] = m_gpu_view_transform;
-    ++index;
-  }
+  for (uint32_t frame_index = 0; frame_index < m_descriptor_sets.size(); ++frame_index) {
+    tr_descriptor_set* p_descriptor_set = m_descriptor_sets[frame_index];
 
-  if (m_gpu_lighting_params != nullptr) {
-    m_descriptor_set->descriptors[index].uniform_buffers[0] = m_gpu_lighting_params;
-    ++index;
-  }
+    uint32_t index = 0;
+    if (!m_gpu_view_transforms.empty()) {
+      p_descriptor_set->descriptors[index].uniform_buffers[0] = m_gpu_view_transforms[frame_index];
+      ++index;
+    }
 
-  if (m_gpu_tess_params != nullptr) {
-    m_descriptor_set->descriptors[index].uniform_buffers[0] = m_gpu_tess_params;
-    ++index;
-  }
+    if (!m_gpu_lighting_params.empty()) {
+      p_descriptor_set->descriptors[index].uniform_buffers[0] = m_gpu_lighting_params[frame_index];
+      ++index;
+    }
 
-  for (const auto& texture_binding : m_texture_bindings) {
-    for (uint32_t i = 0; i < m_descriptor_set->descriptor_count; ++i) {
-      auto& descriptor = m_descriptor_set->descriptors[index];
-      if  (descriptor.binding == texture_binding.binding) {
-        assert(descriptor.type == tr_descriptor_type_texture_srv);
-        descriptor.textures[0] = texture_binding.texture;
+    if (!m_gpu_tess_params.empty()) {
+      p_descriptor_set->descriptors[index].uniform_buffers[0] = m_gpu_tess_params[frame_index];
+      ++index;
+    }
+
+    for (const auto& texture_binding : m_texture_bindings) {
+      for (uint32_t i = 0; i < p_descriptor_set->descriptor_count; ++i) {
+        auto& descriptor = p_descriptor_set->descriptors[index];
+        if  (descriptor.binding == texture_binding.binding) {
+          assert(descriptor.type == tr_descriptor_type_texture_srv);
+          descriptor.textures[0] = texture_binding.texture;
+        }
       }
     }
+    tr_update_descriptor_set(m_renderer, p_descriptor_set);
   }
-  tr_update_descriptor_set(m_renderer, m_descriptor_set);
 }
 
 /*! @fn EntityT<CpuLightingBufferT>::UpdateGpuBuffers */
 template <typename LightingParamsT, typename TessParamsT>
-void EntityT<LightingParamsT, TessParamsT>::UpdateGpuBuffers()
+void EntityT<LightingParamsT, TessParamsT>::UpdateGpuBuffers(uint32_t frame_index)
 {
+  assert(frame_index < m_descriptor_sets.size());
+  m_frame_index = frame_index;
+
   // View/transform constant buffer
-  if ((m_gpu_view_transform != nullptr) && (m_view_dirty || m_transform_dirty)) {
+  if (!m_gpu_view_transforms.empty()) {
     if (m_view_dirty) {
-      // Nothing for now
+      uint32_t frame_count = (uint32_t)m_gpu_view_transforms.size();
+      m_view_transform_stale_frames = (frame_count < 32) ? ((1u << frame_count) - 1u) : ~0u;
       m_view_dirty = false;
     }
 
@@ -438,17 +540,32 @@ void EntityT<LightingParamsT, TessParamsT>::UpdateGpuBuffers()
       m_transform_dirty = false;
     }
 
-    m_cpu_view_transform.Write(m_gpu_view_transform->cpu_mapped_address);
+    if (m_create_info.push_object_transform) {
+      // The model dependent matrices go out with the draw, the buffer only
+      // needs writing once per frame after the view changes.
+      m_cpu_object_transform.model_matrix                 = m_cpu_view_transform.data.model_matrix;
+      m_cpu_object_transform.model_view_projection_matrix = m_cpu_view_transform.data.model_view_projection_matrix;
+      uint32_t frame_bit = 1u << frame_index;
+      if ((m_view_transform_stale_frames & frame_bit) != 0) {
+        m_cpu_view_transform.Write(m_gpu_view_transforms[frame_index]->cpu_mapped_address);
+        m_view_transform_stale_frames &= ~frame_bit;
+      }
+    }
+    else {
+      // Each frame has its own buffer, so the write can't be skipped when
+      // nothing is dirty - this frame's buffer may still hold older values.
+      m_cpu_view_transform.Write(m_gpu_view_transforms[frame_index]->cpu_mapped_address);
+    }
   }
 
   // Lighting constant buffer
-  if (m_gpu_lighting_params != nullptr) {
-    m_cpu_lighting_params.Write(m_gpu_lighting_params->cpu_mapped_address);
+  if (!m_gpu_lighting_params.empty()) {
+    m_cpu_lighting_params.Write(m_gpu_lighting_params[frame_index]->cpu_mapped_address);
   }
 
   // Tess constant buffer
-  if (m_gpu_tess_params != nullptr) {
-    m_cpu_tess_params.Write(m_gpu_tess_params->cpu_mapped_address);
+  if (!m_gpu_tess_params.empty()) {
+    m_cpu_tess_params.Write(m_gpu_tess_params[frame_index]->cpu_mapped_address);
   }
 }
 
@@ -458,7 +575,9 @@ void EntityT<LightingParamsT, TessParamsT>::Draw(tr_cmd* p_cmd, uint32_t vertex_
 {
   tr_cmd_bind_pipeline(p_cmd, m_pipeline);
   
-  tr_cmd_bind_descriptor_sets(p_cmd, m_pipeline, m_descriptor_set);
+  tr_cmd_bind_descriptor_sets(p_cmd, m_pipeline, m_descriptor_sets[m_frame_index]);
+
+  PushObjectTransform(p_cmd);
   
   tr_cmd_bind_vertex_buffers(p_cmd, 
                              (uint32_t)m_vertex_buffers.size(),
@@ -468,9 +587,61 @@ void EntityT<LightingParamsT, TessParamsT>::Draw(tr_cmd* p_cmd, uint32_t vertex_
   tr_cmd_draw(p_cmd, vertex_count, 0);
 }
 
+/*! @fn EntityT<CpuLightingBufferT>::PushObjectTransform */
+template <typename LightingParamsT, typename TessParamsT>
+void EntityT<LightingParamsT, TessParamsT>::PushObjectTransform(tr_cmd* p_cmd) {
+  if (!m_create_info.push_object_transform) {
+    return;
+  }
+
+  tr_cmd_push_constants(p_cmd, m_pipeline, 0, sizeof(m_cpu_object_transform), &m_cpu_object_transform);
+}
+
+/*! @fn EntityT<CpuLightingBufferT>::BindIndexedGeometry */
+template <typename LightingParamsT, typename TessParamsT>
+void EntityT<LightingParamsT, TessParamsT>::BindIndexedGeometry(tr_cmd* p_cmd) {
+  assert(m_index_buffer != nullptr);
+
+  tr_cmd_bind_pipeline(p_cmd, m_pipeline);
+  
+  tr_cmd_bind_descriptor_sets(p_cmd, m_pipeline, m_descriptor_sets[m_frame_index]);
+
+  PushObjectTransform(p_cmd);
+  
+  tr_cmd_bind_index_buffer(p_cmd, m_index_buffer);
+
+  tr_cmd_bind_vertex_buffers(p_cmd, 
+                             (uint32_t)m_vertex_buffers.size(),
+                             m_vertex_buffers.data());
+}
+
 /*! @fn EntityT<CpuLightingBufferT>::DrawIndexed */
 template <typename LightingParamsT, typename TessParamsT>
 void EntityT<LightingParamsT, TessParamsT>::DrawIndexed(tr_cmd* p_cmd, uint32_t index_count) {
+  BindIndexedGeometry(p_cmd);
+
+  // Submeshes are packed back to back, so the full range draws all of them
+  index_count = (index_count == UINT32_MAX) ? m_index_count : index_count;
+  tr_cmd_draw_indexed(p_cmd, index_count, 0);
+}
+
+/*! @fn EntityT<CpuLightingBufferT>::DrawSubmeshes */
+template <typename LightingParamsT, typename TessParamsT>
+void EntityT<LightingParamsT, TessParamsT>::DrawSubmeshes(tr_cmd* p_cmd, uint32_t submesh_count, const uint32_t* p_submesh_indices) {
+  BindIndexedGeometry(p_cmd);
+
+  for (uint32_t i = 0; i < submesh_count; ++i) {
+    assert(p_submesh_indices[i] < m_submeshes.size());
+    const tr::Submesh& submesh = m_submeshes[p_submesh_indices[i]];
+    tr_cmd_draw_indexed(p_cmd, submesh.index_count, submesh.first_index);
+  }
+}
+
+/*! @fn EntityT<CpuLightingBufferT>::GetSubmeshes */
+template <typename LightingParamsT, typename TessParamsT>
+const std::vector<tr::Submesh>& EntityT<LightingParamsT, TessParamsT>::GetSubmeshes() const
+{
+  return m_submeshes;
 }
 
 // =================================================================================================
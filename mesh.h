@@ -12,9 +12,29 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/transform.hpp>
 
+#include <stdio.h>
 #include <string.h> 
+#include <algorithm>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#if defined(_WIN32)
+  // Pull in minimal Windows headers
+  #if ! defined(NOMINMAX)
+    #define NOMINMAX
+  #endif
+  #if ! defined(WIN32_LEAN_AND_MEAN)
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
 #ifndef TINYOBJLOADER_IMPLEMENTATION
   #define TINYOBJLOADER_IMPLEMENTATION
   #include <tiny_obj_loader.h>
@@ -46,10 +66,182 @@ struct Vertex {
   float3 position;
   float3 normal;
   float2 tex_coord;
+
+  bool operator==(const Vertex& rhs) const {
+    return memcmp(this, &rhs, sizeof(Vertex)) == 0;
+  }
+};
+
+// FNV-1a over the vertex bytes, Vertex has no padding so equal 
+// vertices always hash the same.
+struct VertexHash {
+  size_t operator()(const Vertex& vertex) const {
+    const uint8_t* p_bytes = reinterpret_cast<const uint8_t*>(&vertex);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(Vertex); ++i) {
+      hash ^= p_bytes[i];
+      hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+  }
+};
+
+// Average cache miss ratio (misses per triangle) and average transformed
+// vertex ratio (misses per vertex) for a FIFO post-transform cache.
+struct MeshCacheStats {
+  float acmr_before = 0.0f;
+  float atvr_before = 0.0f;
+  float acmr_after  = 0.0f;
+  float atvr_after  = 0.0f;
+};
+
+// What an optimized load did with the .trmesh cache
+enum MeshCacheStatus {
+  MESH_CACHE_STATUS_DISABLED = 0,
+  MESH_CACHE_STATUS_READ,
+  MESH_CACHE_STATUS_WRITTEN,
+  MESH_CACHE_STATUS_WRITE_FAILED,
+};
+
+// Read-only view of a whole file through the OS mapping, pages are only
+// touched when the data is read.
+class MappedFile {
+public:
+  MappedFile() {}
+  ~MappedFile() { Close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool Open(const std::string& file_path) {
+    Close();
+#if defined(_WIN32)
+    m_file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+    LARGE_INTEGER size = {};
+    if ((! GetFileSizeEx(m_file, &size)) || (size.QuadPart == 0)) {
+      Close();
+      return false;
+    }
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping == NULL) {
+      Close();
+      return false;
+    }
+    m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    m_size = (size_t)size.QuadPart;
+#else
+    m_fd = open(file_path.c_str(), O_RDONLY);
+    if (m_fd == -1) {
+      return false;
+    }
+    struct stat info = {};
+    if ((fstat(m_fd, &info) != 0) || (info.st_size == 0)) {
+      Close();
+      return false;
+    }
+    void* p_data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    m_data = (p_data != MAP_FAILED) ? p_data : nullptr;
+    m_size = (size_t)info.st_size;
+#endif
+    if (m_data == nullptr) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  void Close() {
+#if defined(_WIN32)
+    if (m_data != nullptr) {
+      UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != NULL) {
+      CloseHandle(m_mapping);
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+      CloseHandle(m_file);
+    }
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_data != nullptr) {
+      munmap(m_data, m_size);
+    }
+    if (m_fd != -1) {
+      close(m_fd);
+    }
+    m_fd = -1;
+#endif
+    m_data = nullptr;
+    m_size = 0;
+  }
+
+  const uint8_t* GetData() const {
+    return static_cast<const uint8_t*>(m_data);
+  }
+
+  size_t GetSize() const {
+    return m_size;
+  }
+
+private:
+#if defined(_WIN32)
+  HANDLE  m_file = INVALID_HANDLE_VALUE;
+  HANDLE  m_mapping = NULL;
+#else
+  int     m_fd = -1;
+#endif
+  void*   m_data = nullptr;
+  size_t  m_size = 0;
+};
+
+// Index range of one shape/material pair, all submeshes of a mesh share
+// its vertex and index buffers and are packed back to back.
+struct Submesh {
+  uint32_t  first_index;
+  uint32_t  index_count;
+  // Index into Mesh::GetMaterialNames(), -1 for faces without a material
+  int32_t   material_id;
+  uint32_t  shape_index;
+};
+
+// Layout of a .trmesh file: this header, then the vertex, index, submesh
+// and material name data each starting on a k_file_data_alignment 
+// boundary. Vertex and index data are already in the format the GPU 
+// buffers expect, material names are NUL terminated one after the other.
+struct MeshFileHeader {
+  uint32_t        magic;
+  uint32_t        version;
+  uint64_t        source_hash;
+  uint32_t        vertex_stride;
+  uint32_t        vertex_count;
+  uint32_t        index_stride;
+  uint32_t        index_count;
+  uint64_t        vertex_data_offset;
+  uint64_t        vertex_data_size;
+  uint64_t        index_data_offset;
+  uint64_t        index_data_size;
+  uint32_t        submesh_count;
+  uint32_t        material_count;
+  uint64_t        submesh_data_offset;
+  uint64_t        submesh_data_size;
+  uint64_t        material_data_offset;
+  uint64_t        material_data_size;
+  MeshCacheStats  cache_stats;
 };
 
 class Mesh {
 public:
+  // FIFO size used when none is given, conservative for current GPUs
+  static const uint32_t k_default_cache_size = 16;
+  // .trmesh identification, bump the version whenever Vertex or the layout changes
+  static const uint32_t k_file_magic = 0x48534D54; // 'TMSH'
+  static const uint32_t k_file_version = 2;
+  static const uint32_t k_file_data_alignment = 256;
+
   Mesh() {}
   ~Mesh() {}
 
@@ -92,6 +284,36 @@ public:
     return count;
   }
 
+  // 16-bit indices whenever every vertex can be addressed with them,
+  // 0xFFFF is left out since it's the primitive restart value.
+  tr_index_type GetIndexType() const {
+    tr_index_type index_type = (GetVertexCount() < 0xFFFF) ? tr_index_type_uint16 : tr_index_type_uint32;
+    return index_type;
+  }
+
+  uint32_t GetIndexStride() const {
+    uint32_t stride = (GetIndexType() == tr_index_type_uint16) ? (uint32_t)sizeof(uint16_t) : (uint32_t)sizeof(uint32_t);
+    return stride;
+  }
+
+  uint32_t GetIndexDataSize() const {
+    uint32_t size = GetIndexStride() * GetIndexCount();
+    return size;
+  }
+
+  // Writes GetIndexDataSize() bytes of indices in GetIndexType() format
+  void CopyIndexData(void* p_dst) const {
+    if (GetIndexType() == tr_index_type_uint16) {
+      uint16_t* p_dst_indices = static_cast<uint16_t*>(p_dst);
+      for (size_t i = 0; i < m_indices.size(); ++i) {
+        p_dst_indices[i] = (uint16_t)m_indices[i];
+      }
+    }
+    else {
+      memcpy(p_dst, m_indices.data(), GetIndexDataSize());
+    }
+  }
+
   uint32_t GetVertexStride() const {
     uint32_t stride = (uint32_t)sizeof(Vertex);
     return stride;
@@ -112,72 +334,684 @@ public:
     return p_data;
   }
 
-  static bool Load(const std::string& file_path, Mesh* p_mesh) {
+  float CalculateAcmr(uint32_t cache_size = k_default_cache_size) const {
+    uint32_t triangle_count = GetIndexCount() / 3;
+    float acmr = (triangle_count > 0) ? (float)CountCacheMisses(m_indices, GetVertexCount(), cache_size) / (float)triangle_count : 0.0f;
+    return acmr;
+  }
+
+  float CalculateAtvr(uint32_t cache_size = k_default_cache_size) const {
+    float atvr = (GetVertexCount() > 0) ? (float)CountCacheMisses(m_indices, GetVertexCount(), cache_size) / (float)GetVertexCount() : 0.0f;
+    return atvr;
+  }
+
+  const MeshCacheStats& GetCacheStats() const {
+    return m_cache_stats;
+  }
+
+  MeshCacheStatus GetCacheStatus() const {
+    return m_cache_status;
+  }
+
+  const std::vector<Submesh>& GetSubmeshes() const {
+    return m_submeshes;
+  }
+
+  const std::vector<std::string>& GetMaterialNames() const {
+    return m_material_names;
+  }
+
+  // Reorders triangles for the post-transform cache (Tipsify), orders the
+  // resulting clusters so outward facing ones draw first to cut overdraw, 
+  // then renumbers vertices in first use order for the pre-transform fetch.
+  const MeshCacheStats& Optimize(uint32_t cache_size = k_default_cache_size) {
+    m_cache_stats.acmr_before = CalculateAcmr(cache_size);
+    m_cache_stats.atvr_before = CalculateAtvr(cache_size);
+
+    // Triangles only move within their submesh so the ranges stay valid. 
+    // Tipsify works on the submesh's own vertex range so its per vertex 
+    // arrays don't scale with the whole mesh.
+    std::vector<uint32_t> source_indices = m_indices;
+    for (const Submesh& submesh : m_submeshes) {
+      if (submesh.index_count < 3) {
+        continue;
+      }
+      auto begin = m_indices.begin() + submesh.first_index;
+      auto end = begin + submesh.index_count;
+      auto range = std::minmax_element(begin, end);
+      uint32_t first_vertex = *range.first;
+      uint32_t vertex_count = *range.second - first_vertex + 1;
+      std::vector<uint32_t> indices(begin, end);
+      for (uint32_t& index : indices) {
+        index -= first_vertex;
+      }
+      std::vector<uint32_t> cluster_starts;
+      indices = Tipsify(indices, vertex_count, cache_size, &cluster_starts);
+      for (uint32_t& index : indices) {
+        index += first_vertex;
+      }
+      indices = SortClustersForOverdraw(indices, cluster_starts, m_vertices);
+      std::copy(indices.begin(), indices.end(), begin);
+    }
+
+    // Tipsify is a heuristic and the overdraw sort trades some locality, 
+    // keep the source order if the result misses the cache more often
+    if (CalculateAcmr(cache_size) > m_cache_stats.acmr_before) {
+      m_indices.swap(source_indices);
+    }
+
+    // Renumbering doesn't change which indices repeat, so ACMR is unaffected
+    if (GetIndexCount() >= 3) {
+      OptimizeVertexFetch();
+    }
+
+    m_cache_stats.acmr_after = CalculateAcmr(cache_size);
+    m_cache_stats.atvr_after = CalculateAtvr(cache_size);
+    assert(m_cache_stats.acmr_after <= m_cache_stats.acmr_before);
+    return m_cache_stats;
+  }
+
+  // The .trmesh cache is opt-in, nothing is written until a directory is
+  // set. An empty directory turns it back off.
+  static void SetCacheDirectory(const std::string& cache_dir) {
+    CacheDirectory() = cache_dir;
+  }
+
+  static const std::string& GetCacheDirectory() {
+    return CacheDirectory();
+  }
+
+  // .trmesh path in the cache directory, models/pieces1.obj -> <cache_dir>/pieces1.<path hash>.trmesh.
+  // The hash of the full source path keeps same named OBJs in different
+  // directories from sharing a cache file.
+  static std::string GetCacheFilePath(const std::string& cache_dir, const std::string& file_path) {
+    uint64_t path_hash = 14695981039346656037ULL;
+    for (char c : file_path) {
+      path_hash ^= static_cast<uint8_t>(c);
+      path_hash *= 1099511628211ULL;
+    }
+    char path_hash_str[17] = {};
+    snprintf(path_hash_str, sizeof(path_hash_str), "%016llx", static_cast<unsigned long long>(path_hash));
+
+    size_t slash = file_path.find_last_of("/\\");
+    std::string file_name = (slash != std::string::npos) ? file_path.substr(slash + 1) : file_path;
+    size_t dot = file_name.find_last_of('.');
+    std::string cache_file_path = cache_dir;
+    if (!cache_file_path.empty() && (cache_file_path.back() != '/') && (cache_file_path.back() != '\\')) {
+      cache_file_path += '/';
+    }
+    cache_file_path += ((dot != std::string::npos) ? file_name.substr(0, dot) : file_name) + "." + path_hash_str + ".trmesh";
+    return cache_file_path;
+  }
+
+  // With a cache directory set, optimized loads go through the .trmesh
+  // cache: it's used as long as its source hash matches the OBJ, otherwise
+  // the OBJ is parsed and the cache is rewritten. GetCacheStatus tells 
+  // whether that write failed, the mesh itself is loaded either way.
+  static bool Load(const std::string& file_path, Mesh* p_mesh, bool optimize = true) {
     if (p_mesh == nullptr) {
       return false;
     }
 
+    p_mesh->m_cache_status = MESH_CACHE_STATUS_DISABLED;
+    const std::string& cache_dir = GetCacheDirectory();
+    uint64_t source_hash = 0;
+    bool use_cache = optimize && !cache_dir.empty() && HashFile(file_path, &source_hash);
+    if (use_cache) {
+      MappedFile cache_file;
+      const MeshFileHeader* p_header = cache_file.Open(GetCacheFilePath(cache_dir, file_path)) ? ValidateCacheFile(cache_file, source_hash) : nullptr;
+      if (p_header != nullptr) {
+        p_mesh->ReadCacheFile(cache_file);
+        p_mesh->m_cache_status = MESH_CACHE_STATUS_READ;
+        return true;
+      }
+    }
+
+    if (! LoadObj(file_path, p_mesh)) {
+      return false;
+    }
+
+    if (optimize) {
+      p_mesh->Optimize();
+    }
+
+    if (use_cache) {
+      bool written = p_mesh->WriteCacheFile(GetCacheFilePath(cache_dir, file_path), source_hash);
+      p_mesh->m_cache_status = written ? MESH_CACHE_STATUS_WRITTEN : MESH_CACHE_STATUS_WRITE_FAILED;
+    }
+
+    return true;
+  }
+
+  // Writes the mesh as a .trmesh, written to a temporary file first so a
+  // partially written cache never gets picked up.
+  bool WriteCacheFile(const std::string& cache_file_path, uint64_t source_hash) const {
+    MeshFileHeader header = {};
+    header.magic                = k_file_magic;
+    header.version              = k_file_version;
+    header.source_hash          = source_hash;
+    header.vertex_stride        = GetVertexStride();
+    header.vertex_count         = GetVertexCount();
+    header.index_stride         = GetIndexStride();
+    header.index_count          = GetIndexCount();
+    header.vertex_data_offset   = AlignFileOffset(sizeof(MeshFileHeader));
+    header.vertex_data_size     = GetVertexDataSize();
+    header.index_data_offset    = AlignFileOffset(header.vertex_data_offset + header.vertex_data_size);
+    header.index_data_size      = GetIndexDataSize();
+    header.submesh_count        = (uint32_t)m_submeshes.size();
+    header.material_count       = (uint32_t)m_material_names.size();
+    header.submesh_data_offset  = AlignFileOffset(header.index_data_offset + header.index_data_size);
+    header.submesh_data_size    = m_submeshes.size() * sizeof(Submesh);
+    header.material_data_offset = AlignFileOffset(header.submesh_data_offset + header.submesh_data_size);
+    header.cache_stats          = m_cache_stats;
+    for (const auto& name : m_material_names) {
+      header.material_data_size += name.size() + 1;
+    }
+
+    std::vector<uint8_t> data((size_t)(header.material_data_offset + header.material_data_size), 0);
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + header.vertex_data_offset, GetVertexData(), (size_t)header.vertex_data_size);
+    CopyIndexData(data.data() + header.index_data_offset);
+    if (! m_submeshes.empty()) {
+      memcpy(data.data() + header.submesh_data_offset, m_submeshes.data(), (size_t)header.submesh_data_size);
+    }
+    uint8_t* p_material_data = data.data() + header.material_data_offset;
+    for (const auto& name : m_material_names) {
+      memcpy(p_material_data, name.c_str(), name.size() + 1);
+      p_material_data += name.size() + 1;
+    }
+
+    std::string tmp_file_path = cache_file_path + ".tmp";
+    FILE* fp = fopen(tmp_file_path.c_str(), "wb");
+    if (fp == nullptr) {
+      return false;
+    }
+    size_t written = fwrite(data.data(), 1, data.size(), fp);
+    fclose(fp);
+    if (written != data.size()) {
+      remove(tmp_file_path.c_str());
+      return false;
+    }
+    remove(cache_file_path.c_str());
+    return 0 == rename(tmp_file_path.c_str(), cache_file_path.c_str());
+  }
+
+  // Non-indexed, every face corner gets its own vertex
+  static bool Load(const std::string& file_path, tr_renderer* p_renderer, tr_buffer** pp_buffer, uint32_t* p_vertex_count, MeshCacheStatus* p_cache_status = nullptr) {
+    tr::Mesh mesh;
+    bool mesh_load_res = tr::Mesh::Load(file_path, &mesh);
+    if (p_cache_status != nullptr) {
+      *p_cache_status = mesh.GetCacheStatus();
+    }
+    if (!mesh_load_res) {
+      return false;
+    }
+
+    uint32_t vertex_count = mesh.GetIndexCount();
+    tr_buffer* p_buffer = nullptr;
+    tr_create_vertex_buffer(p_renderer, vertex_count * mesh.GetVertexStride(), true, mesh.GetVertexStride(), &p_buffer);
+    assert(p_buffer != nullptr);
+
+    Vertex* p_dst = static_cast<Vertex*>(p_buffer->cpu_mapped_address);
+    for (uint32_t index : mesh.GetIndices()) {
+      *p_dst = mesh.GetVertices()[index];
+      ++p_dst;
+    }
+
+    *pp_buffer = p_buffer;
+    *p_vertex_count = vertex_count;
+    return true;    
+  }
+
+  // A current .trmesh is copied from the mapping straight into the buffers,
+  // the OBJ is only parsed when the cache is missing or stale. 
+  // p_submeshes is optional and receives the ranges of every shape/material.
+  static bool Load(const std::string& file_path, tr_renderer* p_renderer, tr_buffer** pp_vertex_buffer, uint32_t* p_vertex_count, tr_buffer** pp_index_buffer, uint32_t* p_index_count, std::vector<Submesh>* p_submeshes = nullptr, MeshCacheStatus* p_cache_status = nullptr) {
+    const std::string& cache_dir = GetCacheDirectory();
+    uint64_t source_hash = 0;
+    if (!cache_dir.empty() && HashFile(file_path, &source_hash)) {
+      MappedFile cache_file;
+      const MeshFileHeader* p_header = cache_file.Open(GetCacheFilePath(cache_dir, file_path)) ? ValidateCacheFile(cache_file, source_hash) : nullptr;
+      if (p_header != nullptr) {
+        tr_index_type index_type = (p_header->index_stride == sizeof(uint16_t)) ? tr_index_type_uint16 : tr_index_type_uint32;
+
+        tr_buffer* p_vertex_buffer = nullptr;
+        tr_create_vertex_buffer(p_renderer, p_header->vertex_data_size, true, p_header->vertex_stride, &p_vertex_buffer);
+        assert(p_vertex_buffer != nullptr);
+        memcpy(p_vertex_buffer->cpu_mapped_address, cache_file.GetData() + p_header->vertex_data_offset, (size_t)p_header->vertex_data_size);
+
+        tr_buffer* p_index_buffer = nullptr;
+        tr_create_index_buffer(p_renderer, p_header->index_data_size, true, index_type, &p_index_buffer);
+        assert(p_index_buffer != nullptr);
+        memcpy(p_index_buffer->cpu_mapped_address, cache_file.GetData() + p_header->index_data_offset, (size_t)p_header->index_data_size);
+
+        *pp_vertex_buffer = p_vertex_buffer;
+        *p_vertex_count = p_header->vertex_count;
+        *pp_index_buffer = p_index_buffer;
+        *p_index_count = p_header->index_count;
+        if (p_submeshes != nullptr) {
+          const Submesh* p_src_submeshes = reinterpret_cast<const Submesh*>(cache_file.GetData() + p_header->submesh_data_offset);
+          p_submeshes->assign(p_src_submeshes, p_src_submeshes + p_header->submesh_count);
+        }
+        if (p_cache_status != nullptr) {
+          *p_cache_status = MESH_CACHE_STATUS_READ;
+        }
+        return true;
+      }
+    }
+
+    tr::Mesh mesh;
+    bool mesh_load_res = tr::Mesh::Load(file_path, &mesh);
+    if (p_cache_status != nullptr) {
+      *p_cache_status = mesh.GetCacheStatus();
+    }
+    if (!mesh_load_res) {
+      return false;
+    }
+
+    tr_buffer* p_vertex_buffer = nullptr;
+    tr_create_vertex_buffer(p_renderer, mesh.GetVertexDataSize(), true, mesh.GetVertexStride(), &p_vertex_buffer);
+    assert(p_vertex_buffer != nullptr);
+
+    memcpy(p_vertex_buffer->cpu_mapped_address, mesh.GetVertexData(), mesh.GetVertexDataSize());
+
+    tr_buffer* p_index_buffer = nullptr;
+    tr_create_index_buffer(p_renderer, mesh.GetIndexDataSize(), true, mesh.GetIndexType(), &p_index_buffer);
+    assert(p_index_buffer != nullptr);
+
+    mesh.CopyIndexData(p_index_buffer->cpu_mapped_address);
+
+    *pp_vertex_buffer = p_vertex_buffer;
+    *p_vertex_count = mesh.GetVertexCount();
+    *pp_index_buffer = p_index_buffer;
+    *p_index_count = mesh.GetIndexCount();
+    if (p_submeshes != nullptr) {
+      *p_submeshes = mesh.GetSubmeshes();
+    }
+    return true;    
+  }
+
+private:
+  static std::string& CacheDirectory() {
+    static std::string s_cache_dir;
+    return s_cache_dir;
+  }
+
+  static bool LoadObj(const std::string& file_path, Mesh* p_mesh) {
     p_mesh->m_indices.clear();
     p_mesh->m_vertices.clear();
+    p_mesh->m_submeshes.clear();
+    p_mesh->m_material_names.clear();
+    p_mesh->m_cache_stats = MeshCacheStats();
     
+    // mtllib paths are relative to the OBJ
+    size_t slash = file_path.find_last_of("/\\");
+    std::string base_dir = (slash != std::string::npos) ? file_path.substr(0, slash + 1) : std::string();
+
     tinyobj::attrib_t                 attrib;
     std::vector<tinyobj::shape_t>     shapes;
     std::vector<tinyobj::material_t>  materials;
     std::string                       warn;
     std::string                       err;
     bool                              triangulate = true;
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, file_path.c_str(), nullptr, triangulate);
+    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, file_path.c_str(), base_dir.empty() ? nullptr : base_dir.c_str(), triangulate);
     if (!ret || shapes.empty() || attrib.vertices.empty()) {
       return false;
     }
 
-    size_t element_count = shapes[0].mesh.indices.size(); 
-    p_mesh->m_vertices.resize(element_count);
-
-    Vertex* p_vertex = p_mesh->m_vertices.data();
-    for (const auto& index : shapes[0].mesh.indices) {
-      // Position
-      size_t vertex_index = 3 * index.vertex_index;
-      p_vertex->position.x = attrib.vertices[vertex_index + 0];
-      p_vertex->position.y = attrib.vertices[vertex_index + 1];
-      p_vertex->position.z = attrib.vertices[vertex_index + 2];
-      // Normal
-      size_t normal_index = 3 * index.normal_index;
-      p_vertex->normal.x = attrib.normals.empty() ? 0.0f : attrib.normals[normal_index + 0];
-      p_vertex->normal.y = attrib.normals.empty() ? 0.0f : attrib.normals[normal_index + 1];
-      p_vertex->normal.z = attrib.normals.empty() ? 0.0f : attrib.normals[normal_index + 2];
-      // Tex coord
-      size_t tex_coord_index = 2 * index.texcoord_index;
-      p_vertex->tex_coord.x = attrib.texcoords.empty() ? 0.0f : attrib.texcoords[tex_coord_index  + 0];
-      p_vertex->tex_coord.y = attrib.texcoords.empty() ? 0.0f : attrib.texcoords[tex_coord_index  + 1];
-      // Next vertex
-      ++p_vertex;
-    }
- 
+    for (const auto& material : materials) {
+      p_mesh->m_material_names.push_back(material.name);
+    }
+
+    size_t element_count = 0;
+    for (const auto& shape : shapes) {
+      element_count += shape.mesh.indices.size();
+    }
+    p_mesh->m_indices.reserve(element_count);
+
+    // Face corners that end up with identical attributes share a vertex,
+    // across shapes too since they all go into one buffer.
+    std::unordered_map<Vertex, uint32_t, VertexHash> unique_vertices;
+    unique_vertices.reserve(element_count);
+
+    for (uint32_t shape_index = 0; shape_index < (uint32_t)shapes.size(); ++shape_index) {
+      const tinyobj::mesh_t& shape_mesh = shapes[shape_index].mesh;
+      const uint32_t face_count = (uint32_t)shape_mesh.indices.size() / 3;
+
+      // Shapes can switch material mid way, faces are grouped per material
+      // so every shape/material pair ends up as one contiguous range.
+      std::vector<int32_t> shape_material_ids;
+      for (uint32_t face = 0; face < face_count; ++face) {
+        int32_t material_id = (face < shape_mesh.material_ids.size()) ? (int32_t)shape_mesh.material_ids[face] : -1;
+        if (std::find(shape_material_ids.begin(), shape_material_ids.end(), material_id) == shape_material_ids.end()) {
+          shape_material_ids.push_back(material_id);
+        }
+      }
+
+      for (int32_t material_id : shape_material_ids) {
+        Submesh submesh = {};
+        submesh.first_index = (uint32_t)p_mesh->m_indices.size();
+        submesh.material_id = material_id;
+        submesh.shape_index = shape_index;
+
+        for (uint32_t face = 0; face < face_count; ++face) {
+          int32_t face_material_id = (face < shape_mesh.material_ids.size()) ? (int32_t)shape_mesh.material_ids[face] : -1;
+          if (face_material_id != material_id) {
+            continue;
+          }
+
+          for (uint32_t corner = 0; corner < 3; ++corner) {
+            const tinyobj::index_t& index = shape_mesh.indices[3 * face + corner];
+            Vertex vertex = {};
+            // Position
+            size_t vertex_index = 3 * index.vertex_index;
+            vertex.position.x = attrib.vertices[vertex_index + 0];
+            vertex.position.y = attrib.vertices[vertex_index + 1];
+            vertex.position.z = attrib.vertices[vertex_index + 2];
+            // Normal
+            size_t normal_index = 3 * index.normal_index;
+            vertex.normal.x = attrib.normals.empty() ? 0.0f : attrib.normals[normal_index + 0];
+            vertex.normal.y = attrib.normals.empty() ? 0.0f : attrib.normals[normal_index + 1];
+            vertex.normal.z = attrib.normals.empty() ? 0.0f : attrib.normals[normal_index + 2];
+            // Tex coord
+            size_t tex_coord_index = 2 * index.texcoord_index;
+            vertex.tex_coord.x = attrib.texcoords.empty() ? 0.0f : attrib.texcoords[tex_coord_index  + 0];
+            vertex.tex_coord.y = attrib.texcoords.empty() ? 0.0f : attrib.texcoords[tex_coord_index  + 1];
+            // Weld
+            auto it = unique_vertices.find(vertex);
+            if (it == unique_vertices.end()) {
+              uint32_t new_index = (uint32_t)p_mesh->m_vertices.size();
+              it = unique_vertices.emplace(vertex, new_index).first;
+              p_mesh->m_vertices.push_back(vertex);
+            }
+            p_mesh->m_indices.push_back(it->second);
+          }
+        }
+
+        submesh.index_count = (uint32_t)p_mesh->m_indices.size() - submesh.first_index;
+        p_mesh->m_submeshes.push_back(submesh);
+      }
+    }
+
     return true;
   }
 
-  static bool Load(const std::string& file_path, tr_renderer* p_renderer, tr_buffer** pp_buffer, uint32_t* p_vertex_count) {
-    tr::Mesh mesh;
-    bool mesh_load_res = tr::Mesh::Load(file_path, &mesh);
-    if (!mesh_load_res) {
+  static uint64_t AlignFileOffset(uint64_t offset) {
+    uint64_t aligned = (offset + k_file_data_alignment - 1) & ~((uint64_t)k_file_data_alignment - 1);
+    return aligned;
+  }
+
+  // FNV-1a over the source file contents
+  static bool HashFile(const std::string& file_path, uint64_t* p_hash) {
+    MappedFile file;
+    if (! file.Open(file_path)) {
       return false;
     }
+    const uint8_t* p_bytes = file.GetData();
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < file.GetSize(); ++i) {
+      hash ^= p_bytes[i];
+      hash *= 1099511628211ULL;
+    }
+    *p_hash = hash;
+    return true;
+  }
 
-    tr_buffer* p_buffer = nullptr;
-    tr_create_vertex_buffer(p_renderer, mesh.GetVertexDataSize(), true, mesh.GetVertexStride(), &p_buffer);
-    assert(p_buffer != nullptr);
+  // Returns the header if the file is a current .trmesh for source_hash and 
+  // all of its data lies inside the file, nullptr otherwise.
+  static const MeshFileHeader* ValidateCacheFile(const MappedFile& file, uint64_t source_hash) {
+    if (file.GetSize() < sizeof(MeshFileHeader)) {
+      return nullptr;
+    }
+    const MeshFileHeader* p_header = reinterpret_cast<const MeshFileHeader*>(file.GetData());
+    bool valid = (p_header->magic == k_file_magic) &&
+                 (p_header->version == k_file_version) &&
+                 (p_header->source_hash == source_hash) &&
+                 (p_header->vertex_stride == sizeof(Vertex)) &&
+                 ((p_header->index_stride == sizeof(uint16_t)) || (p_header->index_stride == sizeof(uint32_t))) &&
+                 (p_header->vertex_data_size == (uint64_t)p_header->vertex_stride * p_header->vertex_count) &&
+                 (p_header->index_data_size == (uint64_t)p_header->index_stride * p_header->index_count) &&
+                 (p_header->vertex_data_offset <= file.GetSize()) &&
+                 (p_header->vertex_data_size <= file.GetSize() - p_header->vertex_data_offset) &&
+                 (p_header->index_data_offset <= file.GetSize()) &&
+                 (p_header->index_data_size <= file.GetSize() - p_header->index_data_offset) &&
+                 (p_header->submesh_data_size == (uint64_t)sizeof(Submesh) * p_header->submesh_count) &&
+                 (p_header->submesh_data_offset <= file.GetSize()) &&
+                 (p_header->submesh_data_size <= file.GetSize() - p_header->submesh_data_offset) &&
+                 (p_header->material_data_offset <= file.GetSize()) &&
+                 (p_header->material_data_size <= file.GetSize() - p_header->material_data_offset);
+    // Material names must all be terminated inside their blob
+    if (valid) {
+      const uint8_t* p_material_data = file.GetData() + p_header->material_data_offset;
+      uint64_t terminator_count = (uint64_t)std::count(p_material_data, p_material_data + p_header->material_data_size, 0);
+      valid = (terminator_count == p_header->material_count) && 
+              ((p_header->material_data_size == 0) || (p_material_data[p_header->material_data_size - 1] == 0));
+    }
+    return valid ? p_header : nullptr;
+  }
 
-    memcpy(p_buffer->cpu_mapped_address, mesh.GetVertexData(), mesh.GetVertexDataSize());
+  // Expects a file that passed ValidateCacheFile
+  void ReadCacheFile(const MappedFile& file) {
+    const MeshFileHeader* p_header = reinterpret_cast<const MeshFileHeader*>(file.GetData());
+    m_vertices.resize(p_header->vertex_count);
+    memcpy(m_vertices.data(), file.GetData() + p_header->vertex_data_offset, (size_t)p_header->vertex_data_size);
+    m_indices.resize(p_header->index_count);
+    if (p_header->index_stride == sizeof(uint16_t)) {
+      const uint16_t* p_src_indices = reinterpret_cast<const uint16_t*>(file.GetData() + p_header->index_data_offset);
+      for (uint32_t i = 0; i < p_header->index_count; ++i) {
+        m_indices[i] = p_src_indices[i];
+      }
+    }
+    else {
+      memcpy(m_indices.data(), file.GetData() + p_header->index_data_offset, (size_t)p_header->index_data_size);
+    }
+    const Submesh* p_src_submeshes = reinterpret_cast<const Submesh*>(file.GetData() + p_header->submesh_data_offset);
+    m_submeshes.assign(p_src_submeshes, p_src_submeshes + p_header->submesh_count);
+    m_material_names.clear();
+    const char* p_material_name = reinterpret_cast<const char*>(file.GetData() + p_header->material_data_offset);
+    for (uint32_t i = 0; i < p_header->material_count; ++i) {
+      m_material_names.push_back(p_material_name);
+      p_material_name += m_material_names.back().size() + 1;
+    }
+    m_cache_stats = p_header->cache_stats;
+  }
 
-    *pp_buffer = p_buffer;
-    *p_vertex_count = mesh.GetVertexCount();
-    return true;    
+  static uint32_t CountCacheMisses(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size) {
+    // A vertex is in the FIFO if fewer than cache_size misses happened since it was inserted
+    std::vector<uint32_t> insert_time(vertex_count, UINT32_MAX);
+    uint32_t miss_count = 0;
+    for (uint32_t index : indices) {
+      uint32_t time = insert_time[index];
+      if ((time == UINT32_MAX) || ((miss_count - time) >= cache_size)) {
+        insert_time[index] = miss_count;
+        ++miss_count;
+      }
+    }
+    return miss_count;
+  }
+
+  // Sander, Nehab, Barczak - Fast Triangle Reordering for Vertex Locality and Reduced Overdraw
+  static std::vector<uint32_t> Tipsify(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size, std::vector<uint32_t>* p_cluster_starts) {
+    const uint32_t triangle_count = (uint32_t)indices.size() / 3;
+
+    // Vertex to triangle adjacency
+    std::vector<uint32_t> live_count(vertex_count, 0);
+    for (uint32_t index : indices) {
+      ++live_count[index];
+    }
+    std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+    for (uint32_t v = 0; v < vertex_count; ++v) {
+      adjacency_offsets[v + 1] = adjacency_offsets[v] + live_count[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+      std::vector<uint32_t> cursor(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+      for (uint32_t i = 0; i < (uint32_t)indices.size(); ++i) {
+        adjacency[cursor[indices[i]]++] = i / 3;
+      }
+    }
+
+    std::vector<uint32_t> cache_time(vertex_count, 0);
+    std::vector<bool>     emitted(triangle_count, false);
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t time = cache_size + 1;
+    uint32_t scan_cursor = 0;
+    uint32_t fan_vertex = 0;
+    p_cluster_starts->push_back(0);
+    while (fan_vertex != UINT32_MAX) {
+      candidates.clear();
+      for (uint32_t a = adjacency_offsets[fan_vertex]; a < adjacency_offsets[fan_vertex + 1]; ++a) {
+        uint32_t t = adjacency[a];
+        if (emitted[t]) {
+          continue;
+        }
+        for (uint32_t k = 0; k < 3; ++k) {
+          uint32_t v = indices[3 * t + k];
+          output.push_back(v);
+          dead_end.push_back(v);
+          candidates.push_back(v);
+          --live_count[v];
+          if ((time - cache_time[v]) > cache_size) {
+            cache_time[v] = time;
+            ++time;
+          }
+        }
+        emitted[t] = true;
+      }
+
+      // Next fanning vertex: the candidate that stays in the cache the longest
+      // while still having live triangles.
+      uint32_t next_vertex = UINT32_MAX;
+      int32_t best_priority = -1;
+      for (uint32_t v : candidates) {
+        if (live_count[v] == 0) {
+          continue;
+        }
+        int32_t priority = 0;
+        if ((time - cache_time[v] + 2 * live_count[v]) <= cache_size) {
+          priority = (int32_t)(time - cache_time[v]);
+        }
+        if (priority > best_priority) {
+          best_priority = priority;
+          next_vertex = v;
+        }
+      }
+
+      // Dead end: pop recently used vertices, then fall back to a linear scan.
+      // Locality is lost here so it also starts a new cluster.
+      if (next_vertex == UINT32_MAX) {
+        while (!dead_end.empty() && (next_vertex == UINT32_MAX)) {
+          uint32_t v = dead_end.back();
+          dead_end.pop_back();
+          if (live_count[v] > 0) {
+            next_vertex = v;
+          }
+        }
+        while ((next_vertex == UINT32_MAX) && (scan_cursor < vertex_count)) {
+          if (live_count[scan_cursor] > 0) {
+            next_vertex = scan_cursor;
+          }
+          ++scan_cursor;
+        }
+        if ((next_vertex != UINT32_MAX) && (output.size() > p_cluster_starts->back())) {
+          p_cluster_starts->push_back((uint32_t)output.size());
+        }
+      }
+
+      fan_vertex = next_vertex;
+    }
+
+    return output;
+  }
+
+  // Clusters whose surface points away from the mesh center are likely to occlude 
+  // the rest, drawing them first lets early depth reject more fragments.
+  static std::vector<uint32_t> SortClustersForOverdraw(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& cluster_starts, const std::vector<Vertex>& vertices) {
+    const uint32_t cluster_count = (uint32_t)cluster_starts.size();
+    if (cluster_count <= 1) {
+      return indices;
+    }
+
+    float3 mesh_centroid = float3(0.0f);
+    float  mesh_area = 0.0f;
+    std::vector<float3> cluster_centroids(cluster_count, float3(0.0f));
+    std::vector<float3> cluster_normals(cluster_count, float3(0.0f));
+    std::vector<float>  cluster_areas(cluster_count, 0.0f);
+    for (uint32_t c = 0; c < cluster_count; ++c) {
+      uint32_t begin = cluster_starts[c];
+      uint32_t end = (c + 1 < cluster_count) ? cluster_starts[c + 1] : (uint32_t)indices.size();
+      for (uint32_t i = begin; i < end; i += 3) {
+        const float3& p0 = vertices[indices[i + 0]].position;
+        const float3& p1 = vertices[indices[i + 1]].position;
+        const float3& p2 = vertices[indices[i + 2]].position;
+        float3 normal = glm::cross(p1 - p0, p2 - p0);
+        float  area = 0.5f * glm::length(normal);
+        float3 centroid = (p0 + p1 + p2) / 3.0f;
+        cluster_centroids[c] += area * centroid;
+        cluster_normals[c] += normal;
+        cluster_areas[c] += area;
+      }
+      mesh_centroid += cluster_centroids[c];
+      mesh_area += cluster_areas[c];
+    }
+    mesh_centroid = (mesh_area > 0.0f) ? (mesh_centroid / mesh_area) : mesh_centroid;
+
+    std::vector<float> occlusion(cluster_count, 0.0f);
+    for (uint32_t c = 0; c < cluster_count; ++c) {
+      if (cluster_areas[c] <= 0.0f) {
+        continue;
+      }
+      float3 centroid = cluster_centroids[c] / cluster_areas[c];
+      float  normal_length = glm::length(cluster_normals[c]);
+      float3 normal = (normal_length > 0.0f) ? (cluster_normals[c] / normal_length) : float3(0.0f);
+      occlusion[c] = glm::dot(centroid - mesh_centroid, normal);
+    }
+
+    std::vector<uint32_t> order(cluster_count);
+    for (uint32_t c = 0; c < cluster_count; ++c) {
+      order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&occlusion](uint32_t a, uint32_t b) -> bool
+                         { return occlusion[a] > occlusion[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : order) {
+      uint32_t begin = cluster_starts[c];
+      uint32_t end = (c + 1 < cluster_count) ? cluster_starts[c + 1] : (uint32_t)indices.size();
+      output.insert(output.end(), indices.begin() + begin, indices.begin() + end);
+    }
+    return output;
+  }
+
+  // Vertices are renumbered in the order the index buffer first touches them, 
+  // unreferenced vertices are dropped.
+  void OptimizeVertexFetch() {
+    std::vector<uint32_t> remap(m_vertices.size(), UINT32_MAX);
+    std::vector<Vertex> vertices;
+    vertices.reserve(m_vertices.size());
+    for (uint32_t& index : m_indices) {
+      if (remap[index] == UINT32_MAX) {
+        remap[index] = (uint32_t)vertices.size();
+        vertices.push_back(m_vertices[index]);
+      }
+      index = remap[index];
+    }
+    m_vertices.swap(vertices);
   }
 
 private:
-  std::vector<uint32_t> m_indices;
-  std::vector<Vertex>   m_vertices;
+  std::vector<uint32_t>     m_indices;
+  std::vector<Vertex>       m_vertices;
+  std::vector<Submesh>      m_submeshes;
+  std::vector<std::string>  m_material_names;
+  MeshCacheStats            m_cache_stats;
+  MeshCacheStatus           m_cache_status = MESH_CACHE_STATUS_DISABLED;
 };
 
 } // namespace mesh
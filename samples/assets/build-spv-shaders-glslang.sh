@@ -81,6 +81,12 @@ function compile_cs() {
   entry=$2
   filename=$(basename $filepath .hlsl)
   output_filename=$filename.cs.spv
+  stage=cs
+  # Files with several kernels get one output per entry point
+  if [ "$3" = "per_entry" ]; then
+    output_filename=$filename.$entry.cs.spv
+    stage=cs.$entry
+  fi
 
   build=false
   if [ ! -f $output_filename ]; then
@@ -88,7 +94,7 @@ function compile_cs() {
   fi
 
   if [ "$build" = false ]; then
-    changed=$(has_file_changed $filepath cs)
+    changed=$(has_file_changed $filepath $stage)
     if [ $changed -eq 0 ]; then
       echo "Skipping $filepath no changes detected"
       return
@@ -99,7 +105,8 @@ function compile_cs() {
   echo ""
   echo "Compiling $filepath"
 
-  cmd="$glslang -D -V -S comp -e $entry --hlsl-iomap --auto-map-bindings --hlsl-offsets -o $output_filename $filepath"
+  # dxc -spirv defines __spirv__, glslang has to be told
+  cmd="$glslang -D -V -S comp -e $entry -D__spirv__ --hlsl-iomap --auto-map-bindings --hlsl-offsets -o $output_filename $filepath"
   echo $cmd
   $cmd
 
@@ -208,6 +215,8 @@ compile_cs append_consume.hlsl main
 compile_cs byte_address_buffer.hlsl main
 compile_cs simple_compute.hlsl main
 compile_cs structured_buffer.hlsl main
+compile_cs compute_blur.hlsl hblur_main per_entry
+compile_cs compute_blur.hlsl vblur_main per_entry
 
 compile_vs_ps simple.hlsl VSMain PSMain
 compile_vs_ps color.hlsl VSMain PSMain
@@ -82,6 +82,12 @@ function compile_cs() {
   entry=$2
   filename=$(basename $filepath .hlsl)
   output_filename=$filename.cs.spv
+  stage=cs
+  # Files with several kernels get one output per entry point
+  if [ "$3" = "per_entry" ]; then
+    output_filename=$filename.$entry.cs.spv
+    stage=cs.$entry
+  fi
 
   build=false
   if [ ! -f $output_filename ]; then
@@ -89,7 +95,7 @@ function compile_cs() {
   fi
 
   if [ "$build" = false ]; then
-    changed=$(has_file_changed $filepath cs)
+    changed=$(has_file_changed $filepath $stage)
     if [ $changed -eq 0 ]; then
       echo "Skipping $filepath no changes detected"
       return
@@ -209,6 +215,8 @@ compile_cs append_consume.hlsl main
 compile_cs byte_address_buffer.hlsl main
 compile_cs simple_compute.hlsl main
 compile_cs structured_buffer.hlsl main
+compile_cs compute_blur.hlsl hblur_main per_entry
+compile_cs compute_blur.hlsl vblur_main per_entry
 
 compile_vs_ps simple.hlsl VSMain PSMain
 compile_vs_ps color.hlsl VSMain PSMain
@@ -23,6 +23,14 @@ static const float k_sample_weights[KERNEL_SIZE] = {
   0.002216,
 };
 
+// Vulkan pipelines can shrink the kernel with specialization constant 0,
+// up to HALF_KERNEL_SIZE. D3D12 always uses the full kernel.
+#if defined(__spirv__)
+[[vk::constant_id(0)]] const int k_half_kernel_size = HALF_KERNEL_SIZE;
+#else
+static const int k_half_kernel_size = HALF_KERNEL_SIZE;
+#endif
+
 Texture2D<float4>   BufferIn  : register(t0);
 RWTexture2D<float4> BufferOut : register(u1);
 
@@ -40,13 +48,17 @@ void hblur_main(uint3 gid : SV_GroupID, uint gindex : SV_GroupIndex)
   GroupMemoryBarrierWithGroupSync();
 
   float4 value = 0;
-  for (int i = -HALF_KERNEL_SIZE; i < HALF_KERNEL_SIZE; ++i) {
+  float weight_sum = 0;
+  for (int i = -k_half_kernel_size; i < k_half_kernel_size; ++i) {
     int index = gindex + i;
     if (index >= 0 && index < NUM_THREADS_X) {
-      value += g_shared_input[index] * k_sample_weights[i + HALF_KERNEL_SIZE];
+      float weight = k_sample_weights[i + HALF_KERNEL_SIZE];
+      value += g_shared_input[index] * weight;
+      weight_sum += weight;
     }    
   }
-  BufferOut[coord] = value;
+  // Keeps brightness when the kernel is shrunk
+  BufferOut[coord] = value / weight_sum;
 }
 
 //! @fn vblur_main
@@ -61,11 +73,15 @@ void vblur_main(uint3 gid : SV_GroupID, uint gindex : SV_GroupIndex)
   GroupMemoryBarrierWithGroupSync();
 
   float4 value = 0;
-  for (int i = -HALF_KERNEL_SIZE; i < HALF_KERNEL_SIZE; ++i) {
+  float weight_sum = 0;
+  for (int i = -k_half_kernel_size; i < k_half_kernel_size; ++i) {
     int index = gindex + i;
     if (index >= 0 && index < NUM_THREADS_X) {
-      value += g_shared_input[index] * k_sample_weights[i + HALF_KERNEL_SIZE];
+      float weight = k_sample_weights[i + HALF_KERNEL_SIZE];
+      value += g_shared_input[index] * weight;
+      weight_sum += weight;
     }    
   }
-  BufferOut[coord] = value;
+  // Keeps brightness when the kernel is shrunk
+  BufferOut[coord] = value / weight_sum;
 }
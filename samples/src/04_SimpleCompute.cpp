@@ -10,6 +10,7 @@
 #include "GLFW/glfw3native.h"
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -26,6 +27,8 @@
 
 const char*         k_app_name = "04_SimpleCompute";
 const uint32_t      k_image_count = 3;
+const uint32_t      k_frame_count = 2;
+const uint32_t      k_headless_frame_count = k_image_count;
 #if defined(TINY_RENDERER_GGP)
 const std::string   k_asset_dir = "./samples/assets/";
 #elif defined(TINY_RENDERER_LINUX)
@@ -48,8 +51,7 @@ const uint32_t k_window_height = 480;
 tr_renderer*        m_renderer = nullptr;
 tr_descriptor_set*  m_desc_set = nullptr;
 tr_descriptor_set*  m_compute_desc_set = nullptr;
-tr_cmd_pool*        m_cmd_pool = nullptr;
-tr_cmd**            m_cmds = nullptr;
+tr_frame_context*   m_frame_context = nullptr;
 tr_shader_program*  m_compute_shader = nullptr;
 tr_shader_program*  m_texture_shader = nullptr;
 tr_buffer*          m_rect_index_buffer = nullptr;
@@ -62,7 +64,6 @@ tr_sampler*         m_sampler = nullptr;
 
 uint32_t            s_window_width;
 uint32_t            s_window_height;
-uint64_t            s_frame_count = 0;
 
 #define LOG(STR)  { std::stringstream ss; ss << STR << std::endl; \
                     platform_log(ss.str().c_str()); }
@@ -149,21 +150,26 @@ void init_tiny_renderer(GLFWwindow* window)
 
     std::vector<const char*> device_layers;
 
-    int width = 0;
-    int height = 0;
-    glfwGetWindowSize(window, &width, &height);
+    int width = (int)k_window_width;
+    int height = (int)k_window_height;
+    if (NULL != window) {
+        glfwGetWindowSize(window, &width, &height);
+    }
     s_window_width = (uint32_t)width;
     s_window_height = (uint32_t)height;
 
     tr_renderer_settings settings = {};
+    settings.headless                       = (NULL == window);
+    if (! settings.headless) {
 #if defined(TINY_RENDERER_GGP)
 #elif defined(TINY_RENDERER_LINUX)
-    settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
-    settings.handle.window                  = glfwGetX11Window(window);
+        settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
+        settings.handle.window                  = glfwGetX11Window(window);
 #elif defined(TINY_RENDERER_MSW)
-    settings.handle.hinstance               = ::GetModuleHandle(NULL);
-    settings.handle.hwnd                    = glfwGetWin32Window(window);
+        settings.handle.hinstance               = ::GetModuleHandle(NULL);
+        settings.handle.hwnd                    = glfwGetWin32Window(window);
 #endif
+    }
     settings.width                          = s_window_width;
     settings.height                         = s_window_height;
     settings.swapchain.image_count          = k_image_count;
@@ -178,8 +184,7 @@ void init_tiny_renderer(GLFWwindow* window)
 #endif
     tr_create_renderer(k_app_name, &settings, &m_renderer);
 
-    tr_create_cmd_pool(m_renderer, m_renderer->graphics_queue, false, &m_cmd_pool);
-    tr_create_cmd_n(m_cmd_pool, false, k_image_count, &m_cmds);
+    tr_create_frame_context(m_renderer, m_renderer->graphics_queue, k_frame_count, &m_frame_context);
     
 #if defined(TINY_RENDERER_VK)
     // Uses HLSL source
@@ -297,23 +302,15 @@ void init_tiny_renderer(GLFWwindow* window)
 
 void destroy_tiny_renderer()
 {
+    tr_destroy_frame_context(m_renderer, m_frame_context);
     tr_destroy_renderer(m_renderer);
 }
 
 void draw_frame()
 {
-    uint32_t frameIdx = s_frame_count % m_renderer->settings.swapchain.image_count;
-
-    tr_fence* image_acquired_fence = m_renderer->image_acquired_fences[frameIdx];
-    tr_semaphore* image_acquired_semaphore = m_renderer->image_acquired_semaphores[frameIdx];
-    tr_semaphore* render_complete_semaphores = m_renderer->render_complete_semaphores[frameIdx];
-
-    tr_acquire_next_image(m_renderer, image_acquired_semaphore, image_acquired_fence);
-
-    uint32_t swapchain_image_index = m_renderer->swapchain_image_index;
-    tr_render_target* render_target = m_renderer->swapchain_render_targets[swapchain_image_index];
-
-    tr_cmd* cmd = m_cmds[frameIdx];
+    tr_cmd* cmd = nullptr;
+    tr_render_target* render_target = nullptr;
+    tr_begin_frame(m_frame_context, &cmd, &render_target);
 
     tr_begin_cmd(cmd);
     // Use compute to swizzle RGB -> BRG
@@ -340,14 +337,22 @@ void draw_frame()
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_color_attachment, tr_texture_usage_present); 
     tr_end_cmd(cmd);
 
-    tr_queue_submit(m_renderer->graphics_queue, 1, &cmd, 1, &image_acquired_semaphore, 1, &render_complete_semaphores);
-    tr_queue_present(m_renderer->present_queue, 1, &render_complete_semaphores);
-
-    tr_queue_wait_idle(m_renderer->graphics_queue);
+    tr_end_frame(m_frame_context);
 }
 
 int main(int argc, char **argv)
 {
+#if defined(TINY_RENDERER_VK)
+    if ((argc > 1) && (0 == strcmp(argv[1], "--headless"))) {
+        init_tiny_renderer(NULL);
+        for (uint32_t i = 0; i < k_headless_frame_count; ++i) {
+            draw_frame();
+        }
+        destroy_tiny_renderer();
+        return EXIT_SUCCESS;
+    }
+#endif
+
     glfwSetErrorCallback(app_glfw_error);
     if (! glfwInit()) {
         exit(EXIT_FAILURE);
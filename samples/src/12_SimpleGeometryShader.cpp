@@ -11,6 +11,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -39,6 +40,8 @@ using float4x4 = glm::mat4;
 
 const char*         k_app_name = "12_SimpleGeometryShader";
 const uint32_t      k_image_count = 3;
+const uint32_t      k_frame_count = 2;
+const uint32_t      k_headless_frame_count = k_image_count;
 #if defined(TINY_RENDERER_GGP)
 const std::string   k_asset_dir = "./samples/assets/";
 #elif defined(TINY_RENDERER_LINUX)
@@ -56,19 +59,17 @@ const uint32_t k_window_height = 480;
 #endif
 
 tr_renderer*        m_renderer = nullptr;
-tr_descriptor_set*  m_desc_set = nullptr;
-tr_cmd_pool*        m_cmd_pool = nullptr;
-tr_cmd**            m_cmds = nullptr;
+tr_descriptor_set*  m_desc_sets[k_frame_count] = {};
+tr_frame_context*   m_frame_context = nullptr;
 tr_shader_program*  m_shader = nullptr;
 tr_buffer*          m_rect_vertex_buffer = nullptr;
 tr_pipeline*        m_pipeline = nullptr;
 tr_texture*         m_texture = nullptr;
 tr_sampler*         m_sampler = nullptr;
-tr_buffer*          m_uniform_buffer = nullptr;
+tr_buffer*          m_uniform_buffers[k_frame_count] = {};
 
 uint32_t            s_window_width;
 uint32_t            s_window_height;
-uint64_t            s_frame_count = 0;
 
 #define LOG(STR)  { std::stringstream ss; ss << STR << std::endl; \
                     platform_log(ss.str().c_str()); }
@@ -155,21 +156,26 @@ void init_tiny_renderer(GLFWwindow* window)
 
     std::vector<const char*> device_layers;
 
-    int width = 0;
-    int height = 0;
-    glfwGetWindowSize(window, &width, &height);
+    int width = (int)k_window_width;
+    int height = (int)k_window_height;
+    if (NULL != window) {
+        glfwGetWindowSize(window, &width, &height);
+    }
     s_window_width = (uint32_t)width;
     s_window_height = (uint32_t)height;
 
     tr_renderer_settings settings = {};
+    settings.headless                       = (NULL == window);
+    if (! settings.headless) {
 #if defined(TINY_RENDERER_GGP)
 #elif defined(TINY_RENDERER_LINUX)
-    settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
-    settings.handle.window                  = glfwGetX11Window(window);
+        settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
+        settings.handle.window                  = glfwGetX11Window(window);
 #elif defined(TINY_RENDERER_MSW)
-    settings.handle.hinstance               = ::GetModuleHandle(NULL);
-    settings.handle.hwnd                    = glfwGetWin32Window(window);
+        settings.handle.hinstance               = ::GetModuleHandle(NULL);
+        settings.handle.hwnd                    = glfwGetWin32Window(window);
 #endif
+    }
     settings.width                          = s_window_width;
     settings.height                         = s_window_height;
     settings.swapchain.image_count          = k_image_count;
@@ -186,8 +192,7 @@ void init_tiny_renderer(GLFWwindow* window)
 #endif
     tr_create_renderer(k_app_name, &settings, &m_renderer);
 
-    tr_create_cmd_pool(m_renderer, m_renderer->graphics_queue, false, &m_cmd_pool);
-    tr_create_cmd_n(m_cmd_pool, false, k_image_count, &m_cmds);
+    tr_create_frame_context(m_renderer, m_renderer->graphics_queue, k_frame_count, &m_frame_context);
     
 #if defined(TINY_RENDERER_VK)
     auto vert = load_file(k_asset_dir + "triangle_wireframe.vs.spv");
@@ -226,7 +231,10 @@ void init_tiny_renderer(GLFWwindow* window)
     //descriptors[2].count         = 1;
     //descriptors[2].binding       = 2;
     //descriptors[2].shader_stages = tr_shader_stage_frag;
-    tr_create_descriptor_set(m_renderer, (uint32_t)descriptors.size(), descriptors.data(), &m_desc_set);
+    // One set per frame in flight so each frame can point at its own uniform buffer
+    for (uint32_t i = 0; i < k_frame_count; ++i) {
+      tr_create_descriptor_set(m_renderer, (uint32_t)descriptors.size(), descriptors.data(), &m_desc_sets[i]);
+    }
 
     tr_vertex_layout vertex_layout = {};
     vertex_layout.attrib_count = 2;
@@ -242,7 +250,7 @@ void init_tiny_renderer(GLFWwindow* window)
     vertex_layout.attribs[1].offset   = tr_util_format_stride(tr_format_r32g32b32a32_float);
     tr_pipeline_settings pipeline_settings = {tr_primitive_topo_tri_list};
     //pipeline_settings.depth = true;
-    tr_create_pipeline(m_renderer, m_shader, &vertex_layout, m_desc_set, m_renderer->swapchain_render_targets[0], &pipeline_settings, &m_pipeline);
+    tr_create_pipeline(m_renderer, m_shader, &vertex_layout, m_desc_sets[0], m_renderer->swapchain_render_targets[0], &pipeline_settings, &m_pipeline);
 
     float4 positions[8] = {
       { -0.5f,  0.5f,  0.5f, 1.0f },  // 0: -X,  Y, +Z
@@ -331,31 +339,28 @@ void init_tiny_renderer(GLFWwindow* window)
 
     tr_create_sampler(m_renderer, &m_sampler);
 
-    tr_create_uniform_buffer(m_renderer, 16 * sizeof(float), true, &m_uniform_buffer);
+    for (uint32_t i = 0; i < k_frame_count; ++i) {
+      tr_create_uniform_buffer(m_renderer, 16 * sizeof(float), true, &m_uniform_buffers[i]);
 
-    m_desc_set->descriptors[0].uniform_buffers[0] = m_uniform_buffer;
-    m_desc_set->descriptors[1].textures[0]        = m_texture;
-    m_desc_set->descriptors[2].samplers[0]        = m_sampler;
-    tr_update_descriptor_set(m_renderer, m_desc_set);
+      m_desc_sets[i]->descriptors[0].uniform_buffers[0] = m_uniform_buffers[i];
+      m_desc_sets[i]->descriptors[1].textures[0]        = m_texture;
+      m_desc_sets[i]->descriptors[2].samplers[0]        = m_sampler;
+      tr_update_descriptor_set(m_renderer, m_desc_sets[i]);
+    }
 }
 
 void destroy_tiny_renderer()
 {
+    tr_destroy_frame_context(m_renderer, m_frame_context);
     tr_destroy_renderer(m_renderer);
 }
 
 void draw_frame()
 {
-    uint32_t frameIdx = s_frame_count % m_renderer->settings.swapchain.image_count;
-
-    tr_fence* image_acquired_fence = m_renderer->image_acquired_fences[frameIdx];
-    tr_semaphore* image_acquired_semaphore = m_renderer->image_acquired_semaphores[frameIdx];
-    tr_semaphore* render_complete_semaphores = m_renderer->render_complete_semaphores[frameIdx];
-
-    tr_acquire_next_image(m_renderer, image_acquired_semaphore, image_acquired_fence);
-
-    uint32_t swapchain_image_index = m_renderer->swapchain_image_index;
-    tr_render_target* render_target = m_renderer->swapchain_render_targets[swapchain_image_index];
+    tr_cmd* cmd = nullptr;
+    tr_render_target* render_target = nullptr;
+    tr_begin_frame(m_frame_context, &cmd, &render_target);
+    uint32_t frame_index = m_frame_context->frame_index;
 
     //// No projection or view for GLFW since we don't have a math library
     //float t = (float)glfwGetTime();
@@ -376,9 +381,7 @@ void draw_frame()
     float4x4 rot_z = glm::rotate(t / 3.0f, float3(0, 0, 1));
     float4x4 model = rot_x * rot_y * rot_z;
     float4x4 mvp = proj * view * model;
-    memcpy(m_uniform_buffer->cpu_mapped_address, &mvp, sizeof(mvp));
-
-    tr_cmd* cmd = m_cmds[frameIdx];
+    memcpy(m_uniform_buffers[frame_index]->cpu_mapped_address, &mvp, sizeof(mvp));
 
     tr_begin_cmd(cmd);
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_present, tr_texture_usage_color_attachment); 
@@ -395,21 +398,29 @@ void draw_frame()
 	tr_cmd_set_line_width(cmd, 1.0f);
     tr_cmd_bind_pipeline(cmd, m_pipeline);
     tr_cmd_bind_vertex_buffers(cmd, 1, &m_rect_vertex_buffer);
-    tr_cmd_bind_descriptor_sets(cmd, m_pipeline, m_desc_set);
+    tr_cmd_bind_descriptor_sets(cmd, m_pipeline, m_desc_sets[frame_index]);
     tr_cmd_draw(cmd, 36, 0);
     tr_cmd_end_render(cmd);
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_color_attachment, tr_texture_usage_present); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_depth_stencil_attachment, tr_texture_usage_sampled_image);
     tr_end_cmd(cmd);
 
-    tr_queue_submit(m_renderer->graphics_queue, 1, &cmd, 1, &image_acquired_semaphore, 1, &render_complete_semaphores);
-    tr_queue_present(m_renderer->present_queue, 1, &render_complete_semaphores);
-
-    tr_queue_wait_idle(m_renderer->graphics_queue);
+    tr_end_frame(m_frame_context);
 }
 
 int main(int argc, char **argv)
 {
+#if defined(TINY_RENDERER_VK)
+    if ((argc > 1) && (0 == strcmp(argv[1], "--headless"))) {
+        init_tiny_renderer(NULL);
+        for (uint32_t i = 0; i < k_headless_frame_count; ++i) {
+            draw_frame();
+        }
+        destroy_tiny_renderer();
+        return EXIT_SUCCESS;
+    }
+#endif
+
     glfwSetErrorCallback(app_glfw_error);
     if (! glfwInit()) {
         exit(EXIT_FAILURE);
@@ -11,6 +11,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -39,6 +40,8 @@ using float4x4 = glm::mat4;
 
 const char*         k_app_name = "13_SimpleTessellationShader";
 const uint32_t      k_image_count = 3;
+const uint32_t      k_frame_count = 2;
+const uint32_t      k_headless_frame_count = k_image_count;
 #if defined(TINY_RENDERER_GGP)
 const std::string   k_asset_dir = "./samples/assets/";
 #elif defined(TINY_RENDERER_LINUX)
@@ -56,26 +59,24 @@ const uint32_t k_window_height = 480;
 #endif
 
 tr_renderer*        m_renderer = nullptr;
-tr_cmd_pool*        m_cmd_pool = nullptr;
-tr_cmd**            m_cmds = nullptr;
+tr_frame_context*   m_frame_context = nullptr;
 
 tr_buffer*          m_color_vertex_buffer = nullptr;
 uint32_t            m_color_vertex_count = 0;
 tr_shader_program*  m_color_shader = nullptr;
-tr_descriptor_set*  m_color_desc_set = nullptr;
+tr_descriptor_set*  m_color_desc_sets[k_frame_count] = {};
 tr_pipeline*        m_color_pipeline = nullptr;
-tr_buffer*          m_color_uniform_buffer = nullptr;
+tr_buffer*          m_color_uniform_buffers[k_frame_count] = {};
 
 tr_buffer*          m_isoline_vertex_buffer = nullptr;
 uint32_t            m_isoline_vertex_count = 0;
 tr_shader_program*  m_isoline_shader = nullptr;
-tr_descriptor_set*  m_isoline_desc_set = nullptr;
+tr_descriptor_set*  m_isoline_desc_sets[k_frame_count] = {};
 tr_pipeline*        m_isoline_pipeline = nullptr;
-tr_buffer*          m_isoline_uniform_buffer = nullptr;
+tr_buffer*          m_isoline_uniform_buffers[k_frame_count] = {};
 
 uint32_t            s_window_width;
 uint32_t            s_window_height;
-uint64_t            s_frame_count = 0;
 
 #define LOG(STR)  { std::stringstream ss; ss << STR << std::endl; \
                     platform_log(ss.str().c_str()); }
@@ -162,21 +163,26 @@ void init_tiny_renderer(GLFWwindow* window)
 
     std::vector<const char*> device_layers;
 
-    int width = 0;
-    int height = 0;
-    glfwGetWindowSize(window, &width, &height);
+    int width = (int)k_window_width;
+    int height = (int)k_window_height;
+    if (NULL != window) {
+        glfwGetWindowSize(window, &width, &height);
+    }
     s_window_width = (uint32_t)width;
     s_window_height = (uint32_t)height;
 
     tr_renderer_settings settings = {};
+    settings.headless                       = (NULL == window);
+    if (! settings.headless) {
 #if defined(TINY_RENDERER_GGP)
 #elif defined(TINY_RENDERER_LINUX)
-    settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
-    settings.handle.window                  = glfwGetX11Window(window);
+        settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
+        settings.handle.window                  = glfwGetX11Window(window);
 #elif defined(TINY_RENDERER_MSW)
-    settings.handle.hinstance               = ::GetModuleHandle(NULL);
-    settings.handle.hwnd                    = glfwGetWin32Window(window);
+        settings.handle.hinstance               = ::GetModuleHandle(NULL);
+        settings.handle.hwnd                    = glfwGetWin32Window(window);
 #endif
+    }
     settings.width                          = s_window_width;
     settings.height                         = s_window_height;
     settings.swapchain.image_count          = k_image_count;
@@ -193,8 +199,7 @@ void init_tiny_renderer(GLFWwindow* window)
 #endif
     tr_create_renderer(k_app_name, &settings, &m_renderer);
 
-    tr_create_cmd_pool(m_renderer, m_renderer->graphics_queue, false, &m_cmd_pool);
-    tr_create_cmd_n(m_cmd_pool, false, k_image_count, &m_cmds);
+    tr_create_frame_context(m_renderer, m_renderer->graphics_queue, k_frame_count, &m_frame_context);
     
 #if defined(TINY_RENDERER_VK)
     auto vert = load_file(k_asset_dir + "simple_tess_color.vs.spv");
@@ -239,8 +244,11 @@ void init_tiny_renderer(GLFWwindow* window)
     descriptors[0].count         = 1;
     descriptors[0].binding       = 0;
     descriptors[0].shader_stages = (tr_shader_stage)(tr_shader_stage_vert | tr_shader_stage_tesc | tr_shader_stage_tese | tr_shader_stage_frag);
-    tr_create_descriptor_set(m_renderer, (uint32_t)descriptors.size(), descriptors.data(), &m_color_desc_set);
-    tr_create_descriptor_set(m_renderer, (uint32_t)descriptors.size(), descriptors.data(), &m_isoline_desc_set);
+    // One set per frame in flight so each frame can point at its own uniform buffers
+    for (uint32_t i = 0; i < k_frame_count; ++i) {
+      tr_create_descriptor_set(m_renderer, (uint32_t)descriptors.size(), descriptors.data(), &m_color_desc_sets[i]);
+      tr_create_descriptor_set(m_renderer, (uint32_t)descriptors.size(), descriptors.data(), &m_isoline_desc_sets[i]);
+    }
 
     tr_vertex_layout vertex_layout = {};
     vertex_layout.attrib_count = 1;
@@ -250,10 +258,10 @@ void init_tiny_renderer(GLFWwindow* window)
     vertex_layout.attribs[0].location = 0;
     vertex_layout.attribs[0].offset   = 0;
     tr_pipeline_settings pipeline_settings = {tr_primitive_topo_line_strip};
-    tr_create_pipeline(m_renderer, m_color_shader, &vertex_layout, m_color_desc_set, m_renderer->swapchain_render_targets[0], &pipeline_settings, &m_color_pipeline);
+    tr_create_pipeline(m_renderer, m_color_shader, &vertex_layout, m_color_desc_sets[0], m_renderer->swapchain_render_targets[0], &pipeline_settings, &m_color_pipeline);
 
     pipeline_settings = {tr_primitive_topo_4_point_patch};
-    tr_create_pipeline(m_renderer, m_isoline_shader, &vertex_layout, m_isoline_desc_set, m_renderer->swapchain_render_targets[0], &pipeline_settings, &m_isoline_pipeline);
+    tr_create_pipeline(m_renderer, m_isoline_shader, &vertex_layout, m_isoline_desc_sets[0], m_renderer->swapchain_render_targets[0], &pipeline_settings, &m_isoline_pipeline);
 
 
     float4 positions[13] = {
@@ -378,34 +386,31 @@ void init_tiny_renderer(GLFWwindow* window)
     uint32_t ubo_size = sizeof(float4x4)  // float4x4  model_view_matrix
                       + sizeof(float4x4)  // float4x4  proj_matrix
                       + sizeof(float3);   // float3    color
-    tr_create_uniform_buffer(m_renderer, ubo_size, true, &m_color_uniform_buffer);
+    for (uint32_t i = 0; i < k_frame_count; ++i) {
+      tr_create_uniform_buffer(m_renderer, ubo_size, true, &m_color_uniform_buffers[i]);
 
-    tr_create_uniform_buffer(m_renderer, ubo_size, true, &m_isoline_uniform_buffer);
+      tr_create_uniform_buffer(m_renderer, ubo_size, true, &m_isoline_uniform_buffers[i]);
 
-    m_color_desc_set->descriptors[0].uniform_buffers[0] = m_color_uniform_buffer;
-    tr_update_descriptor_set(m_renderer, m_color_desc_set);
+      m_color_desc_sets[i]->descriptors[0].uniform_buffers[0] = m_color_uniform_buffers[i];
+      tr_update_descriptor_set(m_renderer, m_color_desc_sets[i]);
 
-    m_isoline_desc_set->descriptors[0].uniform_buffers[0] = m_isoline_uniform_buffer;
-    tr_update_descriptor_set(m_renderer, m_isoline_desc_set);
+      m_isoline_desc_sets[i]->descriptors[0].uniform_buffers[0] = m_isoline_uniform_buffers[i];
+      tr_update_descriptor_set(m_renderer, m_isoline_desc_sets[i]);
+    }
 }
 
 void destroy_tiny_renderer()
 {
+    tr_destroy_frame_context(m_renderer, m_frame_context);
     tr_destroy_renderer(m_renderer);
 }
 
 void draw_frame()
 {
-    uint32_t frameIdx = s_frame_count % m_renderer->settings.swapchain.image_count;
-
-    tr_fence* image_acquired_fence = m_renderer->image_acquired_fences[frameIdx];
-    tr_semaphore* image_acquired_semaphore = m_renderer->image_acquired_semaphores[frameIdx];
-    tr_semaphore* render_complete_semaphores = m_renderer->render_complete_semaphores[frameIdx];
-
-    tr_acquire_next_image(m_renderer, image_acquired_semaphore, image_acquired_fence);
-
-    uint32_t swapchain_image_index = m_renderer->swapchain_image_index;
-    tr_render_target* render_target = m_renderer->swapchain_render_targets[swapchain_image_index];
+    tr_cmd* cmd = nullptr;
+    tr_render_target* render_target = nullptr;
+    tr_begin_frame(m_frame_context, &cmd, &render_target);
+    uint32_t frame_index = m_frame_context->frame_index;
 
     float4x4 view  = glm::lookAt(float3(0, 0, 2),  float3(0, 0, 0), float3(0, 1, 0));                               
     float4x4 proj  = glm::perspective(glm::radians(60.0f), (float)s_window_width / (float)s_window_height, 0.1f, 10000.0f);
@@ -425,7 +430,7 @@ void draw_frame()
       // Color pipeline gets MVP stuffed into MV.
       buffer.model_view_matrix = proj * view * model;
       buffer.color = float4(1, 1, 0, 0);
-      memcpy(m_color_uniform_buffer->cpu_mapped_address, &buffer, sizeof(buffer));
+      memcpy(m_color_uniform_buffers[frame_index]->cpu_mapped_address, &buffer, sizeof(buffer));
     }
 
     // Isoline constant buffer
@@ -442,10 +447,9 @@ void draw_frame()
       buffer.model_view_matrix = view * model;
       buffer.proj_matrix = proj;
       buffer.color = float4(1, 1, 0, 0);
-      memcpy(m_isoline_uniform_buffer->cpu_mapped_address, &buffer, sizeof(buffer));
+      memcpy(m_isoline_uniform_buffers[frame_index]->cpu_mapped_address, &buffer, sizeof(buffer));
     }
 
-    tr_cmd* cmd = m_cmds[frameIdx];
     tr_begin_cmd(cmd);
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_present, tr_texture_usage_color_attachment); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_sampled_image, tr_texture_usage_depth_stencil_attachment);
@@ -464,14 +468,14 @@ void draw_frame()
     {
       tr_cmd_bind_pipeline(cmd, m_color_pipeline);
       tr_cmd_bind_vertex_buffers(cmd, 1, &m_color_vertex_buffer);
-      tr_cmd_bind_descriptor_sets(cmd, m_color_pipeline, m_color_desc_set);
+      tr_cmd_bind_descriptor_sets(cmd, m_color_pipeline, m_color_desc_sets[frame_index]);
       tr_cmd_draw(cmd, m_color_vertex_count, 0);
     }
     // Isoline
     {
       tr_cmd_bind_pipeline(cmd, m_isoline_pipeline);
       tr_cmd_bind_vertex_buffers(cmd, 1, &m_isoline_vertex_buffer);
-      tr_cmd_bind_descriptor_sets(cmd, m_isoline_pipeline, m_isoline_desc_set);
+      tr_cmd_bind_descriptor_sets(cmd, m_isoline_pipeline, m_isoline_desc_sets[frame_index]);
       tr_cmd_draw(cmd, m_isoline_vertex_count, 0);
     }
     tr_cmd_end_render(cmd);
@@ -479,14 +483,22 @@ void draw_frame()
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_depth_stencil_attachment, tr_texture_usage_sampled_image);
     tr_end_cmd(cmd);
 
-    tr_queue_submit(m_renderer->graphics_queue, 1, &cmd, 1, &image_acquired_semaphore, 1, &render_complete_semaphores);
-    tr_queue_present(m_renderer->present_queue, 1, &render_complete_semaphores);
-
-    tr_queue_wait_idle(m_renderer->graphics_queue);
+    tr_end_frame(m_frame_context);
 }
 
 int main(int argc, char **argv)
 {
+#if defined(TINY_RENDERER_VK)
+    if ((argc > 1) && (0 == strcmp(argv[1], "--headless"))) {
+        init_tiny_renderer(NULL);
+        for (uint32_t i = 0; i < k_headless_frame_count; ++i) {
+            draw_frame();
+        }
+        destroy_tiny_renderer();
+        return EXIT_SUCCESS;
+    }
+#endif
+
     glfwSetErrorCallback(app_glfw_error);
     if (! glfwInit()) {
         exit(EXIT_FAILURE);
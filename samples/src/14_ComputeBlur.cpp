@@ -7,6 +7,7 @@
 #include "GLFW/glfw3native.h"
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -23,6 +24,8 @@
 
 const char*         k_app_name = "14_ComputeBloom";
 const uint32_t      k_image_count = 3;
+const uint32_t      k_frame_count = 2;
+const uint32_t      k_headless_frame_count = k_image_count;
 #if defined(__linux__)
 const std::string   k_asset_dir = "../samples/assets/";
 #elif defined(_WIN32)
@@ -33,12 +36,14 @@ const std::string   k_asset_dir = "../../samples/assets/";
 #define NUM_THREADS_Y  1
 #define NUM_THREADS_Z  1
 
+// Blur kernel radius, specialization constant 0 of compute_blur.hlsl. Vulkan only.
+const int32_t       k_blur_radius = 6;
+
 tr_renderer*        g_renderer = nullptr;
 tr_descriptor_set*  g_desc_set = nullptr;
 tr_descriptor_set*  g_compute_desc_set_hblur = nullptr;
 tr_descriptor_set*  g_compute_desc_set_vblur = nullptr;
-tr_cmd_pool*        g_cmd_pool = nullptr;
-tr_cmd**            g_cmds = nullptr;
+tr_frame_context*   g_frame_context = nullptr;
 tr_shader_program*  g_compute_shader_hblur = nullptr;
 tr_shader_program*  g_compute_shader_vblur = nullptr;
 tr_shader_program*  g_texture_shader = nullptr;
@@ -54,7 +59,6 @@ tr_sampler*         g_sampler = nullptr;
 
 uint32_t            g_window_width;
 uint32_t            g_window_height;
-uint64_t            g_frame_count = 0;
 
 #define LOG(STR)  { std::stringstream ss; ss << STR << std::endl; \
                     platform_log(ss.str().c_str()); }
@@ -143,20 +147,25 @@ void init_tiny_renderer(GLFWwindow* window)
 
     std::vector<const char*> device_layers;
 
-    int width = 0;
-    int height = 0;
-    glfwGetWindowSize(window, &width, &height);
+    int width = 1024;
+    int height = 1024;
+    if (NULL != window) {
+        glfwGetWindowSize(window, &width, &height);
+    }
     g_window_width = (uint32_t)width;
     g_window_height = (uint32_t)height;
 
     tr_renderer_settings settings = {0};
+    settings.headless                       = (NULL == window);
+    if (! settings.headless) {
 #if defined(__linux__)
-    settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
-    settings.handle.window                  = glfwGetX11Window(window);
+        settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
+        settings.handle.window                  = glfwGetX11Window(window);
 #elif defined(_WIN32)
-    settings.handle.hinstance               = ::GetModuleHandle(NULL);
-    settings.handle.hwnd                    = glfwGetWin32Window(window);
+        settings.handle.hinstance               = ::GetModuleHandle(NULL);
+        settings.handle.hwnd                    = glfwGetWin32Window(window);
 #endif
+    }
     settings.width                          = g_window_width;
     settings.height                         = g_window_height;
     settings.swapchain.image_count          = k_image_count;
@@ -174,8 +183,7 @@ void init_tiny_renderer(GLFWwindow* window)
 
   // Command buffer
   {
-    tr_create_cmd_pool(g_renderer, g_renderer->graphics_queue, false, &g_cmd_pool);
-    tr_create_cmd_n(g_cmd_pool, false, k_image_count, &g_cmds);
+    tr_create_frame_context(g_renderer, g_renderer->graphics_queue, k_frame_count, &g_frame_context);
   }
   
   // Shaders
@@ -257,6 +265,9 @@ void init_tiny_renderer(GLFWwindow* window)
     tr_create_pipeline(g_renderer, g_texture_shader, &vertex_layout, g_desc_set, g_renderer->swapchain_render_targets[0], &pipeline_settings, &g_pipeline);
 
     pipeline_settings = {};
+    pipeline_settings.specialization_constant_count = 1;
+    pipeline_settings.specialization_constants[0].constant_id = 0;
+    pipeline_settings.specialization_constants[0].int_value   = k_blur_radius;
     tr_create_compute_pipeline(g_renderer, g_compute_shader_hblur, g_compute_desc_set_hblur, &pipeline_settings, &g_compute_pipeline_hblur);
     tr_create_compute_pipeline(g_renderer, g_compute_shader_vblur, g_compute_desc_set_vblur, &pipeline_settings, &g_compute_pipeline_vblur);
 
@@ -327,23 +338,15 @@ void init_tiny_renderer(GLFWwindow* window)
 
 void destroy_tiny_renderer()
 {
+    tr_destroy_frame_context(g_renderer, g_frame_context);
     tr_destroy_renderer(g_renderer);
 }
 
 void draw_frame()
 {
-  uint32_t frameIdx = g_frame_count % g_renderer->settings.swapchain.image_count;
-
-  tr_fence* image_acquired_fence = g_renderer->image_acquired_fences[frameIdx];
-  tr_semaphore* image_acquired_semaphore = g_renderer->image_acquired_semaphores[frameIdx];
-  tr_semaphore* render_complete_semaphores = g_renderer->render_complete_semaphores[frameIdx];
-
-  tr_acquire_next_image(g_renderer, image_acquired_semaphore, image_acquired_fence);
-
-  uint32_t swapchain_image_index = g_renderer->swapchain_image_index;
-  tr_render_target* render_target = g_renderer->swapchain_render_targets[swapchain_image_index];
-
-  tr_cmd* cmd = g_cmds[frameIdx];
+  tr_cmd* cmd = nullptr;
+  tr_render_target* render_target = nullptr;
+  tr_begin_frame(g_frame_context, &cmd, &render_target);
 
   tr_begin_cmd(cmd);
   // hblur
@@ -384,14 +387,22 @@ void draw_frame()
   tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_color_attachment, tr_texture_usage_present); 
   tr_end_cmd(cmd);
 
-  tr_queue_submit(g_renderer->graphics_queue, 1, &cmd, 1, &image_acquired_semaphore, 1, &render_complete_semaphores);
-  tr_queue_present(g_renderer->present_queue, 1, &render_complete_semaphores);
-
-  tr_queue_wait_idle(g_renderer->graphics_queue);
+  tr_end_frame(g_frame_context);
 }
 
 int main(int argc, char **argv)
 {
+#if defined(TINY_RENDERER_VK)
+  if ((argc > 1) && (0 == strcmp(argv[1], "--headless"))) {
+    init_tiny_renderer(NULL);
+    for (uint32_t i = 0; i < k_headless_frame_count; ++i) {
+      draw_frame();
+    }
+    destroy_tiny_renderer();
+    return EXIT_SUCCESS;
+  }
+#endif
+
   glfwSetErrorCallback(app_glfw_error);
   if (! glfwInit()) {
     exit(EXIT_FAILURE);
@@ -0,0 +1,337 @@
+#include "GLFW/glfw3.h"
+#if defined(__linux__)
+  #if defined(__ggp__)
+  #else
+    #define GLFW_EXPOSE_NATIVE_X11
+  #endif
+#elif defined(_WIN32)
+  #define GLFW_EXPOSE_NATIVE_WIN32
+#endif
+#include "GLFW/glfw3native.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+// Indirect draws are only implemented in tinyvk.h
+#define TINY_RENDERER_IMPLEMENTATION
+#include "tinyvk.h"
+
+const char*         k_app_name = "15_IndirectDraw";
+const uint32_t      k_image_count = 3;
+const uint32_t      k_frame_count = 2;
+const uint32_t      k_headless_frame_count = k_image_count;
+#if defined(TINY_RENDERER_GGP)
+const std::string   k_asset_dir = "./samples/assets/";
+#elif defined(TINY_RENDERER_LINUX)
+const std::string   k_asset_dir = "../samples/assets/";
+#elif defined(TINY_RENDERER_MSW)
+const std::string   k_asset_dir = "../../samples/assets/";
+#endif
+
+#if defined(TINY_RENDERER_GGP)
+const uint32_t k_window_width  = 1920;
+const uint32_t k_window_height = 1080;
+#else
+const uint32_t k_window_width  = 640;
+const uint32_t k_window_height = 480;
+#endif
+
+tr_renderer*        m_renderer = nullptr;
+tr_frame_context*   m_frame_context = nullptr;
+tr_descriptor_set*  m_compute_desc_sets[k_frame_count] = {};
+tr_shader_program*  m_compute_shader = nullptr;
+tr_shader_program*  m_shader = nullptr;
+tr_buffer*          m_args_src_buffer = nullptr;
+tr_buffer*          m_args_buffers[k_frame_count] = {};
+tr_buffer*          m_rect_index_buffer = nullptr;
+tr_buffer*          m_rect_vertex_buffer = nullptr;
+tr_pipeline*        m_compute_pipeline = nullptr;
+tr_pipeline*        m_pipeline = nullptr;
+
+uint32_t            s_window_width;
+uint32_t            s_window_height;
+
+#define LOG(STR)  { std::stringstream ss; ss << STR << std::endl; \
+                    platform_log(ss.str().c_str()); }
+
+static void platform_log(const char* s)
+{
+#if defined(_WIN32)
+  OutputDebugStringA(s);
+#else
+  printf("%s", s);
+#endif
+}
+
+static void app_glfw_error(int error, const char* description)
+{
+  LOG("Error " << error << ":" << description);
+}
+
+void renderer_log(tr_log_type type, const char* msg, const char* component)
+{
+  switch(type) {
+    case tr_log_type_info  : {LOG("[INFO]"  << "[" << component << "] : " << msg);} break;
+    case tr_log_type_warn  : {LOG("[WARN]"  << "[" << component << "] : " << msg);} break;
+    case tr_log_type_debug : {LOG("[DEBUG]" << "[" << component << "] : " << msg);} break;
+    case tr_log_type_error : {LOG("[ERORR]" << "[" << component << "] : " << msg);} break;
+    default: break;
+  }
+}
+
+#if defined(TINY_RENDERER_VK)
+VKAPI_ATTR VkBool32 VKAPI_CALL vulkan_debug(
+    VkDebugReportFlagsEXT      flags,
+    VkDebugReportObjectTypeEXT objectType,
+    uint64_t                   object,
+    size_t                     location,
+    int32_t                    messageCode,
+    const char*                pLayerPrefix,
+    const char*                pMessage,
+    void*                      pUserData
+)
+{
+    if( flags & VK_DEBUG_REPORT_INFORMATION_BIT_EXT ) {
+        //LOG("[INFO]" << "[" << pLayerPrefix << "] : " << pMessage << " (" << messageCode << ")");
+    }
+    else if( flags & VK_DEBUG_REPORT_WARNING_BIT_EXT ) {
+        //LOG("[WARN]" << "[" << pLayerPrefix << "] : " << pMessage << " (" << messageCode << ")");
+    }
+    else if( flags & VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT ) {
+        //LOG("[PERF]" << "[" << pLayerPrefix << "] : " << pMessage << " (" << messageCode << ")");
+    }
+    else if( flags & VK_DEBUG_REPORT_ERROR_BIT_EXT ) {
+        LOG("[ERROR]" << "[" << pLayerPrefix << "] : " << pMessage << " (" << messageCode << ")"); 
+    }
+    else if( flags & VK_DEBUG_REPORT_DEBUG_BIT_EXT ) {
+        LOG("[DEBUG]" << "[" << pLayerPrefix << "] : " << pMessage << " (" << messageCode << ")");
+    }
+    return VK_FALSE;
+}
+#endif
+
+std::vector<uint8_t> load_file(const std::string& path)
+{
+    std::ifstream is;
+    is.open(path.c_str(), std::ios::in | std::ios::binary);
+    assert(is.is_open());
+
+    is.seekg(0, std::ios::end);
+    std::vector<uint8_t> buffer(is.tellg());
+    assert(0 != buffer.size());
+
+    is.seekg(0, std::ios::beg);
+    is.read((char*)buffer.data(), buffer.size());
+
+    return buffer;
+}
+
+void init_tiny_renderer(GLFWwindow* window)
+{
+    std::vector<const char*> instance_layers = {
+#if defined(_DEBUG) && defined(TINY_RENDERER_VK)
+        VK_KHR_KHRONOS_VALIDATION_LAYER_NAME,
+#endif
+    };
+
+    std::vector<const char*> device_layers;
+
+    int width = (int)k_window_width;
+    int height = (int)k_window_height;
+    if (NULL != window) {
+        glfwGetWindowSize(window, &width, &height);
+    }
+    s_window_width = (uint32_t)width;
+    s_window_height = (uint32_t)height;
+
+    tr_renderer_settings settings = {};
+    settings.headless                       = (NULL == window);
+    if (! settings.headless) {
+#if defined(TINY_RENDERER_GGP)
+#elif defined(TINY_RENDERER_LINUX)
+        settings.handle.connection              = XGetXCBConnection(glfwGetX11Display());
+        settings.handle.window                  = glfwGetX11Window(window);
+#elif defined(TINY_RENDERER_MSW)
+        settings.handle.hinstance               = ::GetModuleHandle(NULL);
+        settings.handle.hwnd                    = glfwGetWin32Window(window);
+#endif
+    }
+    settings.width                          = s_window_width;
+    settings.height                         = s_window_height;
+    settings.swapchain.image_count          = k_image_count;
+    settings.swapchain.sample_count         = tr_sample_count_8;
+    settings.swapchain.color_format         = tr_format_b8g8r8a8_unorm;
+    settings.swapchain.depth_stencil_format = tr_format_undefined;
+    settings.log_fn                         = renderer_log;
+#if defined(TINY_RENDERER_VK)
+    settings.vk_debug_fn                    = vulkan_debug;
+    settings.instance_layers.count          = (uint32_t)instance_layers.size();
+    settings.instance_layers.names          = instance_layers.empty() ? nullptr : instance_layers.data();
+#endif
+    tr_create_renderer(k_app_name, &settings, &m_renderer);
+
+    tr_create_frame_context(m_renderer, m_renderer->graphics_queue, k_frame_count, &m_frame_context);
+    
+    // byte_address_buffer.hlsl adds one uint of BufferIn into BufferOut per
+    // group, so it writes the draw arguments into a zeroed buffer
+    auto comp = load_file(k_asset_dir + "byte_address_buffer.cs.spv");
+    tr_create_shader_program_compute(m_renderer, 
+                                     (uint32_t)comp.size(), comp.data(), "main", &m_compute_shader);
+
+    auto vert = load_file(k_asset_dir + "color.vs.spv");
+    auto frag = load_file(k_asset_dir + "color.ps.spv");
+    tr_create_shader_program(m_renderer, 
+                             (uint32_t)vert.size(), (uint32_t*)(vert.data()), "VSMain", 
+                             (uint32_t)frag.size(), (uint32_t*)(frag.data()), "PSMain", &m_shader);
+
+    std::vector<tr_descriptor> descriptors(2);
+    descriptors[0].type          = tr_descriptor_type_storage_buffer_srv;
+    descriptors[0].count         = 1;
+    descriptors[0].binding       = 0;
+    descriptors[0].shader_stages = tr_shader_stage_comp;
+    descriptors[1].type          = tr_descriptor_type_storage_buffer_uav;
+    descriptors[1].count         = 1;
+    descriptors[1].binding       = 1;
+    descriptors[1].shader_stages = tr_shader_stage_comp;
+    for (uint32_t i = 0; i < k_frame_count; ++i) {
+        tr_create_descriptor_set(m_renderer, (uint32_t)descriptors.size(), descriptors.data(), &m_compute_desc_sets[i]);
+    }
+
+    tr_vertex_layout vertex_layout = {};
+    vertex_layout.attrib_count = 2;
+    vertex_layout.attribs[0].semantic = tr_semantic_position;
+    vertex_layout.attribs[0].format   = tr_format_r32g32b32a32_float;
+    vertex_layout.attribs[0].binding  = 0;
+    vertex_layout.attribs[0].location = 0;
+    vertex_layout.attribs[0].offset   = 0;
+    vertex_layout.attribs[1].semantic = tr_semantic_color;
+    vertex_layout.attribs[1].format   = tr_format_r32g32b32_float;
+    vertex_layout.attribs[1].binding  = 0;
+    vertex_layout.attribs[1].location = 1;
+    vertex_layout.attribs[1].offset   = tr_util_format_stride(tr_format_r32g32b32a32_float);
+    tr_pipeline_settings pipeline_settings = {tr_primitive_topo_tri_list};
+    tr_create_pipeline(m_renderer, m_shader, &vertex_layout, nullptr, m_renderer->swapchain_render_targets[0], &pipeline_settings, &m_pipeline);
+
+    pipeline_settings = {};
+    tr_create_compute_pipeline(m_renderer, m_compute_shader, m_compute_desc_sets[0], &pipeline_settings, &m_compute_pipeline);
+
+    // Arguments for the 6 index quad
+    tr_draw_indexed_indirect_args args = {};
+    args.index_count    = 6;
+    args.instance_count = 1;
+    tr_create_buffer(m_renderer, tr_buffer_usage_storage_srv, sizeof(args), true, &m_args_src_buffer);
+    memcpy(m_args_src_buffer->cpu_mapped_address, &args, sizeof(args));
+
+    // Each frame slot has its own argument buffer, draw_frame zeroes it once
+    // the slot's previous frame is done
+    for (uint32_t i = 0; i < k_frame_count; ++i) {
+        tr_create_buffer(m_renderer, (tr_buffer_usage)(tr_buffer_usage_storage_uav | tr_buffer_usage_indirect), sizeof(args), true, &m_args_buffers[i]);
+        m_compute_desc_sets[i]->descriptors[0].buffers[0] = m_args_src_buffer;
+        m_compute_desc_sets[i]->descriptors[1].buffers[0] = m_args_buffers[i];
+        tr_update_descriptor_set(m_renderer, m_compute_desc_sets[i]);
+    }
+
+    // quad
+    {
+        std::vector<float> vertexData = {
+            -0.25f,  0.25f, 0.0f,   1.0f, 1.0f, 0.0f, 0.0f,
+            -0.25f, -0.25f, 0.0f,   1.0f, 0.0f, 1.0f, 0.0f,
+             0.25f, -0.25f, 0.0f,   1.0f, 0.0f, 0.0f, 1.0f,
+             0.25f,  0.25f, 0.0f,   1.0f, 1.0f, 1.0f, 1.0f,
+        };
+
+        uint64_t vertexDataSize = sizeof(float) * vertexData.size();
+        uint32_t vertexStride = sizeof(float) * 7;
+        tr_create_vertex_buffer(m_renderer, vertexDataSize, true, vertexStride, &m_rect_vertex_buffer);
+        memcpy(m_rect_vertex_buffer->cpu_mapped_address, vertexData.data(), vertexDataSize);
+        
+        std::vector<uint16_t> indexData = {
+            0, 1, 2,
+            0, 2, 3
+        };
+        
+        uint64_t indexDataSize = sizeof(uint16_t) * indexData.size();
+        tr_create_index_buffer(m_renderer, indexDataSize, true, tr_index_type_uint16, &m_rect_index_buffer);
+        memcpy(m_rect_index_buffer->cpu_mapped_address, indexData.data(), indexDataSize);
+    }
+}
+
+void destroy_tiny_renderer()
+{
+    tr_destroy_frame_context(m_renderer, m_frame_context);
+    tr_destroy_renderer(m_renderer);
+}
+
+void draw_frame()
+{
+    tr_cmd* cmd = nullptr;
+    tr_render_target* render_target = nullptr;
+    tr_begin_frame(m_frame_context, &cmd, &render_target);
+
+    // The arguments are zeroed every frame, so the quad only shows up if
+    // this frame's indirect read waits on this frame's compute write
+    uint32_t frame_index = m_frame_context->frame_index;
+    tr_buffer* p_args_buffer = m_args_buffers[frame_index];
+    memset(p_args_buffer->cpu_mapped_address, 0, sizeof(tr_draw_indexed_indirect_args));
+
+    tr_begin_cmd(cmd);
+    // Write the draw arguments, one group per uint
+    tr_cmd_transition_buffer(cmd, p_args_buffer, tr_buffer_usage_storage_uav);
+    tr_cmd_bind_pipeline(cmd, m_compute_pipeline);
+    tr_cmd_bind_descriptor_sets(cmd, m_compute_pipeline, m_compute_desc_sets[frame_index]);
+    tr_cmd_dispatch(cmd, sizeof(tr_draw_indexed_indirect_args) / sizeof(uint32_t), 1, 1);
+    // Make the compute write visible to the indirect read
+    tr_cmd_transition_buffer(cmd, p_args_buffer, tr_buffer_usage_indirect);
+    tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_present, tr_texture_usage_color_attachment); 
+    tr_cmd_set_viewport(cmd, 0, 0, (float)s_window_width, (float)s_window_height, 0.0f, 1.0f);
+    tr_cmd_set_scissor(cmd, 0, 0, s_window_width, s_window_height);
+    tr_cmd_begin_render(cmd, render_target);
+    tr_clear_value clear_value = {0.0f, 0.0f, 0.0f, 0.0f};
+    tr_cmd_clear_color_attachment(cmd, 0, &clear_value);
+    tr_cmd_bind_pipeline(cmd, m_pipeline);
+    tr_cmd_bind_index_buffer(cmd, m_rect_index_buffer);
+    tr_cmd_bind_vertex_buffers(cmd, 1, &m_rect_vertex_buffer);
+    tr_cmd_draw_indexed_indirect(cmd, p_args_buffer, 0, 1, 0);
+    tr_cmd_end_render(cmd);
+    tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_color_attachment, tr_texture_usage_present); 
+    tr_end_cmd(cmd);
+
+    tr_end_frame(m_frame_context);
+}
+
+int main(int argc, char **argv)
+{
+#if defined(TINY_RENDERER_VK)
+    if ((argc > 1) && (0 == strcmp(argv[1], "--headless"))) {
+        init_tiny_renderer(NULL);
+        for (uint32_t i = 0; i < k_headless_frame_count; ++i) {
+            draw_frame();
+        }
+        destroy_tiny_renderer();
+        return EXIT_SUCCESS;
+    }
+#endif
+
+    glfwSetErrorCallback(app_glfw_error);
+    if (! glfwInit()) {
+        exit(EXIT_FAILURE);
+    }
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    GLFWwindow* window = glfwCreateWindow(k_window_width, k_window_height, k_app_name, NULL, NULL);
+    init_tiny_renderer(window);
+
+    while (! glfwWindowShouldClose(window)) {
+        draw_frame();
+        glfwPollEvents();
+    }
+    
+    destroy_tiny_renderer();
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return EXIT_SUCCESS;
+}
@@ -98,6 +98,14 @@ namespace TINY_RENDERER_CPP_NAMESPACE {
 
 #define tr_api_export 
 
+// Descriptors in the shader visible heaps of each transient descriptor allocator
+#if ! defined(TINY_RENDERER_DX_TRANSIENT_CBVSRVUAV_DESCRIPTORS)
+    #define TINY_RENDERER_DX_TRANSIENT_CBVSRVUAV_DESCRIPTORS 4096
+#endif
+#if ! defined(TINY_RENDERER_DX_TRANSIENT_SAMPLER_DESCRIPTORS)
+    #define TINY_RENDERER_DX_TRANSIENT_SAMPLER_DESCRIPTORS 256
+#endif
+
 #if ! defined(TINY_RENDERER_CUSTOM_MAX)
 enum {
     tr_max_instance_extensions       = 256,
@@ -114,6 +122,9 @@ enum {
     tr_max_vertex_attribs            = 15,
     tr_max_semantic_name_length      = 128,
     tr_max_descriptor_entries        = 256,
+    tr_max_push_constant_ranges      = 4,
+    tr_max_specialization_constants  = 16,
+    tr_max_frames_in_flight          = 3,
     tr_max_mip_levels                = 0xFFFFFFFF,
 };
 #endif
@@ -256,6 +267,7 @@ typedef enum tr_descriptor_type {
     tr_descriptor_type_storage_texel_buffer_uav, // UAV | VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
     tr_descriptor_type_texture_srv,              // SRV | VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
     tr_descriptor_type_texture_uav,              // UAV | VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+    tr_descriptor_type_uniform_buffer_dynamic,   // CBV | VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
 } tr_descriptor_type;
 
 typedef enum tr_sample_count {
@@ -316,6 +328,11 @@ typedef enum tr_semantic {
     tr_semantic_texcoord9,
 } tr_semantic;
 
+typedef enum tr_vertex_input_rate {
+    tr_vertex_input_rate_vertex = 0,
+    tr_vertex_input_rate_instance,
+} tr_vertex_input_rate;
+
 typedef enum tr_cull_mode {
     tr_cull_mode_none = 0,
     tr_cull_mode_back,
@@ -352,6 +369,8 @@ typedef struct tr_render_target tr_render_target;
 typedef struct tr_buffer tr_buffer;
 typedef struct tr_texture tr_texture;
 typedef struct tr_sampler tr_sampler;
+typedef struct tr_frame_context tr_frame_context;
+typedef struct tr_descriptor_allocator tr_descriptor_allocator;
 
 typedef struct tr_clear_value {
     union {
@@ -396,12 +415,17 @@ typedef struct tr_renderer_settings {
     uint32_t                            height;
     tr_swapchain_settings               swapchain;
     tr_log_fn                           log_fn;
+    // No swapchain is created, same as requesting a zero sized back buffer
+    bool                                headless;
     D3D_FEATURE_LEVEL                   dx_feature_level;
     tr_dx_shader_target                 dx_shader_target;
 } tr_renderer_settings;
 
 typedef struct tr_fence {
     ID3D12Fence*                        dx_fence;
+    // Value signaled by the last submit that used this fence
+    UINT64                              dx_fence_value;
+    HANDLE                              dx_fence_event;
 } tr_fence;
 
 typedef struct tr_semaphore {
@@ -452,12 +476,27 @@ typedef struct tr_descriptor {
     tr_sampler*                         samplers[tr_max_descriptor_entries];
     tr_buffer*                          buffers[tr_max_descriptor_entries];
     uint32_t                            dx_heap_offset;
-    uint32_t                            dx_root_parameter_index;
 } tr_descriptor;
 
+// Sets from a transient allocator take linear ranges of the allocator's shader
+// visible heaps, tr_reset_descriptor_allocator rewinds the ranges. Every other
+// set owns its heaps.
+typedef struct tr_descriptor_allocator {
+    tr_renderer*                        renderer;
+    bool                                transient;
+    uint32_t                            sets_per_pool;
+    ID3D12DescriptorHeap*               dx_cbvsrvuav_heap;
+    ID3D12DescriptorHeap*               dx_sampler_heap;
+    uint32_t                            dx_cbvsrvuav_offset;
+    uint32_t                            dx_sampler_offset;
+} tr_descriptor_allocator;
+
 typedef struct tr_descriptor_set {
     uint32_t                            descriptor_count;
     tr_descriptor*                      descriptors;
+    // Offsets tr_cmd_bind_descriptor_sets_dynamic expects, one per dynamic uniform buffer
+    uint32_t                            dynamic_offset_count;
+    tr_descriptor_allocator*            allocator;
     ID3D12DescriptorHeap*               dx_cbvsrvuav_heap;
     ID3D12DescriptorHeap*               dx_sampler_heap;
 } tr_descriptor_set;
@@ -539,6 +578,8 @@ typedef struct tr_vertex_attrib {
     uint32_t                            binding;
     uint32_t                            location;
     uint32_t                            offset;
+    // Must match for every attrib in the same binding
+    tr_vertex_input_rate                input_rate;
 } tr_vertex_attrib;
 
 typedef struct tr_vertex_layout {
@@ -546,19 +587,53 @@ typedef struct tr_vertex_layout {
     tr_vertex_attrib                    attribs[tr_max_vertex_attribs];
 } tr_vertex_layout;
 
+typedef struct tr_push_constant_range {
+    tr_shader_stage                     shader_stages;
+    // Byte offset and size, both multiples of 4
+    uint32_t                            offset;
+    uint32_t                            size;
+    // HLSL register of the root constants in D3D12, unused in Vulkan
+    uint32_t                            binding;
+} tr_push_constant_range;
+
+typedef struct tr_specialization_constant {
+    uint32_t                            constant_id;
+    union {
+        uint32_t                        uint_value;
+        int32_t                         int_value;
+        float                           float_value;
+        // Write 0 or 1, booleans are 32-bit in SPIR-V
+        uint32_t                        bool_value;
+    };
+} tr_specialization_constant;
+
 typedef struct tr_pipeline_settings {
     tr_primitive_topo                   primitive_topo;
     tr_cull_mode                        cull_mode;
     tr_front_face                       front_face;
     bool                                depth;    
     tr_tessellation_domain_origin       tessellation_domain_origin; // Has no effect in DX, here for consistency
+    // Added to the root signature as root constants
+    uint32_t                            push_constant_range_count;
+    tr_push_constant_range              push_constant_ranges[tr_max_push_constant_ranges];
+    // Has no effect in DX, HLSL has no specialization constants so shaders
+    // fall back to the defaults they were compiled with. Here for consistency.
+    uint32_t                            specialization_constant_count;
+    tr_specialization_constant          specialization_constants[tr_max_specialization_constants];
 } tr_pipeline_settings;
 
 typedef struct tr_pipeline {
     tr_renderer*                        renderer;
     tr_pipeline_settings                settings;
     tr_pipeline_type                    type;
+    // Set N maps to register space N in the root signature
+    uint32_t                            descriptor_set_count;
     ID3D12RootSignature*                dx_root_signature;
+    // Root parameter of each descriptor in set N, UINT32_MAX if it has none. These
+    // live on the pipeline since a set can be used with differently laid out root signatures.
+    uint32_t                            dx_root_parameter_index_counts[tr_max_descriptor_sets];
+    uint32_t*                           dx_root_parameter_indices[tr_max_descriptor_sets];
+    uint32_t                            dx_push_constant_root_parameter_indices[tr_max_push_constant_ranges];
     ID3D12PipelineState*                dx_pipeline_state;
 } tr_pipeline;
 
@@ -587,6 +662,28 @@ typedef struct tr_mesh {
     tr_pipeline*                        pipeline;
 } tr_mesh;
 
+typedef struct tr_frame_context {
+    tr_renderer*                        renderer;
+    tr_queue*                           queue;
+    uint32_t                            frame_count;
+    // Slot used by the current frame, advanced by tr_end_frame
+    uint32_t                            frame_index;
+    uint64_t                            frame_number;
+    // Each slot has its own pool so a slot's commands can be reset while 
+    // the other slots are still executing.
+    tr_cmd_pool*                        cmd_pools[tr_max_frames_in_flight];
+    tr_cmd*                             cmds[tr_max_frames_in_flight];
+    // A slot's fence is waited on before the slot is recorded into again
+    tr_fence*                           render_complete_fences[tr_max_frames_in_flight];
+    bool                                fence_pending[tr_max_frames_in_flight];
+    tr_semaphore*                       image_acquired_semaphores[tr_max_frames_in_flight];
+    // Present waits on these, so they belong to a swapchain image rather than a slot
+    uint32_t                            image_count;
+    tr_semaphore**                      render_complete_semaphores;
+    // Transient descriptor sets for a slot, reset once the slot's fence is reached
+    tr_descriptor_allocator*            descriptor_allocators[tr_max_frames_in_flight];
+} tr_frame_context;
+
 typedef bool(*tr_image_resize_uint8_fn)(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* src_data, 
                                         uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, uint8_t* dst_data,
                                         uint32_t channel_cout, void* user_data);
@@ -601,11 +698,17 @@ tr_api_export void tr_destroy_renderer(tr_renderer* p_renderer);
 
 tr_api_export void tr_create_fence(tr_renderer* p_renderer, tr_fence** pp_fence);
 tr_api_export void tr_destroy_fence(tr_renderer* p_renderer, tr_fence* p_fence);
+tr_api_export void tr_wait_for_fence(tr_renderer* p_renderer, tr_fence* p_fence);
 
 tr_api_export void tr_create_semaphore(tr_renderer* p_renderer, tr_semaphore** pp_semaphore);
 tr_api_export void tr_destroy_semaphore(tr_renderer* p_renderer, tr_semaphore* p_semaphore);
 
+tr_api_export void tr_create_descriptor_allocator(tr_renderer* p_renderer, bool transient, uint32_t sets_per_pool, tr_descriptor_allocator** pp_descriptor_allocator);
+tr_api_export void tr_destroy_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator);
+tr_api_export void tr_reset_descriptor_allocator(tr_descriptor_allocator* p_descriptor_allocator);
+
 tr_api_export void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count, const tr_descriptor* descriptors, tr_descriptor_set** pp_descriptor_set);
+tr_api_export void tr_create_descriptor_set_from_allocator(tr_descriptor_allocator* p_descriptor_allocator, uint32_t descriptor_count, const tr_descriptor* descriptors, tr_descriptor_set** pp_descriptor_set);
 tr_api_export void tr_destroy_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
 
 tr_api_export void tr_create_cmd_pool(tr_renderer* p_renderer, tr_queue* p_queue, bool transient, tr_cmd_pool** pp_cmd_pool);
@@ -620,6 +723,7 @@ tr_api_export void tr_destroy_cmd_n(tr_cmd_pool* p_cmd_pool, uint32_t cmd_count,
 tr_api_export void tr_create_buffer(tr_renderer* p_renderer, tr_buffer_usage usage, uint64_t size, bool host_visible, tr_buffer** pp_buffer);
 tr_api_export void tr_create_index_buffer(tr_renderer*p_renderer, uint64_t size, bool host_visible, tr_index_type index_type, tr_buffer** pp_buffer);
 tr_api_export void tr_create_uniform_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, tr_buffer** pp_buffer);
+tr_api_export void tr_create_uniform_buffer_dynamic(tr_renderer* p_renderer, uint64_t element_size, uint64_t element_count, bool host_visible, tr_buffer** pp_buffer);
 tr_api_export void tr_create_vertex_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, uint32_t vertex_stride, tr_buffer** pp_buffer);
 tr_api_export void tr_create_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_buffer);
 tr_api_export void tr_create_rw_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_counter_buffer, tr_buffer** pp_buffer);
@@ -641,6 +745,8 @@ tr_api_export void tr_destroy_shader_program(tr_renderer* p_renderer, tr_shader_
 
 tr_api_export void tr_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* p_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline);
 tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline);
+tr_api_export void tr_create_pipeline_n(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline);
+tr_api_export void tr_create_compute_pipeline_n(tr_renderer* p_renderer, tr_shader_program* p_shader_program, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline);
 tr_api_export void tr_destroy_pipeline(tr_renderer* p_renderer, tr_pipeline* p_pipeline);
 
 tr_api_export void tr_create_render_target(tr_renderer*p_renderer, uint32_t width, uint32_t height, tr_sample_count sample_count, tr_format color_format, uint32_t color_attachment_count, const tr_clear_value* p_color_clear_values, tr_format depth_stencil_format, const tr_clear_value* p_depth_stencil_clear_value, tr_render_target** pp_render_target);
@@ -659,10 +765,15 @@ tr_api_export void tr_cmd_clear_color_attachment(tr_cmd* p_cmd, uint32_t attachm
 tr_api_export void tr_cmd_clear_depth_stencil_attachment(tr_cmd* p_cmd, const tr_clear_value* clear_value);
 tr_api_export void tr_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline);
 tr_api_export void tr_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set);
+tr_api_export void tr_cmd_bind_descriptor_sets_dynamic(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets);
+tr_api_export void tr_cmd_bind_descriptor_sets_n(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t first_set, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets);
 tr_api_export void tr_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer);
+tr_api_export void tr_cmd_push_constants(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t offset, uint32_t size, const void* p_values);
 tr_api_export void tr_cmd_bind_vertex_buffers(tr_cmd* p_cmd, uint32_t buffer_count, tr_buffer** pp_buffers);
 tr_api_export void tr_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex);
 tr_api_export void tr_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index);
+tr_api_export void tr_cmd_draw_instanced(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance);
+tr_api_export void tr_cmd_draw_indexed_instanced(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance);
 tr_api_export void tr_cmd_draw_mesh(tr_cmd* p_cmd, const tr_mesh* p_mesh);
 tr_api_export void tr_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
 tr_api_export void tr_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
@@ -672,10 +783,15 @@ tr_api_export void tr_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32
 tr_api_export void tr_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t height, uint32_t row_pitch, uint64_t buffer_offset, uint32_t mip_level, tr_buffer* p_buffer, tr_texture* p_texture);
 
 tr_api_export void tr_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence);
-tr_api_export void tr_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores);
+tr_api_export void tr_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores, tr_fence* p_signal_fence);
 tr_api_export void tr_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores);
 tr_api_export void tr_queue_wait_idle(tr_queue* p_queue);
 
+tr_api_export void tr_create_frame_context(tr_renderer* p_renderer, tr_queue* p_queue, uint32_t frame_count, tr_frame_context** pp_frame_context);
+tr_api_export void tr_destroy_frame_context(tr_renderer* p_renderer, tr_frame_context* p_frame_context);
+tr_api_export void tr_begin_frame(tr_frame_context* p_frame_context, tr_cmd** pp_cmd, tr_render_target** pp_render_target);
+tr_api_export void tr_end_frame(tr_frame_context* p_frame_context);
+
 tr_api_export void tr_render_target_set_color_clear_value(tr_render_target* p_render_target, uint32_t attachment_index, float r, float g, float b, float a);
 tr_api_export void tr_render_target_set_depth_stencil_clear_value(tr_render_target* p_render_target, float depth, uint8_t stencil);
 
@@ -766,8 +882,11 @@ void tr_internal_dx_destroy_swapchain(tr_renderer* p_renderer);
 // Internal create functions
 void tr_internal_dx_create_fence(tr_renderer *p_renderer, tr_fence* p_fence);
 void tr_internal_dx_destroy_fence(tr_renderer *p_renderer, tr_fence* p_fence);
+void tr_internal_dx_wait_for_fence(tr_renderer *p_renderer, tr_fence* p_fence);
 void tr_internal_dx_create_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore);
 void tr_internal_dx_destroy_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore);
+void tr_internal_dx_create_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator);
+void tr_internal_dx_destroy_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator);
 void tr_internal_dx_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
 void tr_internal_dx_destroy_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
 void tr_internal_dx_create_cmd_pool(tr_renderer *p_renderer, tr_queue* p_queue, bool transient, tr_cmd_pool* p_cmd_pool);
@@ -780,8 +899,8 @@ void tr_internal_dx_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
 void tr_internal_dx_destroy_texture(tr_renderer* p_renderer, tr_texture* p_texture);
 void tr_internal_dx_create_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler);
 void tr_internal_dx_destroy_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler);
-void tr_internal_dx_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* p_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
-void tr_internal_dx_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
+void tr_internal_dx_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
+void tr_internal_dx_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
 void tr_internal_dx_destroy_pipeline(tr_renderer* p_renderer, tr_pipeline* p_pipeline);
 void tr_internal_dx_create_shader_program(tr_renderer* p_renderer, uint32_t vert_size, const void* vert_code, const char* vert_enpt, uint32_t hull_size, const void* hull_code, const char* hull_enpt, uint32_t domn_size, const void* domn_code, const char* domn_enpt, uint32_t geom_size, const void* geom_code, const char* geom_enpt, uint32_t frag_size, const void* frag_code, const char* frag_enpt, uint32_t comp_size, const void* comp_code, const char* comp_enpt, tr_shader_program* p_shader_program);
 void tr_internal_dx_destroy_shader_program(tr_renderer* p_renderer, tr_shader_program* p_shader_program);
@@ -801,11 +920,12 @@ void tr_internal_dx_cmd_set_scissor(tr_cmd* p_cmd, uint32_t x, uint32_t y, uint3
 void tr_cmd_internal_dx_cmd_clear_color_attachment(tr_cmd* p_cmd, uint32_t attachment_index, const tr_clear_value* clear_value);
 void tr_cmd_internal_dx_cmd_clear_depth_stencil_attachment(tr_cmd* p_cmd, const tr_clear_value* clear_value);
 void tr_internal_dx_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline);
-void tr_internal_dx_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set);
+void tr_internal_dx_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t first_set, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets);
 void tr_internal_dx_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer);
+void tr_internal_dx_cmd_push_constants(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t offset, uint32_t size, const void* p_values);
 void tr_internal_dx_cmd_bind_vertex_buffers(tr_cmd* p_cmd, uint32_t buffer_count, tr_buffer** pp_buffers);
-void tr_internal_dx_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex);
-void tr_internal_dx_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index);
+void tr_internal_dx_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance);
+void tr_internal_dx_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance);
 void tr_internal_dx_cmd_draw_mesh(tr_cmd* p_cmd, const tr_mesh* p_mesh);
 void tr_internal_dx_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_texture, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
 void tr_internal_dx_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
@@ -816,7 +936,7 @@ void tr_internal_dx_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width,
 
 // Internal queue/swapchain functions
 void tr_internal_dx_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence);
-void tr_internal_dx_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores);
+void tr_internal_dx_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores, tr_fence* p_signal_fence);
 void tr_internal_dx_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores);
 void tr_internal_dx_queue_wait_idle(tr_queue* p_queue);
 
@@ -1095,7 +1215,7 @@ void tr_create_renderer(const char *app_name, const tr_renderer_settings* settin
         p_renderer->present_queue->renderer = p_renderer;
 
         // If headless, don't create a swap chain; the user also makes a promise that they won't try to present
-        const bool headless = p_renderer->settings.width == 0 && p_renderer->settings.height == 0 && p_renderer->settings.swapchain.image_count == 0;
+        const bool headless = p_renderer->settings.headless || (p_renderer->settings.width == 0 && p_renderer->settings.height == 0 && p_renderer->settings.swapchain.image_count == 0);
         if (headless)
         {
             tr_internal_log(tr_log_type_info, "Zero back buffer requested, creating a headless renderer", "tr_create_renderer");
@@ -1213,6 +1333,14 @@ void tr_destroy_fence(tr_renderer *p_renderer, tr_fence* p_fence)
     TINY_RENDERER_SAFE_FREE(p_fence);
 }
 
+void tr_wait_for_fence(tr_renderer* p_renderer, tr_fence* p_fence)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_fence);
+
+    tr_internal_dx_wait_for_fence(p_renderer, p_fence);
+}
+
 void tr_create_semaphore(tr_renderer *p_renderer, tr_semaphore** pp_semaphore)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -1235,10 +1363,44 @@ void tr_destroy_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore)
     TINY_RENDERER_SAFE_FREE(p_semaphore);
 }
 
-void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count, const tr_descriptor* p_descriptors, tr_descriptor_set** pp_descriptor_set)
+void tr_create_descriptor_allocator(tr_renderer* p_renderer, bool transient, uint32_t sets_per_pool, tr_descriptor_allocator** pp_descriptor_allocator)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
 
+    tr_descriptor_allocator* p_descriptor_allocator = (tr_descriptor_allocator*)calloc(1, sizeof(*p_descriptor_allocator));
+    assert(NULL != p_descriptor_allocator);
+
+    p_descriptor_allocator->renderer      = p_renderer;
+    p_descriptor_allocator->transient     = transient;
+    p_descriptor_allocator->sets_per_pool = sets_per_pool;
+
+    tr_internal_dx_create_descriptor_allocator(p_renderer, p_descriptor_allocator);
+
+    *pp_descriptor_allocator = p_descriptor_allocator;
+}
+
+void tr_destroy_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_descriptor_allocator);
+
+    tr_internal_dx_destroy_descriptor_allocator(p_renderer, p_descriptor_allocator);
+
+    TINY_RENDERER_SAFE_FREE(p_descriptor_allocator);
+}
+
+void tr_reset_descriptor_allocator(tr_descriptor_allocator* p_descriptor_allocator)
+{
+    assert(NULL != p_descriptor_allocator);
+    assert(p_descriptor_allocator->transient);
+
+    // Sets allocated before the reset must no longer be bound or updated
+    p_descriptor_allocator->dx_cbvsrvuav_offset = 0;
+    p_descriptor_allocator->dx_sampler_offset   = 0;
+}
+
+static void tr_internal_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator, uint32_t descriptor_count, const tr_descriptor* p_descriptors, tr_descriptor_set** pp_descriptor_set)
+{
     tr_descriptor_set* p_descriptor_set = (tr_descriptor_set*)calloc(1, sizeof(*p_descriptor_set));
     assert(NULL != p_descriptor_set);
 
@@ -1249,14 +1411,32 @@ void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count
     memcpy(p_descriptor_set->descriptors, p_descriptors, descriptor_count * sizeof(*(p_descriptor_set->descriptors)));
 
     for (uint32_t i = 0; i < descriptor_count; ++i) {
-        p_descriptor_set->descriptors[i].dx_root_parameter_index = 0xFFFFFFFF;
+        if (tr_descriptor_type_uniform_buffer_dynamic == p_descriptors[i].type) {
+            p_descriptor_set->dynamic_offset_count += p_descriptors[i].count;
+        }
     }
 
+    p_descriptor_set->allocator = p_descriptor_allocator;
+
     tr_internal_dx_create_descriptor_set(p_renderer, p_descriptor_set);
 
     *pp_descriptor_set = p_descriptor_set;
 }
 
+void tr_create_descriptor_set_from_allocator(tr_descriptor_allocator* p_descriptor_allocator, uint32_t descriptor_count, const tr_descriptor* p_descriptors, tr_descriptor_set** pp_descriptor_set)
+{
+    assert(NULL != p_descriptor_allocator);
+
+    tr_internal_create_descriptor_set(p_descriptor_allocator->renderer, p_descriptor_allocator, descriptor_count, p_descriptors, pp_descriptor_set);
+}
+
+void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count, const tr_descriptor* p_descriptors, tr_descriptor_set** pp_descriptor_set)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+
+    tr_internal_create_descriptor_set(p_renderer, NULL, descriptor_count, p_descriptors, pp_descriptor_set);
+}
+
 void tr_destroy_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -1373,6 +1553,22 @@ void tr_create_uniform_buffer(tr_renderer* p_renderer, uint64_t size, bool host_
     tr_create_buffer(p_renderer, tr_buffer_usage_uniform_cbv, size, host_visible, pp_buffer);
 }
 
+void tr_create_uniform_buffer_dynamic(tr_renderer* p_renderer, uint64_t element_size, uint64_t element_count, bool host_visible, tr_buffer** pp_buffer)
+{
+    assert(element_size > 0);
+    assert(element_count > 0);
+
+    // Elements start on CBV placement boundaries, element i is bound 
+    // with a dynamic offset of i * struct_stride.
+    uint64_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+    uint64_t struct_stride = ((element_size + alignment - 1) / alignment) * alignment;
+
+    tr_create_buffer(p_renderer, tr_buffer_usage_uniform_cbv, struct_stride * element_count, host_visible, pp_buffer);
+    (*pp_buffer)->element_count = element_count;
+    (*pp_buffer)->struct_stride = struct_stride;
+    (*pp_buffer)->dx_cbv_view_desc.SizeInBytes = (UINT)struct_stride;
+}
+
 void tr_create_vertex_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, uint32_t vertex_stride, tr_buffer** pp_buffer)
 {
     tr_create_buffer(p_renderer, tr_buffer_usage_vertex, size, host_visible, pp_buffer);
@@ -1655,35 +1851,53 @@ void tr_destroy_shader_program(tr_renderer* p_renderer, tr_shader_program* p_sha
 }
 
 void tr_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* p_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
+{
+    uint32_t descriptor_set_count = (NULL != p_descriptor_set) ? 1 : 0;
+    tr_create_pipeline_n(p_renderer, p_shader_program, p_vertex_layout, descriptor_set_count, &p_descriptor_set, p_render_target, p_pipeline_settings, pp_pipeline);
+}
+
+tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
+{
+    uint32_t descriptor_set_count = (NULL != p_descriptor_set) ? 1 : 0;
+    tr_create_compute_pipeline_n(p_renderer, p_shader_program, descriptor_set_count, &p_descriptor_set, p_pipeline_settings, pp_pipeline);
+}
+
+void tr_create_pipeline_n(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_shader_program);
     assert(NULL != p_render_target);
     assert(NULL != p_pipeline_settings);
+    assert(descriptor_set_count <= tr_max_descriptor_sets);
+    assert((0 == descriptor_set_count) || (NULL != pp_descriptor_sets));
 
     tr_pipeline* p_pipeline = (tr_pipeline*)calloc(1, sizeof(*p_pipeline));
     assert(NULL != p_pipeline);
 
     memcpy(&(p_pipeline->settings), p_pipeline_settings, sizeof(*p_pipeline_settings));
+    p_pipeline->descriptor_set_count = descriptor_set_count;
 
-    tr_internal_dx_create_pipeline(p_renderer, p_shader_program, p_vertex_layout, p_descriptor_set, p_render_target, p_pipeline_settings, p_pipeline);
+    tr_internal_dx_create_pipeline(p_renderer, p_shader_program, p_vertex_layout, descriptor_set_count, pp_descriptor_sets, p_render_target, p_pipeline_settings, p_pipeline);
     p_pipeline->type = tr_pipeline_type_graphics;
 
     *pp_pipeline = p_pipeline;
 }
 
-tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
+void tr_create_compute_pipeline_n(tr_renderer* p_renderer, tr_shader_program* p_shader_program, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_shader_program);
     assert(NULL != p_pipeline_settings);
+    assert(descriptor_set_count <= tr_max_descriptor_sets);
+    assert((0 == descriptor_set_count) || (NULL != pp_descriptor_sets));
 
     tr_pipeline* p_pipeline = (tr_pipeline*)calloc(1, sizeof(*p_pipeline));
     assert(NULL != p_pipeline);
 
     memcpy(&(p_pipeline->settings), p_pipeline_settings, sizeof(*p_pipeline_settings));
+    p_pipeline->descriptor_set_count = descriptor_set_count;
 
-    tr_internal_dx_create_compute_pipeline(p_renderer, p_shader_program, p_descriptor_set, p_pipeline_settings, p_pipeline);
+    tr_internal_dx_create_compute_pipeline(p_renderer, p_shader_program, descriptor_set_count, pp_descriptor_sets, p_pipeline_settings, p_pipeline);
     p_pipeline->type = tr_pipeline_type_compute;
 
     *pp_pipeline = p_pipeline;
@@ -1908,8 +2122,48 @@ void tr_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_desc
     assert(NULL != p_cmd);
     assert(NULL != p_pipeline);
     assert(NULL != p_descriptor_set);
+    assert(0 == p_descriptor_set->dynamic_offset_count);
+
+    tr_internal_dx_cmd_bind_descriptor_sets(p_cmd, p_pipeline, 0, 1, &p_descriptor_set, 0, NULL);
+}
+
+void tr_cmd_bind_descriptor_sets_dynamic(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_pipeline);
+    assert(NULL != p_descriptor_set);
+    assert(dynamic_offset_count == p_descriptor_set->dynamic_offset_count);
+    assert((0 == dynamic_offset_count) || (NULL != p_dynamic_offsets));
+
+    tr_internal_dx_cmd_bind_descriptor_sets(p_cmd, p_pipeline, 0, 1, &p_descriptor_set, dynamic_offset_count, p_dynamic_offsets);
+}
+
+void tr_cmd_bind_descriptor_sets_n(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t first_set, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_pipeline);
+    assert(NULL != pp_descriptor_sets);
+    assert((descriptor_set_count > 0) && ((first_set + descriptor_set_count) <= p_pipeline->descriptor_set_count));
+    assert((0 == dynamic_offset_count) || (NULL != p_dynamic_offsets));
+
+    uint32_t expected_dynamic_offset_count = 0;
+    for (uint32_t i = 0; i < descriptor_set_count; ++i) {
+        assert(NULL != pp_descriptor_sets[i]);
+        expected_dynamic_offset_count += pp_descriptor_sets[i]->dynamic_offset_count;
+    }
+    assert(dynamic_offset_count == expected_dynamic_offset_count);
+
+    tr_internal_dx_cmd_bind_descriptor_sets(p_cmd, p_pipeline, first_set, descriptor_set_count, pp_descriptor_sets, dynamic_offset_count, p_dynamic_offsets);
+}
+
+void tr_cmd_push_constants(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t offset, uint32_t size, const void* p_values)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_pipeline);
+    assert(NULL != p_values);
+    assert((0 == (offset % 4)) && (0 == (size % 4)) && (size > 0));
 
-    tr_internal_dx_cmd_bind_descriptor_sets(p_cmd, p_pipeline, p_descriptor_set);
+    tr_internal_dx_cmd_push_constants(p_cmd, p_pipeline, offset, size, p_values);
 }
 
 void tr_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer)
@@ -1933,7 +2187,7 @@ void tr_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex)
 {
     assert(NULL != p_cmd);
 
-    tr_internal_dx_cmd_draw(p_cmd, vertex_count, first_vertex);
+    tr_internal_dx_cmd_draw(p_cmd, vertex_count, first_vertex, 1, 0);
 }
 
 
@@ -1941,7 +2195,21 @@ void tr_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_ind
 {
     assert(NULL != p_cmd);
 
-    tr_internal_dx_cmd_draw_indexed(p_cmd, index_count, first_index);
+    tr_internal_dx_cmd_draw_indexed(p_cmd, index_count, first_index, 0, 1, 0);
+}
+
+void tr_cmd_draw_instanced(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance)
+{
+    assert(NULL != p_cmd);
+
+    tr_internal_dx_cmd_draw(p_cmd, vertex_count, first_vertex, instance_count, first_instance);
+}
+
+void tr_cmd_draw_indexed_instanced(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance)
+{
+    assert(NULL != p_cmd);
+
+    tr_internal_dx_cmd_draw_indexed(p_cmd, index_count, first_index, vertex_offset, instance_count, first_instance);
 }
 
 void tr_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
@@ -2005,7 +2273,8 @@ void tr_queue_submit(
     uint32_t       wait_semaphore_count,
     tr_semaphore** pp_wait_semaphores,
     uint32_t       signal_semaphore_count,
-    tr_semaphore** pp_signal_semaphores
+    tr_semaphore** pp_signal_semaphores,
+    tr_fence*      p_signal_fence
 )
 {
     assert(NULL != p_queue);
@@ -2024,7 +2293,8 @@ void tr_queue_submit(
                                 wait_semaphore_count, 
                                 pp_wait_semaphores, 
                                 signal_semaphore_count, 
-                                pp_signal_semaphores);
+                                pp_signal_semaphores,
+                                p_signal_fence);
 }
 
 void tr_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores)
@@ -2304,7 +2574,7 @@ void tr_util_transition_buffer(tr_queue* p_queue, tr_buffer* p_buffer, tr_buffer
     tr_cmd_buffer_transition(p_cmd, p_buffer, old_usage, new_usage);
     tr_end_cmd(p_cmd);
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL, NULL);
     tr_queue_wait_idle(p_queue);
 
     tr_destroy_cmd(p_cmd_pool, p_cmd);
@@ -2337,7 +2607,7 @@ void tr_util_transition_image(tr_queue* p_queue, tr_texture* p_texture, tr_textu
     tr_cmd_image_transition(p_cmd, p_texture, old_usage, new_usage);
     tr_end_cmd(p_cmd);
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL, NULL);
     tr_queue_wait_idle(p_queue);
 
     tr_destroy_cmd(p_cmd_pool, p_cmd);
@@ -2401,7 +2671,7 @@ void tr_util_set_storage_buffer_count(tr_queue* p_queue, uint64_t count_offset,
     tr_internal_dx_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, tr_buffer_usage_storage_uav);
     tr_end_cmd(p_cmd);
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL, NULL);
     tr_queue_wait_idle(p_queue);
 
     tr_destroy_cmd(p_cmd_pool, p_cmd);
@@ -2434,7 +2704,7 @@ void tr_util_clear_buffer(tr_queue* p_queue, tr_buffer* p_buffer)
     tr_internal_dx_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, p_buffer->usage);
     tr_end_cmd(p_cmd);
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL, NULL);
     tr_queue_wait_idle(p_queue);
 
     tr_destroy_cmd(p_cmd_pool, p_cmd);
@@ -2469,7 +2739,7 @@ void tr_util_update_buffer(tr_queue* p_queue, uint64_t size, const void* p_src_d
     tr_internal_dx_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, p_buffer->usage);
     tr_end_cmd(p_cmd);
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL, NULL);
     tr_queue_wait_idle(p_queue);
 
     tr_destroy_cmd(p_cmd_pool, p_cmd);
@@ -2590,7 +2860,7 @@ void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_
         tr_internal_dx_cmd_image_transition(p_cmd, p_texture, tr_texture_usage_transfer_dst, tr_texture_usage_sampled_image);
         tr_end_cmd(p_cmd);
 
-        tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+        tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL, NULL);
         tr_queue_wait_idle(p_queue);
 
         tr_destroy_cmd(p_cmd_pool, p_cmd);
@@ -2608,6 +2878,115 @@ void tr_util_update_texture_float(tr_queue* p_queue, uint32_t src_width, uint32_
 {
 }
 
+// -------------------------------------------------------------------------------------------------
+// Frame context functions
+// -------------------------------------------------------------------------------------------------
+void tr_create_frame_context(tr_renderer* p_renderer, tr_queue* p_queue, uint32_t frame_count, tr_frame_context** pp_frame_context)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_queue);
+    assert((frame_count > 0) && (frame_count <= tr_max_frames_in_flight));
+
+    tr_frame_context* p_frame_context = (tr_frame_context*)calloc(1, sizeof(*p_frame_context));
+    assert(NULL != p_frame_context);
+
+    p_frame_context->renderer    = p_renderer;
+    p_frame_context->queue       = p_queue;
+    p_frame_context->frame_count = frame_count;
+    p_frame_context->image_count = p_renderer->settings.swapchain.image_count;
+
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        tr_create_cmd_pool(p_renderer, p_queue, false, &(p_frame_context->cmd_pools[i]));
+        tr_create_cmd(p_frame_context->cmd_pools[i], false, &(p_frame_context->cmds[i]));
+        tr_create_fence(p_renderer, &(p_frame_context->render_complete_fences[i]));
+        tr_create_semaphore(p_renderer, &(p_frame_context->image_acquired_semaphores[i]));
+        tr_create_descriptor_allocator(p_renderer, true, 0, &(p_frame_context->descriptor_allocators[i]));
+    }
+
+    p_frame_context->render_complete_semaphores = (tr_semaphore**)calloc(p_frame_context->image_count, 
+                                                                         sizeof(*(p_frame_context->render_complete_semaphores)));
+    assert(NULL != p_frame_context->render_complete_semaphores);
+
+    for (uint32_t i = 0; i < p_frame_context->image_count; ++i) {
+        tr_create_semaphore(p_renderer, &(p_frame_context->render_complete_semaphores[i]));
+    }
+
+    *pp_frame_context = p_frame_context;
+}
+
+void tr_destroy_frame_context(tr_renderer* p_renderer, tr_frame_context* p_frame_context)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_frame_context);
+
+    for (uint32_t i = 0; i < p_frame_context->frame_count; ++i) {
+        if (p_frame_context->fence_pending[i]) {
+            tr_wait_for_fence(p_renderer, p_frame_context->render_complete_fences[i]);
+        }
+        tr_destroy_descriptor_allocator(p_renderer, p_frame_context->descriptor_allocators[i]);
+        tr_destroy_semaphore(p_renderer, p_frame_context->image_acquired_semaphores[i]);
+        tr_destroy_fence(p_renderer, p_frame_context->render_complete_fences[i]);
+        tr_destroy_cmd(p_frame_context->cmd_pools[i], p_frame_context->cmds[i]);
+        tr_destroy_cmd_pool(p_renderer, p_frame_context->cmd_pools[i]);
+    }
+
+    for (uint32_t i = 0; i < p_frame_context->image_count; ++i) {
+        tr_destroy_semaphore(p_renderer, p_frame_context->render_complete_semaphores[i]);
+    }
+
+    TINY_RENDERER_SAFE_FREE(p_frame_context->render_complete_semaphores);
+    TINY_RENDERER_SAFE_FREE(p_frame_context);
+}
+
+void tr_begin_frame(tr_frame_context* p_frame_context, tr_cmd** pp_cmd, tr_render_target** pp_render_target)
+{
+    assert(NULL != p_frame_context);
+
+    tr_renderer* p_renderer = p_frame_context->renderer;
+    uint32_t frame_index = p_frame_context->frame_index;
+
+    // Only the submission that last used this slot has to finish, the
+    // other slots can still be in flight.
+    if (p_frame_context->fence_pending[frame_index]) {
+        tr_wait_for_fence(p_renderer, p_frame_context->render_complete_fences[frame_index]);
+        p_frame_context->fence_pending[frame_index] = false;
+    }
+
+    // The GPU is done with this slot's transient descriptor sets
+    tr_reset_descriptor_allocator(p_frame_context->descriptor_allocators[frame_index]);
+
+    tr_acquire_next_image(p_renderer, p_frame_context->image_acquired_semaphores[frame_index], NULL);
+
+    if (NULL != pp_cmd) {
+        *pp_cmd = p_frame_context->cmds[frame_index];
+    }
+    if (NULL != pp_render_target) {
+        *pp_render_target = p_renderer->swapchain_render_targets[p_renderer->swapchain_image_index];
+    }
+}
+
+void tr_end_frame(tr_frame_context* p_frame_context)
+{
+    assert(NULL != p_frame_context);
+
+    tr_renderer* p_renderer = p_frame_context->renderer;
+    uint32_t frame_index = p_frame_context->frame_index;
+    uint32_t image_index = p_renderer->swapchain_image_index;
+    assert(image_index < p_frame_context->image_count);
+
+    tr_queue_submit(p_frame_context->queue, 
+                    1, &(p_frame_context->cmds[frame_index]), 
+                    1, &(p_frame_context->image_acquired_semaphores[frame_index]), 
+                    1, &(p_frame_context->render_complete_semaphores[image_index]),
+                    p_frame_context->render_complete_fences[frame_index]);
+    p_frame_context->fence_pending[frame_index] = true;
+
+    tr_queue_present(p_renderer->present_queue, 1, &(p_frame_context->render_complete_semaphores[image_index]));
+
+    p_frame_context->frame_index = (frame_index + 1) % p_frame_context->frame_count;
+    ++p_frame_context->frame_number;
+}
+
 // -------------------------------------------------------------------------------------------------
 // Internal utility functions
 // -------------------------------------------------------------------------------------------------
@@ -3018,10 +3397,37 @@ void tr_internal_dx_destroy_swapchain(tr_renderer* p_renderer)
 // -------------------------------------------------------------------------------------------------
 void tr_internal_dx_create_fence(tr_renderer *p_renderer, tr_fence* p_fence)
 {   
+    assert(NULL != p_renderer->dx_device);
+
+    HRESULT hres = p_renderer->dx_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, 
+                                                      __uuidof(p_fence->dx_fence), (void**)&(p_fence->dx_fence));
+    assert(SUCCEEDED(hres));
+    p_fence->dx_fence_value = 0;
+
+    p_fence->dx_fence_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+    assert(NULL != p_fence->dx_fence_event);
 }
 
 void tr_internal_dx_destroy_fence(tr_renderer *p_renderer, tr_fence* p_fence)
 {   
+    if (NULL != p_fence->dx_fence_event) {
+        CloseHandle(p_fence->dx_fence_event);
+        p_fence->dx_fence_event = NULL;
+    }
+    TINY_RENDERER_SAFE_RELEASE(p_fence->dx_fence);
+}
+
+void tr_internal_dx_wait_for_fence(tr_renderer *p_renderer, tr_fence* p_fence)
+{   
+    assert(NULL != p_fence->dx_fence);
+    assert(NULL != p_fence->dx_fence_event);
+
+    // D3D12 fences are monotonic, so there is nothing to reset
+    if (p_fence->dx_fence->GetCompletedValue() < p_fence->dx_fence_value) {
+        HRESULT hres = p_fence->dx_fence->SetEventOnCompletion(p_fence->dx_fence_value, p_fence->dx_fence_event);
+        assert(SUCCEEDED(hres));
+        WaitForSingleObject(p_fence->dx_fence_event, INFINITE);
+    }
 }
 
 void tr_internal_dx_create_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore)
@@ -3032,6 +3438,36 @@ void tr_internal_dx_destroy_semaphore(tr_renderer *p_renderer, tr_semaphore* p_s
 {   
 }
 
+void tr_internal_dx_create_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator)
+{
+    assert(NULL != p_renderer->dx_device);
+
+    if (! p_descriptor_allocator->transient) {
+        return;
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(D3D12_DESCRIPTOR_HEAP_DESC, desc);
+    desc.Type           = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    desc.NumDescriptors = TINY_RENDERER_DX_TRANSIENT_CBVSRVUAV_DESCRIPTORS;
+    desc.NodeMask       = 0;
+    desc.Flags          = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    HRESULT hres = p_renderer->dx_device->CreateDescriptorHeap(&desc,
+        __uuidof(p_descriptor_allocator->dx_cbvsrvuav_heap), (void**)&(p_descriptor_allocator->dx_cbvsrvuav_heap));
+    assert(SUCCEEDED(hres));
+
+    desc.Type           = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
+    desc.NumDescriptors = TINY_RENDERER_DX_TRANSIENT_SAMPLER_DESCRIPTORS;
+    hres = p_renderer->dx_device->CreateDescriptorHeap(&desc,
+        __uuidof(p_descriptor_allocator->dx_sampler_heap), (void**)&(p_descriptor_allocator->dx_sampler_heap));
+    assert(SUCCEEDED(hres));
+}
+
+void tr_internal_dx_destroy_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator)
+{
+    TINY_RENDERER_SAFE_RELEASE(p_descriptor_allocator->dx_cbvsrvuav_heap);
+    TINY_RENDERER_SAFE_RELEASE(p_descriptor_allocator->dx_sampler_heap);
+}
+
 void tr_internal_dx_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set)
 {
     assert(NULL != p_renderer->dx_device);
@@ -3053,6 +3489,31 @@ void tr_internal_dx_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor
         }
     }
 
+    uint32_t cbvsrvuav_heap_offset = 0;
+    uint32_t sampler_heap_offset = 0;
+
+    tr_descriptor_allocator* p_descriptor_allocator = p_descriptor_set->allocator;
+    if ((NULL != p_descriptor_allocator) && p_descriptor_allocator->transient) {
+        // Take the next range of the allocator's heaps. The extra reference 
+        // is released by tr_destroy_descriptor_set like an owned heap.
+        if (cbvsrvuav_count > 0) {
+            assert((p_descriptor_allocator->dx_cbvsrvuav_offset + cbvsrvuav_count) <= TINY_RENDERER_DX_TRANSIENT_CBVSRVUAV_DESCRIPTORS);
+            p_descriptor_set->dx_cbvsrvuav_heap = p_descriptor_allocator->dx_cbvsrvuav_heap;
+            p_descriptor_set->dx_cbvsrvuav_heap->AddRef();
+            cbvsrvuav_heap_offset = p_descriptor_allocator->dx_cbvsrvuav_offset;
+            p_descriptor_allocator->dx_cbvsrvuav_offset += cbvsrvuav_count;
+        }
+        if (sampler_count > 0) {
+            assert((p_descriptor_allocator->dx_sampler_offset + sampler_count) <= TINY_RENDERER_DX_TRANSIENT_SAMPLER_DESCRIPTORS);
+            p_descriptor_set->dx_sampler_heap = p_descriptor_allocator->dx_sampler_heap;
+            p_descriptor_set->dx_sampler_heap->AddRef();
+            sampler_heap_offset = p_descriptor_allocator->dx_sampler_offset;
+            p_descriptor_allocator->dx_sampler_offset += sampler_count;
+        }
+        cbvsrvuav_count = 0;
+        sampler_count = 0;
+    }
+
     if (cbvsrvuav_count > 0) {
         TINY_RENDERER_DECLARE_ZERO(D3D12_DESCRIPTOR_HEAP_DESC, desc);
         desc.Type           = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
@@ -3076,8 +3537,6 @@ void tr_internal_dx_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor
     }
 
     // Assign heap offsets
-    uint32_t cbvsrvuav_heap_offset = 0;
-    uint32_t sampler_heap_offset = 0;
     for (uint32_t i = 0; i < p_descriptor_set->descriptor_count; ++i) {
         tr_descriptor* descriptor = &(p_descriptor_set->descriptors[i]);
         switch (p_descriptor_set->descriptors[i].type) {
@@ -3591,7 +4050,7 @@ void tr_internal_dx_destroy_shader_program(tr_renderer* p_renderer, tr_shader_pr
     TINY_RENDERER_SAFE_RELEASE(p_shader_program->dx_comp);
 }
 
-void tr_internal_dx_create_root_signature(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set, tr_pipeline* p_pipeline)
+void tr_internal_dx_create_root_signature(tr_renderer* p_renderer, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_pipeline* p_pipeline)
 {
     TINY_RENDERER_DECLARE_ZERO(D3D12_FEATURE_DATA_ROOT_SIGNATURE, feature_data);
     feature_data.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
@@ -3608,33 +4067,45 @@ void tr_internal_dx_create_root_signature(tr_renderer* p_renderer, tr_descriptor
     D3D12_ROOT_PARAMETER1* parameters_11 = NULL;
     D3D12_ROOT_PARAMETER*  parameters_10 = NULL;
 
-    if (NULL != p_descriptor_set) {
+    // Upper bound: one range and parameter per descriptor plus one parameter
+    // per push constant range
+    uint32_t total_descriptor_count = 0;
+    for (uint32_t set_index = 0; set_index < descriptor_set_count; ++set_index) {
+        assert(NULL != pp_descriptor_sets[set_index]);
+        total_descriptor_count += pp_descriptor_sets[set_index]->descriptor_count;
+    }
+    const uint32_t push_constant_range_count = p_pipeline->settings.push_constant_range_count;
+    assert(push_constant_range_count <= tr_max_push_constant_ranges);
+    uint32_t max_parameter_count = total_descriptor_count + push_constant_range_count;
+    if (max_parameter_count > 0) {
+        parameters_11 = (D3D12_ROOT_PARAMETER1*)calloc(max_parameter_count, sizeof(*parameters_11));
+        assert(NULL != parameters_11);
+        parameters_10 = (D3D12_ROOT_PARAMETER*)calloc(max_parameter_count, sizeof(*parameters_10));
+        assert(NULL != parameters_10);
+    }
+    if (total_descriptor_count > 0) {
+        ranges_11 = (D3D12_DESCRIPTOR_RANGE1*)calloc(total_descriptor_count, sizeof(*ranges_11));
+        assert(NULL != ranges_11);
+        ranges_10 = (D3D12_DESCRIPTOR_RANGE*)calloc(total_descriptor_count, sizeof(*ranges_10));
+        assert(NULL != ranges_10);
+    }
+
+    // Sets are laid out in order so pipelines that share their lower sets
+    // also share those root parameter indices
+    for (uint32_t set_index = 0; set_index < descriptor_set_count; ++set_index) {
+        tr_descriptor_set* p_descriptor_set = pp_descriptor_sets[set_index];
         const uint32_t descriptor_count = p_descriptor_set->descriptor_count;
 
-        uint32_t cbvsrvuav_count = 0;
-        uint32_t sampler_count = 0;
-        for (uint32_t i = 0; i < descriptor_count; ++i) {
-            uint32_t count = p_descriptor_set->descriptors[i].count;
-            switch (p_descriptor_set->descriptors[i].type) {
-                case tr_descriptor_type_sampler                 : sampler_count   += count; break;
-                case tr_descriptor_type_uniform_buffer_cbv       : cbvsrvuav_count += count; break;
-                case tr_descriptor_type_storage_buffer_srv       : cbvsrvuav_count += count; break;
-                case tr_descriptor_type_storage_buffer_uav       : cbvsrvuav_count += count; break;
-                case tr_descriptor_type_uniform_texel_buffer_srv : cbvsrvuav_count += count; break;
-                case tr_descriptor_type_storage_texel_buffer_uav : cbvsrvuav_count += count; break;
-                case tr_descriptor_type_texture_srv              : cbvsrvuav_count += count; break;
-                case tr_descriptor_type_texture_uav              : cbvsrvuav_count += count; break;
+        uint32_t* p_root_parameter_indices = NULL;
+        if (descriptor_count > 0) {
+            p_root_parameter_indices = (uint32_t*)calloc(descriptor_count, sizeof(*p_root_parameter_indices));
+            assert(NULL != p_root_parameter_indices);
+            for (uint32_t descriptor_index = 0; descriptor_index < descriptor_count; ++descriptor_index) {
+                p_root_parameter_indices[descriptor_index] = UINT32_MAX;
             }
         }
-
-        // Allocate everything with an upper bound of descriptor counts
-        ranges_11 = (D3D12_DESCRIPTOR_RANGE1*)calloc(descriptor_count, sizeof(*ranges_11));
-        ranges_10 = (D3D12_DESCRIPTOR_RANGE*)calloc(descriptor_count, sizeof(*ranges_10));
-
-        parameters_11 = (D3D12_ROOT_PARAMETER1*)calloc(descriptor_count, sizeof(*parameters_11));
-        assert(NULL != parameters_11);
-        parameters_10 = (D3D12_ROOT_PARAMETER*)calloc(descriptor_count, sizeof(*parameters_11));
-        assert(NULL != parameters_10);
+        p_pipeline->dx_root_parameter_index_counts[set_index] = descriptor_count;
+        p_pipeline->dx_root_parameter_indices[set_index] = p_root_parameter_indices;
 
         // Build ranges
         for (uint32_t descriptor_index = 0; descriptor_index < descriptor_count; ++descriptor_index) {
@@ -3716,18 +4187,36 @@ void tr_internal_dx_create_root_signature(tr_renderer* p_renderer, tr_descriptor
                     assign_range = true;
                 }
                 break;
+                // Root CBV, the address is set at bind time with the dynamic offset applied
+                case tr_descriptor_type_uniform_buffer_dynamic: {
+                    assert(1 == descriptor->count);
+
+                    param_11->ParameterType                   = D3D12_ROOT_PARAMETER_TYPE_CBV;
+                    param_11->Descriptor.ShaderRegister       = descriptor->binding;
+                    param_11->Descriptor.RegisterSpace        = set_index;
+                    param_11->Descriptor.Flags                = D3D12_ROOT_DESCRIPTOR_FLAG_NONE;
+
+                    param_10->ParameterType                   = D3D12_ROOT_PARAMETER_TYPE_CBV;
+                    param_10->Descriptor.ShaderRegister       = descriptor->binding;
+                    param_10->Descriptor.RegisterSpace        = set_index;
+
+                    p_root_parameter_indices[descriptor_index] = parameter_count;
+
+                    ++parameter_count;
+                }
+                break;
             }
 
             if (assign_range) {
                 range_11->NumDescriptors                    = descriptor->count;
                 range_11->BaseShaderRegister                = descriptor->binding;
-                range_11->RegisterSpace                     = 0;
+                range_11->RegisterSpace                     = set_index;
                 range_11->Flags                             = D3D12_DESCRIPTOR_RANGE_FLAG_NONE;
                 range_11->OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND; 
 
                 range_10->NumDescriptors                    = descriptor->count;
                 range_10->BaseShaderRegister                = descriptor->binding;
-                range_10->RegisterSpace                     = 0;
+                range_10->RegisterSpace                     = set_index;
                 range_10->OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND; 
 
                 param_11->DescriptorTable.pDescriptorRanges   = range_11;
@@ -3736,13 +4225,36 @@ void tr_internal_dx_create_root_signature(tr_renderer* p_renderer, tr_descriptor
                 param_10->DescriptorTable.pDescriptorRanges   = range_10;
                 param_10->DescriptorTable.NumDescriptorRanges = 1;
 
-                descriptor->dx_root_parameter_index = parameter_count;
+                p_root_parameter_indices[descriptor_index] = parameter_count;
 
                 ++range_count;
                 ++parameter_count;
             }
         }
     }
+
+    // Push constant ranges become root constants
+    for (uint32_t i = 0; i < push_constant_range_count; ++i) {
+        const tr_push_constant_range* p_range = &(p_pipeline->settings.push_constant_ranges[i]);
+        assert((0 == (p_range->offset % 4)) && (0 == (p_range->size % 4)) && (p_range->size > 0));
+
+        D3D12_ROOT_PARAMETER1* param_11 = &parameters_11[parameter_count];
+        D3D12_ROOT_PARAMETER*  param_10 = &parameters_10[parameter_count];
+        param_11->ParameterType            = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        param_11->ShaderVisibility         = D3D12_SHADER_VISIBILITY_ALL;
+        param_11->Constants.ShaderRegister = p_range->binding;
+        param_11->Constants.RegisterSpace  = 0;
+        param_11->Constants.Num32BitValues = p_range->size / 4;
+
+        param_10->ParameterType            = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        param_10->ShaderVisibility         = D3D12_SHADER_VISIBILITY_ALL;
+        param_10->Constants.ShaderRegister = p_range->binding;
+        param_10->Constants.RegisterSpace  = 0;
+        param_10->Constants.Num32BitValues = p_range->size / 4;
+
+        p_pipeline->dx_push_constant_root_parameter_indices[i] = parameter_count;
+        ++parameter_count;
+    }
     
     TINY_RENDERER_DECLARE_ZERO(D3D12_VERSIONED_ROOT_SIGNATURE_DESC, desc);
     if (D3D_ROOT_SIGNATURE_VERSION_1_1 == feature_data.HighestVersion) {
@@ -3931,10 +4443,14 @@ void tr_internal_dx_create_pipeline_state(tr_renderer* p_renderer, tr_shader_pro
         input_elements[input_element_count].SemanticName            = semantic_names[attrib_index];
         input_elements[input_element_count].SemanticIndex           = semantic_index;
         input_elements[input_element_count].Format                  = tr_util_to_dx_format(attrib->format);
-        input_elements[input_element_count].InputSlot               = 0;
+        input_elements[input_element_count].InputSlot               = attrib->binding;
         input_elements[input_element_count].AlignedByteOffset       = attrib->offset;
         input_elements[input_element_count].InputSlotClass          = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
         input_elements[input_element_count].InstanceDataStepRate    = 0;
+        if (tr_vertex_input_rate_instance == attrib->input_rate) {
+            input_elements[input_element_count].InputSlotClass       = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
+            input_elements[input_element_count].InstanceDataStepRate = 1;
+        }
         ++input_element_count;
     }
 
@@ -4000,13 +4516,13 @@ void tr_internal_dx_create_pipeline_state(tr_renderer* p_renderer, tr_shader_pro
     assert(SUCCEEDED(hres));
 }
 
-void tr_internal_dx_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* p_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
+void tr_internal_dx_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
 {
     assert(NULL != p_renderer->dx_device);
     assert((NULL != p_shader_program->dx_vert) || (NULL != p_shader_program->dx_hull) || (NULL != p_shader_program->dx_domn) || (NULL != p_shader_program->dx_geom) || (NULL != p_shader_program->dx_frag));
     assert((NULL != p_render_target->dx_rtv_heap) || (NULL != p_render_target->dx_dsv_heap));
 
-    tr_internal_dx_create_root_signature(p_renderer, p_descriptor_set, p_pipeline);
+    tr_internal_dx_create_root_signature(p_renderer, descriptor_set_count, pp_descriptor_sets, p_pipeline);
     tr_internal_dx_create_pipeline_state(p_renderer, p_shader_program, p_vertex_layout, p_render_target, p_pipeline_settings, p_pipeline);
 }
 
@@ -4035,17 +4551,20 @@ void tr_internal_dx_create_compute_pipeline_state(tr_renderer* p_renderer, tr_sh
     assert(SUCCEEDED(hres));
 }
 
-void tr_internal_dx_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
+void tr_internal_dx_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
 {
     assert(NULL != p_renderer->dx_device);
     assert(NULL != p_shader_program->dx_comp);
 
-    tr_internal_dx_create_root_signature(p_renderer, p_descriptor_set, p_pipeline);
+    tr_internal_dx_create_root_signature(p_renderer, descriptor_set_count, pp_descriptor_sets, p_pipeline);
     tr_internal_dx_create_compute_pipeline_state(p_renderer, p_shader_program, p_pipeline_settings, p_pipeline);
 }
 
 void tr_internal_dx_destroy_pipeline(tr_renderer* p_renderer, tr_pipeline* p_pipeline)
 {
+    for (uint32_t set_index = 0; set_index < tr_max_descriptor_sets; ++set_index) {
+        TINY_RENDERER_SAFE_FREE(p_pipeline->dx_root_parameter_indices[set_index]);
+    }
     TINY_RENDERER_SAFE_RELEASE(p_pipeline->dx_root_signature);
     TINY_RENDERER_SAFE_RELEASE(p_pipeline->dx_pipeline_state);
 }
@@ -4437,28 +4956,17 @@ void tr_internal_dx_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline)
     }
 }
 
-void tr_internal_dx_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set)
+static void tr_internal_dx_cmd_bind_descriptor_set(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t set_index, tr_descriptor_set* p_descriptor_set, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets)
 {
-    assert(NULL != p_cmd->dx_cmd_list);
-
-    uint32_t descriptor_heap_count = 0;
-    ID3D12DescriptorHeap* descriptor_heaps[2];
-    if (NULL != p_descriptor_set->dx_cbvsrvuav_heap) {
-        descriptor_heaps[descriptor_heap_count] = p_descriptor_set->dx_cbvsrvuav_heap;
-        ++descriptor_heap_count;
-    }
-    if (NULL != p_descriptor_set->dx_sampler_heap) {
-        descriptor_heaps[descriptor_heap_count] = p_descriptor_set->dx_sampler_heap;
-        ++descriptor_heap_count;
-    }
-
-    if (descriptor_heap_count > 0) {
-        p_cmd->dx_cmd_list->SetDescriptorHeaps(descriptor_heap_count, descriptor_heaps);
-    }
+    assert(set_index < p_pipeline->descriptor_set_count);
+    // The set has to match the layout the pipeline was created with
+    assert(p_descriptor_set->descriptor_count == p_pipeline->dx_root_parameter_index_counts[set_index]);
+    const uint32_t* p_root_parameter_indices = p_pipeline->dx_root_parameter_indices[set_index];
 
     for (uint32_t i = 0; i < p_descriptor_set->descriptor_count; ++i) {
         tr_descriptor* descriptor = &(p_descriptor_set->descriptors[i]);
-        if (UINT32_MAX == descriptor->dx_root_parameter_index) {
+        const UINT root_parameter_index = p_root_parameter_indices[i];
+        if (UINT32_MAX == root_parameter_index) {
             continue;
         }
 
@@ -4468,10 +4976,10 @@ void tr_internal_dx_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipel
                 UINT handle_inc_size = p_cmd->cmd_pool->renderer->dx_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
                 handle.ptr += descriptor->dx_heap_offset * handle_inc_size;
                 if (p_pipeline->type == tr_pipeline_type_graphics) {
-                    p_cmd->dx_cmd_list->SetGraphicsRootDescriptorTable(descriptor->dx_root_parameter_index, handle);
+                    p_cmd->dx_cmd_list->SetGraphicsRootDescriptorTable(root_parameter_index, handle);
                 }
                 else if (p_pipeline->type == tr_pipeline_type_compute) {
-                    p_cmd->dx_cmd_list->SetComputeRootDescriptorTable(descriptor->dx_root_parameter_index, handle);
+                    p_cmd->dx_cmd_list->SetComputeRootDescriptorTable(root_parameter_index, handle);
                 }
             }
             break;
@@ -4487,10 +4995,33 @@ void tr_internal_dx_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipel
                 UINT handle_inc_size = p_cmd->cmd_pool->renderer->dx_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
                 handle.ptr += descriptor->dx_heap_offset * handle_inc_size;
                 if (p_pipeline->type == tr_pipeline_type_graphics) {
-                  p_cmd->dx_cmd_list->SetGraphicsRootDescriptorTable(descriptor->dx_root_parameter_index, handle);
+                  p_cmd->dx_cmd_list->SetGraphicsRootDescriptorTable(root_parameter_index, handle);
+                }
+                else if (p_pipeline->type == tr_pipeline_type_compute) {
+                  p_cmd->dx_cmd_list->SetComputeRootDescriptorTable(root_parameter_index, handle);
+                }
+            }
+            break;
+
+            case tr_descriptor_type_uniform_buffer_dynamic: {
+                assert(NULL != descriptor->uniform_buffers[0]);
+
+                // Offsets are in binding order to match Vulkan
+                uint32_t dynamic_index = 0;
+                for (uint32_t j = 0; j < p_descriptor_set->descriptor_count; ++j) {
+                    const tr_descriptor* other = &(p_descriptor_set->descriptors[j]);
+                    if ((tr_descriptor_type_uniform_buffer_dynamic == other->type) && (other->binding < descriptor->binding)) {
+                        ++dynamic_index;
+                    }
+                }
+                assert(dynamic_index < dynamic_offset_count);
+
+                D3D12_GPU_VIRTUAL_ADDRESS address = descriptor->uniform_buffers[0]->dx_resource->GetGPUVirtualAddress() + p_dynamic_offsets[dynamic_index];
+                if (p_pipeline->type == tr_pipeline_type_graphics) {
+                  p_cmd->dx_cmd_list->SetGraphicsRootConstantBufferView(root_parameter_index, address);
                 }
                 else if (p_pipeline->type == tr_pipeline_type_compute) {
-                  p_cmd->dx_cmd_list->SetComputeRootDescriptorTable(descriptor->dx_root_parameter_index, handle);
+                  p_cmd->dx_cmd_list->SetComputeRootConstantBufferView(root_parameter_index, address);
                 }
             }
             break;
@@ -4498,6 +5029,79 @@ void tr_internal_dx_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipel
     }
 }
 
+void tr_internal_dx_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t first_set, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets)
+{
+    assert(NULL != p_cmd->dx_cmd_list);
+
+    // D3D12 allows a single shader visible heap of each type, so the sets in
+    // one bind can't bring conflicting heaps. Changing heaps also invalidates
+    // the tables of sets bound earlier.
+    ID3D12DescriptorHeap* cbvsrvuav_heap = NULL;
+    ID3D12DescriptorHeap* sampler_heap = NULL;
+    for (uint32_t set_index = 0; set_index < descriptor_set_count; ++set_index) {
+        tr_descriptor_set* p_descriptor_set = pp_descriptor_sets[set_index];
+        if (NULL != p_descriptor_set->dx_cbvsrvuav_heap) {
+            assert((NULL == cbvsrvuav_heap) || (p_descriptor_set->dx_cbvsrvuav_heap == cbvsrvuav_heap));
+            cbvsrvuav_heap = p_descriptor_set->dx_cbvsrvuav_heap;
+        }
+        if (NULL != p_descriptor_set->dx_sampler_heap) {
+            assert((NULL == sampler_heap) || (p_descriptor_set->dx_sampler_heap == sampler_heap));
+            sampler_heap = p_descriptor_set->dx_sampler_heap;
+        }
+    }
+
+    uint32_t descriptor_heap_count = 0;
+    ID3D12DescriptorHeap* descriptor_heaps[2];
+    if (NULL != cbvsrvuav_heap) {
+        descriptor_heaps[descriptor_heap_count] = cbvsrvuav_heap;
+        ++descriptor_heap_count;
+    }
+    if (NULL != sampler_heap) {
+        descriptor_heaps[descriptor_heap_count] = sampler_heap;
+        ++descriptor_heap_count;
+    }
+
+    if (descriptor_heap_count > 0) {
+        p_cmd->dx_cmd_list->SetDescriptorHeaps(descriptor_heap_count, descriptor_heaps);
+    }
+
+    // Root parameters of sets outside the bound range are left untouched
+    uint32_t set_dynamic_offset_base = 0;
+    for (uint32_t set_index = 0; set_index < descriptor_set_count; ++set_index) {
+        tr_descriptor_set* p_descriptor_set = pp_descriptor_sets[set_index];
+        tr_internal_dx_cmd_bind_descriptor_set(p_cmd, p_pipeline, first_set + set_index, p_descriptor_set, dynamic_offset_count - set_dynamic_offset_base, p_dynamic_offsets + set_dynamic_offset_base);
+        set_dynamic_offset_base += p_descriptor_set->dynamic_offset_count;
+    }
+}
+
+void tr_internal_dx_cmd_push_constants(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t offset, uint32_t size, const void* p_values)
+{
+    assert(NULL != p_cmd->dx_cmd_list);
+
+    // Each range is its own root parameter, write the overlapping part of each
+    bool written = false;
+    for (uint32_t i = 0; i < p_pipeline->settings.push_constant_range_count; ++i) {
+        const tr_push_constant_range* p_range = &(p_pipeline->settings.push_constant_ranges[i]);
+        uint32_t begin = tr_max(offset, p_range->offset);
+        uint32_t end = tr_min(offset + size, p_range->offset + p_range->size);
+        if (begin >= end) {
+            continue;
+        }
+
+        UINT root_parameter_index = p_pipeline->dx_push_constant_root_parameter_indices[i];
+        const void* p_src = (const uint8_t*)p_values + (begin - offset);
+        if (p_pipeline->type == tr_pipeline_type_graphics) {
+            p_cmd->dx_cmd_list->SetGraphicsRoot32BitConstants(root_parameter_index, (end - begin) / 4, p_src, (begin - p_range->offset) / 4);
+        }
+        else if (p_pipeline->type == tr_pipeline_type_compute) {
+            p_cmd->dx_cmd_list->SetComputeRoot32BitConstants(root_parameter_index, (end - begin) / 4, p_src, (begin - p_range->offset) / 4);
+        }
+        written = true;
+    }
+    assert(written);
+    (void)written;
+}
+
 void tr_internal_dx_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer)
 {
     assert(NULL != p_cmd->dx_cmd_list);
@@ -4521,28 +5125,28 @@ void tr_internal_dx_cmd_bind_vertex_buffers(tr_cmd* p_cmd, uint32_t buffer_count
     p_cmd->dx_cmd_list->IASetVertexBuffers(0, buffer_count, views);
 }
 
-void tr_internal_dx_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex)
+void tr_internal_dx_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance)
 {
     assert(NULL != p_cmd->dx_cmd_list);
 
     p_cmd->dx_cmd_list->DrawInstanced(
         (UINT)vertex_count,
-        (UINT)1,
+        (UINT)instance_count,
         (UINT)first_vertex,
-        (UINT)0
+        (UINT)first_instance
     );
 }
 
-void tr_internal_dx_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index)
+void tr_internal_dx_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance)
 {
     assert(NULL != p_cmd->dx_cmd_list);
 
     p_cmd->dx_cmd_list->DrawIndexedInstanced(
         (UINT)index_count,
-        (UINT)1,
+        (UINT)instance_count,
         (UINT)first_index,
-        (UINT)0,
-        (UINT)0
+        (INT)vertex_offset,
+        (UINT)first_instance
     );
 }
 
@@ -4676,7 +5280,8 @@ void tr_internal_dx_queue_submit(
     uint32_t       wait_semaphore_count,
     tr_semaphore** pp_wait_semaphores,
     uint32_t       signal_semaphore_count,
-    tr_semaphore** pp_signal_semaphores
+    tr_semaphore** pp_signal_semaphores,
+    tr_fence*      p_signal_fence
 )
 {
     assert(NULL != p_queue->dx_queue);
@@ -4688,6 +5293,12 @@ void tr_internal_dx_queue_submit(
     }
 
     p_queue->dx_queue->ExecuteCommandLists(count, cmds);
+
+    if (NULL != p_signal_fence) {
+        ++p_signal_fence->dx_fence_value;
+        HRESULT hres = p_queue->dx_queue->Signal(p_signal_fence->dx_fence, p_signal_fence->dx_fence_value);
+        assert(SUCCEEDED(hres));
+    }
 }
 
 void tr_internal_dx_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores)
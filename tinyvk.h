@@ -64,6 +64,7 @@ COMPILING & LINKING
 #include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -124,10 +125,37 @@ enum {
     tr_max_vertex_attribs            = 15,
     tr_max_semantic_name_length      = 128,
     tr_max_descriptor_entries        = 256,
+    tr_max_descriptor_types          = 11,
+    tr_max_push_constant_ranges      = 4,
+    tr_max_specialization_constants  = 16,
+    tr_max_upload_batches            = 3,
+    tr_max_pending_barriers          = 16,
+    // Bindless table sizes, well below the update after bind limits that
+    // VK_EXT_descriptor_indexing guarantees
+    tr_max_bindless_textures         = 16384,
+    tr_max_bindless_storage_buffers  = 16384,
+    tr_max_bindless_samplers         = 1024,
+    tr_max_frames_in_flight          = 3,
     tr_max_mip_levels                = 0xFFFFFFFF,
 };
 #endif
 
+// Size of the device memory blocks that buffers and textures are sub-allocated
+// from. Resources larger than half a block get a dedicated allocation.
+#if ! defined(TINY_RENDERER_MEMORY_BLOCK_SIZE)
+    #define TINY_RENDERER_MEMORY_BLOCK_SIZE (64 * 1024 * 1024)
+#endif
+
+// Default size of the staging ring used by upload contexts
+#if ! defined(TINY_RENDERER_UPLOAD_STAGING_SIZE)
+    #define TINY_RENDERER_UPLOAD_STAGING_SIZE (16 * 1024 * 1024)
+#endif
+
+// Default number of descriptor sets each pool of a descriptor allocator holds
+#if ! defined(TINY_RENDERER_DESCRIPTOR_POOL_SETS)
+    #define TINY_RENDERER_DESCRIPTOR_POOL_SETS 64
+#endif
+
 typedef enum tr_api {
     tr_api_vulkan = 0,
     tr_api_d3d12
@@ -217,6 +245,16 @@ typedef enum tr_texture_usage {
 
 typedef uint32_t tr_texture_usage_flags;
 
+// Simultaneous use is only needed for command buffers that are submitted
+// again while a previous submission is still pending.
+typedef enum tr_cmd_usage {
+    tr_cmd_usage_default                        = 0x00000000,
+    tr_cmd_usage_one_time_submit                = 0x00000001,
+    tr_cmd_usage_simultaneous_use               = 0x00000002,
+} tr_cmd_usage;
+
+typedef uint32_t tr_cmd_usage_flags;
+
 typedef enum tr_format {
     tr_format_undefined = 0,
     // 1 channel
@@ -265,8 +303,18 @@ typedef enum tr_descriptor_type {
     tr_descriptor_type_storage_texel_buffer_uav, // UAV | VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
     tr_descriptor_type_texture_srv,              // SRV | VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
     tr_descriptor_type_texture_uav,              // UAV | VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+    tr_descriptor_type_uniform_buffer_dynamic,   // CBV | VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
 } tr_descriptor_type;
 
+// Bindings of the global bindless tables, shaders declare them as
+// unsized arrays at these bindings of the set the table is bound to
+typedef enum tr_bindless_table_type {
+    tr_bindless_table_type_texture        = 0, // VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+    tr_bindless_table_type_storage_buffer = 1, // VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+    tr_bindless_table_type_sampler        = 2, // VK_DESCRIPTOR_TYPE_SAMPLER
+    tr_bindless_table_type_count          = 3,
+} tr_bindless_table_type;
+
 typedef enum tr_sample_count {
     tr_sample_count_1  =  1,
     tr_sample_count_2  =  2,
@@ -323,6 +371,11 @@ typedef enum tr_semantic {
     tr_semantic_texcoord9,
 } tr_semantic;
 
+typedef enum tr_vertex_input_rate {
+    tr_vertex_input_rate_vertex = 0,
+    tr_vertex_input_rate_instance,
+} tr_vertex_input_rate;
+
 typedef enum tr_cull_mode {
     tr_cull_mode_none = 0,
     tr_cull_mode_back,
@@ -352,6 +405,14 @@ typedef struct tr_render_target tr_render_target;
 typedef struct tr_buffer tr_buffer;
 typedef struct tr_texture tr_texture;
 typedef struct tr_sampler tr_sampler;
+typedef struct tr_memory_block tr_memory_block;
+typedef struct tr_upload_context tr_upload_context;
+typedef struct tr_frame_context tr_frame_context;
+typedef struct tr_descriptor_pool tr_descriptor_pool;
+typedef struct tr_descriptor_allocator tr_descriptor_allocator;
+typedef struct tr_descriptor_set tr_descriptor_set;
+typedef struct tr_pipeline tr_pipeline;
+typedef struct tr_pipeline_worker_pool tr_pipeline_worker_pool;
 
 typedef struct tr_clear_value {
     union {
@@ -400,12 +461,22 @@ typedef struct tr_renderer_settings {
     uint32_t                            height;
     tr_swapchain_settings               swapchain;
     tr_log_fn                           log_fn;
+    // No surface or swapchain is created, the swapchain render targets are
+    // offscreen images and tr_queue_present doesn't display anything.
+    bool                                headless;
     // Vulkan specific options
     tr_string_list                      instance_layers;
     tr_string_list                      instance_extensions;
     //tr_string_list                      device_layers;
     tr_string_list                      device_extensions;
     PFN_vkDebugReportCallbackEXT        vk_debug_fn;
+    // Pipeline cache is loaded from and saved to this file, NULL disables persistence
+    const char*                         vk_pipeline_cache_path;
+    // Creates the global bindless tables if VK_EXT_descriptor_indexing and
+    // its update after bind features are available
+    bool                                vk_bindless;
+    // Threads started by the first tr_create_pipeline_async, 0 means 1
+    uint32_t                            pipeline_worker_count;
 } tr_renderer_settings;
 
 typedef struct tr_fence {
@@ -420,8 +491,76 @@ typedef struct tr_queue {
     tr_renderer*                        renderer;
     VkQueue                             vk_queue;
     uint32_t                            vk_queue_family_index;
+    // Used by the tr_util_* upload helpers, created on first use
+    tr_upload_context*                  util_upload_context;
 } tr_queue;
 
+typedef struct tr_memory_range {
+    VkDeviceSize                        offset;
+    VkDeviceSize                        size;
+} tr_memory_range;
+
+typedef struct tr_memory_block {
+    uint32_t                            memory_type_index;
+    // Linear resources (buffers, linear images) and optimal images never share
+    // a block, so bufferImageGranularity doesn't need to be padded for.
+    bool                                linear;
+    bool                                dedicated;
+    VkDeviceSize                        size;
+    uint32_t                            allocation_count;
+    // Free ranges are sorted by offset and coalesced on free
+    uint32_t                            free_range_count;
+    uint32_t                            free_range_capacity;
+    tr_memory_range*                    free_ranges;
+    // Host visible blocks stay mapped for their entire lifetime
+    void*                               cpu_mapped_address;
+    VkDeviceMemory                      vk_memory;
+    tr_memory_block*                    next;
+} tr_memory_block;
+
+typedef struct tr_memory_allocation {
+    tr_memory_block*                    block;
+    VkDeviceSize                        offset;
+    VkDeviceSize                        size;
+} tr_memory_allocation;
+
+typedef struct tr_bindless_table {
+    uint32_t                            capacity;
+    // Slots below this have been handed out at least once, index 0 is never
+    // handed out so zeroed objects don't own a slot
+    uint32_t                            high_water_index;
+    uint32_t                            free_count;
+    uint32_t*                           free_indices;
+} tr_bindless_table;
+
+// Descriptor set layouts are shared between sets whose bindings match,
+// entries are reference counted and destroyed when the last user goes away.
+typedef struct tr_descriptor_set_layout_entry tr_descriptor_set_layout_entry;
+typedef struct tr_descriptor_set_layout_entry {
+    uint64_t                            hash;
+    uint32_t                            binding_count;
+    VkDescriptorSetLayoutBinding*       bindings;
+    uint32_t                            ref_count;
+    VkDescriptorSetLayout               vk_descriptor_set_layout;
+    tr_descriptor_set_layout_entry*     next;
+} tr_descriptor_set_layout_entry;
+
+// Pipeline layouts are shared between pipelines with the same set layouts
+// and push constant ranges. Each entry holds a reference on its cached set
+// layouts so a recycled handle can never match a stale entry.
+typedef struct tr_pipeline_layout_entry tr_pipeline_layout_entry;
+typedef struct tr_pipeline_layout_entry {
+    uint64_t                            hash;
+    uint32_t                            set_layout_count;
+    VkDescriptorSetLayout               set_layouts[tr_max_descriptor_sets];
+    tr_descriptor_set_layout_entry*     set_layout_entries[tr_max_descriptor_sets];
+    uint32_t                            push_constant_range_count;
+    VkPushConstantRange                 push_constant_ranges[tr_max_push_constant_ranges];
+    uint32_t                            ref_count;
+    VkPipelineLayout                    vk_pipeline_layout;
+    tr_pipeline_layout_entry*           next;
+} tr_pipeline_layout_entry;
+
 typedef struct tr_renderer {
     tr_api                              api;
     tr_renderer_settings                settings;
@@ -439,11 +578,40 @@ typedef struct tr_renderer {
     uint32_t                            vk_active_gpu_index;
     VkPhysicalDeviceMemoryProperties    vk_memory_properties;
     VkPhysicalDeviceProperties          vk_active_gpu_properties;
+    VkPhysicalDeviceFeatures            vk_active_gpu_features;
     VkDevice                            vk_device;
     VkSurfaceKHR                        vk_surface;
     VkSwapchainKHR                      vk_swapchain;
     VkDebugReportCallbackEXT            vk_debug_report;
     bool                                vk_device_ext_VK_AMD_negative_viewport_height;
+    bool                                vk_device_ext_VK_EXT_pipeline_creation_feedback;
+    bool                                vk_device_ext_VK_EXT_descriptor_indexing;
+    bool                                vk_device_ext_VK_KHR_draw_indirect_count;
+    tr_memory_block*                    vk_memory_blocks[VK_MAX_MEMORY_TYPES];
+    VkPipelineCache                     vk_pipeline_cache;
+    // Descriptor sets from tr_create_descriptor_set come from here
+    tr_descriptor_allocator*            descriptor_allocator;
+    // Pipeline creation counters, hits and duration require VK_EXT_pipeline_creation_feedback
+    uint32_t                            vk_pipeline_create_count;
+    uint32_t                            vk_pipeline_cache_hit_count;
+    uint64_t                            vk_pipeline_create_duration_ns;
+    // Pipeline creates that returned an existing pipeline with the same key
+    uint32_t                            vk_pipeline_dedup_count;
+    // Global update after bind tables, NULL unless settings.vk_bindless was
+    // requested and is supported. Bind it once per frame at any set index
+    // the pipelines were created with.
+    tr_descriptor_set*                  bindless_descriptor_set;
+    tr_bindless_table                   bindless_tables[tr_bindless_table_type_count];
+    VkDescriptorPool                    vk_bindless_descriptor_pool;
+    // Last id handed to a buffer, texture, sampler or shader program
+    uint64_t                            vk_last_resource_id;
+    // Layout caches, see tr_descriptor_set_layout_entry and tr_pipeline_layout_entry
+    tr_descriptor_set_layout_entry*     vk_descriptor_set_layouts;
+    tr_pipeline_layout_entry*           vk_pipeline_layouts;
+    // Live pipelines, tr_create_pipeline returns one of these when the key matches
+    tr_pipeline*                        vk_pipelines;
+    // Compiles pipelines from tr_create_pipeline_async, NULL until first used
+    tr_pipeline_worker_pool*            pipeline_worker_pool;
 } tr_renderer;
 
 typedef struct tr_descriptor {
@@ -455,29 +623,116 @@ typedef struct tr_descriptor {
     tr_texture*                         textures[tr_max_descriptor_entries];
     tr_sampler*                         samplers[tr_max_descriptor_entries];
     tr_buffer*                          buffers[tr_max_descriptor_entries];
+    // First element of this descriptor in the set's per element arrays
+    uint32_t                            vk_element_offset;
 } tr_descriptor;
 
+typedef struct tr_descriptor_pool {
+    // Per set descriptor counts indexed by VkDescriptorType, rounded up to a
+    // power of two so that similar layouts share pools.
+    uint32_t                            size_class[tr_max_descriptor_types];
+    uint32_t                            max_sets;
+    uint32_t                            allocated_count;
+    // Set when an allocation failed, cleared when a set is returned
+    bool                                exhausted;
+    VkDescriptorPool                    vk_descriptor_pool;
+    tr_descriptor_pool*                 next;
+} tr_descriptor_pool;
+
+typedef struct tr_descriptor_allocator {
+    tr_renderer*                        renderer;
+    // Transient allocators don't free individual sets, all of their
+    // sets are released at once by tr_reset_descriptor_allocator.
+    bool                                transient;
+    uint32_t                            sets_per_pool;
+    tr_descriptor_pool*                 pools;
+} tr_descriptor_allocator;
+
 typedef struct tr_descriptor_set {
     uint32_t                            descriptor_count;
     tr_descriptor*                      descriptors;
+    // Offsets tr_cmd_bind_descriptor_sets_dynamic expects, one per dynamic uniform buffer
+    uint32_t                            dynamic_offset_count;
+    tr_descriptor_allocator*            allocator;
+    tr_descriptor_pool*                 pool;
+    // Shared with every set that has the same bindings, NULL for the bindless set
+    tr_descriptor_set_layout_entry*     vk_descriptor_set_layout_entry;
     VkDescriptorSetLayout               vk_descriptor_set_layout;
     VkDescriptorSet                     vk_descriptor_set;
-    VkDescriptorPool                    vk_descriptor_pool;
+    // Resource ids last written to each array element of every descriptor,
+    // updates only write elements whose resource changed. The info and
+    // write arrays are scratch space allocated once with the set.
+    uint32_t                            vk_element_count;
+    uint64_t*                           vk_written_resource_ids;
+    VkDescriptorImageInfo*              vk_image_infos;
+    VkDescriptorBufferInfo*             vk_buffer_infos;
+    VkBufferView*                       vk_texel_buffer_views;
+    VkWriteDescriptorSet*               vk_writes;
 } tr_descriptor_set;
 
+// Command pools are externally synchronized, threads that record in
+// parallel must each allocate their command buffers from their own pool.
 typedef struct tr_cmd_pool {
     tr_renderer*                        renderer;
+    // Per frame pools reset all their command buffers at once with
+    // tr_reset_cmd_pool, their command buffers can't be reset one by one.
+    bool                                per_frame;
     VkCommandPool                       vk_cmd_pool;
 } tr_cmd_pool;
 
+// What's currently bound in a command buffer, binds that match are skipped.
+// Pipelines and descriptor sets are tracked per bind point, graphics is 0
+// and compute is 1. Sets remember the pipeline layout they were bound with.
+typedef struct tr_cmd_state {
+    VkPipeline                          vk_pipelines[2];
+    VkDescriptorSet                     vk_descriptor_sets[2][tr_max_descriptor_sets];
+    VkPipelineLayout                    vk_descriptor_set_layouts[2][tr_max_descriptor_sets];
+    uint32_t                            vertex_buffer_count;
+    VkBuffer                            vk_vertex_buffers[tr_max_vertex_bindings];
+    VkBuffer                            vk_index_buffer;
+    VkIndexType                         vk_index_type;
+    bool                                viewport_valid;
+    VkViewport                          vk_viewport;
+    bool                                scissor_valid;
+    VkRect2D                            vk_scissor;
+} tr_cmd_state;
+
 typedef struct tr_cmd {
     tr_cmd_pool*                        cmd_pool;
     VkCommandBuffer                     vk_cmd_buf;
+    bool                                secondary;
+    // Set while the bound graphics pipeline is still compiling and has no usable fallback
+    bool                                skip_draws;
+    // Reset by tr_begin_cmd and tr_cmd_invalidate_state
+    tr_cmd_state                        state;
+    // State commands recorded and skipped as redundant since tr_begin_cmd
+    uint32_t                            state_emitted_count;
+    uint32_t                            state_filtered_count;
+    // Render target of the render pass being recorded, final layouts are
+    // tracked on its attachments when the pass ends.
+    tr_render_target*                   bound_render_target;
+    // Transitions queued since the last flush, they're recorded as a single
+    // vkCmdPipelineBarrier before the next command that needs them.
+    uint32_t                            pending_buffer_barrier_count;
+    VkBufferMemoryBarrier               vk_pending_buffer_barriers[tr_max_pending_barriers];
+    tr_buffer*                          pending_buffers[tr_max_pending_barriers];
+    uint32_t                            pending_image_barrier_count;
+    VkImageMemoryBarrier                vk_pending_image_barriers[tr_max_pending_barriers];
+    tr_texture*                         pending_textures[tr_max_pending_barriers];
+    VkPipelineStageFlags                vk_pending_src_stage_mask;
+    VkPipelineStageFlags                vk_pending_dst_stage_mask;
+    // Transitions queued and barriers recorded since tr_begin_cmd
+    uint32_t                            transition_count;
+    uint32_t                            barrier_count;
 } tr_cmd;
 
 typedef struct tr_buffer {
     tr_renderer*                        renderer;
     tr_buffer_usage                     usage;
+    // Usage the last recorded transition left the buffer in, starts as the
+    // creation usage. That may combine several bits on purpose: the first
+    // transition then waits on every stage the buffer could have been used in.
+    tr_buffer_usage                     current_usage;
     uint64_t                            size;
     bool                                host_visible;
     tr_index_type                       index_type;
@@ -490,18 +745,27 @@ typedef struct tr_buffer {
     void*                               cpu_mapped_address;
     VkBuffer                            vk_buffer;
     VkDeviceMemory                      vk_memory;
+    tr_memory_allocation                vk_allocation;
     // Used for uniform and storage buffers
     VkDescriptorBufferInfo              vk_buffer_info;
     // Used for uniform texel and storage texel buffers
     VkBufferView                        vk_buffer_view;
     // Counter buffer
     tr_buffer*                          counter_buffer;
+    // Slot in the bindless storage buffer table, 0 if not registered
+    uint32_t                            bindless_index;
+    // Unique for the renderer's lifetime and never 0, descriptor sets
+    // compare it to find bindings that changed
+    uint64_t                            vk_resource_id;
 } tr_buffer;
 
 typedef struct tr_texture {
     tr_renderer*                        renderer;
     tr_texture_type                     type;
     tr_texture_usage_flags              usage;
+    // Usage the last recorded transition or render pass left the texture in,
+    // starts at tr_texture_usage_undefined
+    tr_texture_usage                    current_usage;
     uint32_t                            width;
     uint32_t                            height;
     uint32_t                            depth;
@@ -515,15 +779,24 @@ typedef struct tr_texture {
     uint32_t                            owns_image;
     VkImage                             vk_image;
     VkDeviceMemory                      vk_memory;
+    tr_memory_allocation                vk_allocation;
     VkImageView                         vk_image_view;
     VkImageAspectFlags                  vk_aspect_mask;
     VkDescriptorImageInfo               vk_texture_view;
+    // Slot in the bindless texture table, 0 if not registered
+    uint32_t                            bindless_index;
+    // See tr_buffer::vk_resource_id
+    uint64_t                            vk_resource_id;
 } tr_texture;
 
 typedef struct tr_sampler {
     tr_renderer*                        renderer;
     VkSampler                           vk_sampler;
     VkDescriptorImageInfo               vk_sampler_view;
+    // Slot in the bindless sampler table, 0 if not registered
+    uint32_t                            bindless_index;
+    // See tr_buffer::vk_resource_id
+    uint64_t                            vk_resource_id;
 } tr_sampler;
 
 typedef struct tr_shader_program {
@@ -541,6 +814,7 @@ typedef struct tr_shader_program {
     const char*                         geom_entry_point;
     const char*                         frag_entry_point;
     const char*                         comp_entry_point;
+    uint64_t                            vk_resource_id;
 } tr_shader_program;
 
 typedef struct tr_vertex_attrib {
@@ -551,6 +825,8 @@ typedef struct tr_vertex_attrib {
     uint32_t                            binding;
     uint32_t                            location;
     uint32_t                            offset;
+    // Must match for every attrib in the same binding
+    tr_vertex_input_rate                input_rate;
 } tr_vertex_attrib;
 
 typedef struct tr_vertex_layout {
@@ -558,20 +834,113 @@ typedef struct tr_vertex_layout {
     tr_vertex_attrib                    attribs[tr_max_vertex_attribs];
 } tr_vertex_layout;
 
+// Argument layouts read from indirect buffers, same as the Vulkan and D3D12 ones
+typedef struct tr_draw_indirect_args {
+    uint32_t                            vertex_count;
+    uint32_t                            instance_count;
+    uint32_t                            first_vertex;
+    uint32_t                            first_instance;
+} tr_draw_indirect_args;
+
+typedef struct tr_draw_indexed_indirect_args {
+    uint32_t                            index_count;
+    uint32_t                            instance_count;
+    uint32_t                            first_index;
+    int32_t                             vertex_offset;
+    uint32_t                            first_instance;
+} tr_draw_indexed_indirect_args;
+
+typedef struct tr_dispatch_indirect_args {
+    uint32_t                            group_count_x;
+    uint32_t                            group_count_y;
+    uint32_t                            group_count_z;
+} tr_dispatch_indirect_args;
+
+typedef struct tr_push_constant_range {
+    tr_shader_stage                     shader_stages;
+    // Byte offset and size, both multiples of 4
+    uint32_t                            offset;
+    uint32_t                            size;
+    // HLSL register of the root constants in D3D12, unused in Vulkan
+    uint32_t                            binding;
+} tr_push_constant_range;
+
+typedef struct tr_specialization_constant {
+    uint32_t                            constant_id;
+    union {
+        uint32_t                        uint_value;
+        int32_t                         int_value;
+        float                           float_value;
+        // Write 0 or 1, booleans are 32-bit in SPIR-V
+        uint32_t                        bool_value;
+    };
+} tr_specialization_constant;
+
 typedef struct tr_pipeline_settings {
     tr_primitive_topo                   primitive_topo;
     tr_cull_mode                        cull_mode;
     tr_front_face                       front_face;
     bool                                depth;
     tr_tessellation_domain_origin       tessellation_domain_origin;
+    // Added to the pipeline layout, there's no shader reflection so they're explicit
+    uint32_t                            push_constant_range_count;
+    tr_push_constant_range              push_constant_ranges[tr_max_push_constant_ranges];
+    // Applied to every shader stage, constant ids a stage doesn't declare are ignored
+    uint32_t                            specialization_constant_count;
+    tr_specialization_constant          specialization_constants[tr_max_specialization_constants];
 } tr_pipeline_settings;
 
+// Everything that goes into a VkPipeline in a compact form. Keys are
+// memset before they're filled in so they can be hashed and compared as
+// bytes. Semantic names are unused in Vulkan, so they're left out of the
+// vertex attribs. Render targets match by render pass compatibility.
+typedef struct tr_pipeline_key {
+    uint64_t                            shader_program_id;
+    VkDescriptorSetLayout               set_layouts[tr_max_descriptor_sets];
+    uint32_t                            type;
+    uint32_t                            descriptor_set_count;
+    uint32_t                            color_format;
+    uint32_t                            color_attachment_count;
+    uint32_t                            depth_stencil_format;
+    uint32_t                            sample_count;
+    uint32_t                            primitive_topo;
+    uint32_t                            cull_mode;
+    uint32_t                            front_face;
+    uint32_t                            depth;
+    uint32_t                            tessellation_domain_origin;
+    uint32_t                            push_constant_range_count;
+    // Shader stages, offset and size of each range
+    uint32_t                            push_constant_ranges[tr_max_push_constant_ranges][3];
+    uint32_t                            specialization_constant_count;
+    // Constant id and value bits of each constant
+    uint32_t                            specialization_constants[tr_max_specialization_constants][2];
+    uint32_t                            vertex_attrib_count;
+    // Format, binding, location, offset and input rate of each attrib
+    uint32_t                            vertex_attribs[tr_max_vertex_attribs][5];
+} tr_pipeline_key;
+
 typedef struct tr_pipeline {
     tr_renderer*                        renderer;
     tr_pipeline_settings                settings;
     tr_pipeline_type                    type;
+    // Set N of the layout comes from the Nth descriptor set passed at creation
+    uint32_t                            descriptor_set_count;
+    // Shared with every pipeline that has the same layout
+    tr_pipeline_layout_entry*           vk_pipeline_layout_entry;
     VkPipelineLayout                    vk_pipeline_layout;
     VkPipeline                          vk_pipeline;
+    // Pipelines from tr_create_pipeline_async, ready is latched to 1 by the
+    // worker under the pool's lock and read atomically so binds don't lock.
+    // Binding a pipeline that isn't ready binds the fallback instead, or
+    // skips draws if there's none.
+    bool                                async;
+    volatile long                       ready;
+    tr_pipeline*                        fallback;
+    // Creates with the same key share the pipeline, destroys release a reference
+    uint32_t                            ref_count;
+    tr_pipeline_key                     vk_pipeline_key;
+    uint64_t                            vk_pipeline_key_hash;
+    tr_pipeline*                        next;
 } tr_pipeline;
 
 typedef struct tr_render_target {
@@ -599,6 +968,49 @@ typedef struct tr_mesh {
     tr_pipeline*                        pipeline;
 } tr_mesh;
 
+typedef struct tr_upload_context {
+    tr_renderer*                        renderer;
+    tr_queue*                           queue;
+    // Persistently mapped staging ring. head and tail are running byte 
+    // counts, the position in the staging buffer is (count % size).
+    tr_buffer*                          staging_buffer;
+    uint64_t                            head;
+    uint64_t                            tail;
+    // Copies are recorded into the current batch until it's flushed. A 
+    // flushed batch is only waited on when its staging space is needed again.
+    tr_cmd_pool*                        cmd_pool;
+    tr_cmd*                             batch_cmds[tr_max_upload_batches];
+    tr_fence*                           batch_fences[tr_max_upload_batches];
+    uint64_t                            batch_heads[tr_max_upload_batches];
+    bool                                batch_pending[tr_max_upload_batches];
+    uint32_t                            batch_index;
+    bool                                recording;
+} tr_upload_context;
+
+typedef struct tr_frame_context {
+    tr_renderer*                        renderer;
+    tr_queue*                           queue;
+    uint32_t                            frame_count;
+    // Slot used by the current frame, advanced by tr_end_frame
+    uint32_t                            frame_index;
+    uint64_t                            frame_number;
+    // Each slot has its own pool so a slot's commands can be reset while 
+    // the other slots are still executing.
+    tr_cmd_pool*                        cmd_pools[tr_max_frames_in_flight];
+    tr_cmd*                             cmds[tr_max_frames_in_flight];
+    // A slot's fence is waited on before the slot is recorded into again
+    tr_fence*                           render_complete_fences[tr_max_frames_in_flight];
+    bool                                fence_pending[tr_max_frames_in_flight];
+    tr_semaphore*                       image_acquired_semaphores[tr_max_frames_in_flight];
+    // Present waits on these, so they belong to a swapchain image rather than a
+    // slot. A slot's semaphore could still be pending on an image that hasn't
+    // been presented yet when the slot comes around again.
+    uint32_t                            image_count;
+    tr_semaphore**                      render_complete_semaphores;
+    // Transient descriptor sets for a slot, reset once the slot's fence is reached
+    tr_descriptor_allocator*            descriptor_allocators[tr_max_frames_in_flight];
+} tr_frame_context;
+
 typedef bool(*tr_image_resize_uint8_fn)(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, 
                                         uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, uint8_t* p_dst_data,
                                         uint32_t channel_cout, void* p_user_data);
@@ -613,14 +1025,23 @@ tr_api_export void tr_destroy_renderer(tr_renderer* p_renderer);
 
 tr_api_export void tr_create_fence(tr_renderer* p_renderer, tr_fence** pp_fence);
 tr_api_export void tr_destroy_fence(tr_renderer* p_renderer, tr_fence* p_fence);
+tr_api_export void tr_wait_for_fence(tr_renderer* p_renderer, tr_fence* p_fence);
 
 tr_api_export void tr_create_semaphore(tr_renderer* p_renderer, tr_semaphore** pp_semaphore);
 tr_api_export void tr_destroy_semaphore(tr_renderer* p_renderer, tr_semaphore* p_semaphore);
 
+tr_api_export void tr_create_descriptor_allocator(tr_renderer* p_renderer, bool transient, uint32_t sets_per_pool, tr_descriptor_allocator** pp_descriptor_allocator);
+tr_api_export void tr_destroy_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator);
+tr_api_export void tr_reset_descriptor_allocator(tr_descriptor_allocator* p_descriptor_allocator);
+
 tr_api_export void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count, const tr_descriptor* descriptors, tr_descriptor_set** pp_descriptor_set);
+tr_api_export void tr_create_descriptor_set_from_allocator(tr_descriptor_allocator* p_descriptor_allocator, uint32_t descriptor_count, const tr_descriptor* descriptors, tr_descriptor_set** pp_descriptor_set);
 tr_api_export void tr_destroy_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
 
 tr_api_export void tr_create_cmd_pool(tr_renderer* p_renderer, tr_queue* p_queue, bool transient, tr_cmd_pool** pp_cmd_pool);
+tr_api_export void tr_create_cmd_pool_per_frame(tr_renderer* p_renderer, tr_queue* p_queue, tr_cmd_pool** pp_cmd_pool);
+// Every command buffer from the pool must have finished executing
+tr_api_export void tr_reset_cmd_pool(tr_cmd_pool* p_cmd_pool);
 tr_api_export void tr_destroy_cmd_pool(tr_renderer* p_renderer, tr_cmd_pool* p_cmd_pool);
 
 tr_api_export void tr_create_cmd(tr_cmd_pool* p_cmd_pool, bool secondary, tr_cmd** pp_cmd);
@@ -632,6 +1053,7 @@ tr_api_export void tr_destroy_cmd_n(tr_cmd_pool* p_cmd_pool, uint32_t cmd_count,
 tr_api_export void tr_create_buffer(tr_renderer* p_renderer, tr_buffer_usage usage, uint64_t size, bool host_visible, tr_buffer** pp_buffer);
 tr_api_export void tr_create_index_buffer(tr_renderer*p_renderer, uint64_t size, bool host_visible, tr_index_type index_type, tr_buffer** pp_buffer);
 tr_api_export void tr_create_uniform_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, tr_buffer** pp_buffer);
+tr_api_export void tr_create_uniform_buffer_dynamic(tr_renderer* p_renderer, uint64_t element_size, uint64_t element_count, bool host_visible, tr_buffer** pp_buffer);
 tr_api_export void tr_create_vertex_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, uint32_t vertex_stride, tr_buffer** pp_buffer);
 tr_api_export void tr_create_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_buffer);
 tr_api_export void tr_create_rw_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_counter_buffer, tr_buffer** pp_buffer);
@@ -653,6 +1075,11 @@ tr_api_export void tr_destroy_shader_program(tr_renderer* p_renderer, tr_shader_
 
 tr_api_export void tr_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* p_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline);
 tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline);
+tr_api_export void tr_create_pipeline_n(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline);
+tr_api_export void tr_create_compute_pipeline_n(tr_renderer* p_renderer, tr_shader_program* p_shader_program, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline);
+tr_api_export void tr_create_pipeline_async(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_fallback_pipeline, tr_pipeline** pp_pipeline);
+tr_api_export bool tr_pipeline_is_ready(tr_pipeline* p_pipeline);
+tr_api_export void tr_wait_pipeline(tr_pipeline* p_pipeline);
 tr_api_export void tr_destroy_pipeline(tr_renderer* p_renderer, tr_pipeline* p_pipeline);
 
 tr_api_export void tr_create_render_target(tr_renderer* p_renderer, uint32_t width, uint32_t height, tr_sample_count sample_count, tr_format color_format, uint32_t color_attachment_count, const tr_clear_value* color_clear_values, tr_format depth_stencil_format, const tr_clear_value* depth_stencil_clear_value, tr_render_target** pp_render_target);
@@ -661,9 +1088,19 @@ tr_api_export void tr_destroy_render_target(tr_renderer* p_renderer, tr_render_t
 tr_api_export void tr_update_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
 
 tr_api_export void tr_begin_cmd(tr_cmd* p_cmd);
+tr_api_export void tr_begin_cmd_usage(tr_cmd* p_cmd, tr_cmd_usage_flags usage);
 tr_api_export void tr_end_cmd(tr_cmd* p_cmd);
+// Call after recording Vulkan commands into vk_cmd_buf directly
+tr_api_export void tr_cmd_invalidate_state(tr_cmd* p_cmd);
 tr_api_export void tr_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_target);
 tr_api_export void tr_cmd_end_render(tr_cmd* p_cmd);
+// Secondary command buffers recorded inside p_render_target's render pass.
+// They inherit no state, set the viewport and scissor in each one.
+tr_api_export void tr_begin_cmd_secondary(tr_cmd* p_cmd, tr_render_target* p_render_target);
+tr_api_export void tr_begin_cmd_secondary_usage(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_cmd_usage_flags usage);
+// Begins a render pass whose contents come from tr_cmd_execute only
+tr_api_export void tr_cmd_begin_render_secondary(tr_cmd* p_cmd, tr_render_target* p_render_target);
+tr_api_export void tr_cmd_execute(tr_cmd* p_cmd, uint32_t cmd_count, tr_cmd** pp_cmds);
 tr_api_export void tr_cmd_set_viewport(tr_cmd* p_cmd, float x, float, float width, float height, float min_depth, float max_depth);
 tr_api_export void tr_cmd_set_scissor(tr_cmd* p_cmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 tr_api_export void tr_cmd_set_line_width(tr_cmd* p_cmd, float line_width);
@@ -671,23 +1108,60 @@ tr_api_export void tr_cmd_clear_color_attachment(tr_cmd* p_cmd, uint32_t attachm
 tr_api_export void tr_cmd_clear_depth_stencil_attachment(tr_cmd* p_cmd, const tr_clear_value* clear_value);
 tr_api_export void tr_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline);
 tr_api_export void tr_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set);
+tr_api_export void tr_cmd_bind_descriptor_sets_dynamic(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets);
+tr_api_export void tr_cmd_bind_descriptor_sets_n(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t first_set, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets);
 tr_api_export void tr_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer);
+tr_api_export void tr_cmd_push_constants(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t offset, uint32_t size, const void* p_values);
 tr_api_export void tr_cmd_bind_vertex_buffers(tr_cmd* p_cmd, uint32_t buffer_count, tr_buffer** pp_buffers);
 tr_api_export void tr_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex);
 tr_api_export void tr_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index);
+tr_api_export void tr_cmd_draw_instanced(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance);
+tr_api_export void tr_cmd_draw_indexed_instanced(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance);
 tr_api_export void tr_cmd_draw_mesh(tr_cmd* p_cmd, const tr_mesh* p_mesh);
 tr_api_export void tr_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
 tr_api_export void tr_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
 tr_api_export void tr_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage);
 tr_api_export void tr_cmd_depth_stencil_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage);
+// Transitions from the usage the resource was last left in. Usage is tracked
+// in recording order, so command buffers that touch the same resource must be
+// recorded in the order they're submitted.
+tr_api_export void tr_cmd_transition_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage new_usage);
+tr_api_export void tr_cmd_transition_image(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage new_usage);
+// Records the queued transitions now, commands that need them flush on their own
+tr_api_export void tr_cmd_flush_barriers(tr_cmd* p_cmd);
 tr_api_export void tr_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+// Indirect buffers need tr_buffer_usage_indirect, stride is the distance between
+// argument structs and is 0 for tightly packed arguments. first_instance in the
+// arguments must be 0 unless vk_active_gpu_features.drawIndirectFirstInstance is set.
+tr_api_export void tr_cmd_draw_indirect(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset, uint32_t draw_count, uint32_t stride);
+tr_api_export void tr_cmd_draw_indexed_indirect(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset, uint32_t draw_count, uint32_t stride);
+// The draw count is read from a uint32_t in p_count_buffer and clamped to max_draw_count,
+// requires tr_renderer::vk_device_ext_VK_KHR_draw_indirect_count
+tr_api_export void tr_cmd_draw_indirect_count(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset, tr_buffer* p_count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride);
+tr_api_export void tr_cmd_draw_indexed_indirect_count(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset, tr_buffer* p_count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride);
+tr_api_export void tr_cmd_dispatch_indirect(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset);
 tr_api_export void tr_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t height, uint32_t row_pitch, uint64_t buffer_offset, uint32_t mip_level, tr_buffer* p_buffer, tr_texture* p_texture);
 
 tr_api_export void tr_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence);
-tr_api_export void tr_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores);
+tr_api_export void tr_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores, tr_fence* p_signal_fence);
 tr_api_export void tr_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores);
 tr_api_export void tr_queue_wait_idle(tr_queue* p_queue);
 
+tr_api_export void tr_create_upload_context(tr_renderer* p_renderer, tr_queue* p_queue, uint64_t staging_size, tr_upload_context** pp_upload_context);
+tr_api_export void tr_destroy_upload_context(tr_renderer* p_renderer, tr_upload_context* p_upload_context);
+tr_api_export void tr_upload_transition_buffer(tr_upload_context* p_upload_context, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
+tr_api_export void tr_upload_transition_image(tr_upload_context* p_upload_context, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
+tr_api_export void tr_upload_set_storage_buffer_count(tr_upload_context* p_upload_context, uint64_t count_offset, uint32_t count, tr_buffer* p_buffer);
+tr_api_export void tr_upload_clear_buffer(tr_upload_context* p_upload_context, tr_buffer* p_buffer);
+tr_api_export void tr_upload_update_buffer(tr_upload_context* p_upload_context, uint64_t size, const void* p_src_data, tr_buffer* p_buffer);
+tr_api_export void tr_upload_update_texture_uint8(tr_upload_context* p_upload_context, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data);
+tr_api_export void tr_upload_flush(tr_upload_context* p_upload_context, bool wait);
+
+tr_api_export void tr_create_frame_context(tr_renderer* p_renderer, tr_queue* p_queue, uint32_t frame_count, tr_frame_context** pp_frame_context);
+tr_api_export void tr_destroy_frame_context(tr_renderer* p_renderer, tr_frame_context* p_frame_context);
+tr_api_export void tr_begin_frame(tr_frame_context* p_frame_context, tr_cmd** pp_cmd, tr_render_target** pp_render_target);
+tr_api_export void tr_end_frame(tr_frame_context* p_frame_context);
+
 tr_api_export void tr_render_target_set_color_clear_value(tr_render_target* p_render_target, uint32_t attachment_index, float r, float g, float b, float a);
 tr_api_export void tr_render_target_set_depth_stencil_clear_value(tr_render_target* p_render_target, float depth, uint8_t stencil);
 
@@ -701,6 +1175,8 @@ tr_api_export tr_format          tr_util_from_vk_format(VkFormat fomat);
 tr_api_export uint32_t           tr_util_format_stride(tr_format format);
 tr_api_export uint32_t           tr_util_format_channel_count(tr_format format);
 tr_api_export VkShaderStageFlags tr_util_to_vk_shader_stages(tr_shader_stage shader_stages);
+// The upload helpers below record into an upload context owned by p_queue. The recorded work
+// is submitted ahead of the next tr_queue_submit or tr_queue_wait_idle on that queue.
 tr_api_export void               tr_util_transition_buffer(tr_queue* p_queue, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
 tr_api_export void               tr_util_transition_image(tr_queue* p_queue, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
 tr_api_export void               tr_util_set_storage_buffer_count(tr_queue* p_queue, uint64_t count_offset, uint32_t count, tr_buffer* p_buffer);
@@ -753,35 +1229,62 @@ static inline uint32_t tr_round_up(uint32_t value, uint32_t multiple)
     return ((value + multiple - 1) / multiple) * multiple;
 }
 
+static inline uint64_t tr_round_up_64(uint64_t value, uint64_t multiple)
+{
+    assert(multiple);
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
 // Internal utility functions (may become external one day)
 VkSampleCountFlagBits tr_util_to_vk_sample_count(tr_sample_count sample_count);
 VkBufferUsageFlags    tr_util_to_vk_buffer_usage(tr_buffer_usage usage);
+VkDescriptorType      tr_util_to_vk_descriptor_type(tr_descriptor_type type);
 VkImageUsageFlags     tr_util_to_vk_image_usage(tr_texture_usage usage);
 VkImageLayout         tr_util_to_vk_image_layout(tr_texture_usage usage);
 VkImageAspectFlags    tr_util_vk_determine_aspect_mask(VkFormat format);
 bool                  tr_util_vk_get_memory_type(const VkPhysicalDeviceMemoryProperties* mem_props,  uint32_t type_bits, VkMemoryPropertyFlags flags, uint32_t* p_index);
 VkFormatFeatureFlags  tr_util_vk_image_usage_to_format_features(VkImageUsageFlags usage);
+void                  tr_internal_util_upload_flush(tr_queue* p_queue, bool wait);
 
 // Internal init functions
 void tr_internal_vk_create_instance(const char* app_name, tr_renderer* p_renderer);
 void tr_internal_vk_create_surface(tr_renderer* p_renderer);
 void tr_internal_vk_create_device(tr_renderer* p_renderer);
 void tr_internal_vk_create_swapchain(tr_renderer* p_renderer);
+void tr_internal_vk_create_headless_swapchain(tr_renderer* p_renderer);
 void tr_internal_create_swapchain_renderpass(tr_renderer* p_renderer);
 void tr_internal_vk_create_swapchain_renderpass(tr_renderer* p_renderer);
 void tr_internal_vk_destroy_instance(tr_renderer* p_renderer);
 void tr_internal_vk_destroy_surface(tr_renderer* p_renderer);
 void tr_internal_vk_destroy_device(tr_renderer* p_renderer);
+void tr_internal_vk_create_pipeline_cache(tr_renderer* p_renderer);
+void tr_internal_vk_destroy_pipeline_cache(tr_renderer* p_renderer);
+void tr_internal_vk_destroy_layout_caches(tr_renderer* p_renderer);
+void tr_internal_create_pipeline_worker_pool(tr_renderer* p_renderer);
+void tr_internal_destroy_pipeline_worker_pool(tr_renderer* p_renderer);
 void tr_internal_vk_destroy_swapchain(tr_renderer* p_renderer);
 
+// Internal memory functions
+void tr_internal_vk_allocate_memory(tr_renderer* p_renderer, const VkMemoryRequirements* p_mem_reqs, VkMemoryPropertyFlags mem_flags, bool linear, tr_memory_allocation* p_allocation);
+void tr_internal_vk_free_memory(tr_renderer* p_renderer, tr_memory_allocation* p_allocation);
+void tr_internal_vk_destroy_memory_blocks(tr_renderer* p_renderer);
+
 // Internal create functions
 void tr_internal_vk_create_fence(tr_renderer *p_renderer, tr_fence* p_fence);
 void tr_internal_vk_destroy_fence(tr_renderer *p_renderer, tr_fence* p_fence);
+void tr_internal_vk_wait_for_fence(tr_renderer *p_renderer, tr_fence* p_fence);
 void tr_internal_vk_create_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore);
 void tr_internal_vk_destroy_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore);
+void tr_internal_vk_destroy_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator);
+void tr_internal_vk_reset_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator);
 void tr_internal_vk_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
 void tr_internal_vk_destroy_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
+void tr_internal_vk_create_bindless_descriptor_set(tr_renderer* p_renderer);
+void tr_internal_vk_destroy_bindless_descriptor_set(tr_renderer* p_renderer);
+uint32_t tr_internal_vk_register_bindless(tr_renderer* p_renderer, tr_bindless_table_type table_type, const VkDescriptorImageInfo* p_image_info, const VkDescriptorBufferInfo* p_buffer_info);
+void tr_internal_vk_unregister_bindless(tr_renderer* p_renderer, tr_bindless_table_type table_type, uint32_t index);
 void tr_internal_vk_create_cmd_pool(tr_renderer *p_renderer, tr_queue* p_queue, bool transient, tr_cmd_pool* p_cmd_pool);
+void tr_internal_vk_reset_cmd_pool(tr_cmd_pool* p_cmd_pool);
 void tr_internal_vk_destroy_cmd_pool(tr_renderer *p_renderer, tr_cmd_pool* p_cmd_pool);
 void tr_internal_vk_create_cmd(tr_cmd_pool *p_cmd_pool, bool secondary, tr_cmd* p_cmd);
 void tr_internal_vk_destroy_cmd(tr_cmd_pool *p_cmd_pool, tr_cmd* p_cmd);
@@ -791,9 +1294,13 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
 void tr_internal_vk_destroy_texture(tr_renderer* p_renderer, tr_texture* p_texture);
 void tr_internal_vk_create_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler);
 void tr_internal_vk_destroy_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler);
-void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* pp_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
-void tr_internal_vk_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
+void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
+void tr_internal_vk_create_pipeline_layout(tr_renderer* p_renderer, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
+void tr_internal_vk_compile_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, VkRenderPass vk_render_pass, tr_sample_count sample_count, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
+void tr_internal_vk_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
 void tr_internal_vk_destroy_pipeline(tr_renderer* p_renderer, tr_pipeline* p_pipeline);
+void tr_internal_vk_make_pipeline_key(tr_renderer* p_renderer, tr_pipeline_type type, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline_key* p_key, uint64_t* p_hash);
+tr_pipeline* tr_internal_vk_find_pipeline(tr_renderer* p_renderer, const tr_pipeline_key* p_key, uint64_t hash);
 void tr_internal_vk_create_shader_program(tr_renderer* p_renderer, uint32_t vert_size, const void* vert_code, const char* vert_enpt, uint32_t tesc_size, const void* tesc_code, const char* tesc_enpt, uint32_t tese_size, const void* tese_code, const char* tese_enpt, uint32_t geom_size, const void* geom_code, const char* geom_enpt, uint32_t frag_size, const void* frag_code, const char* frag_enpt, uint32_t comp_size, const void* comp_code, const char* comp_enpt, tr_shader_program* p_shader_program);
 void tr_internal_vk_destroy_shader_program(tr_renderer* p_renderer, tr_shader_program* p_shader_program);
 void tr_internal_vk_create_render_target(tr_renderer* p_renderer, bool is_swapchain, tr_render_target* p_render_target);
@@ -803,9 +1310,10 @@ void tr_internal_vk_destroy_render_target(tr_renderer* p_renderer, tr_render_tar
 void tr_internal_vk_update_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
 
 // Internal command buffer functions
-void tr_internal_vk_begin_cmd(tr_cmd* p_cmd);
+void tr_internal_vk_begin_cmd(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_cmd_usage_flags usage);
 void tr_internal_vk_end_cmd(tr_cmd* p_cmd);
-void tr_internal_vk_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_target);
+void tr_internal_vk_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_target, VkSubpassContents vk_contents);
+void tr_internal_vk_cmd_execute(tr_cmd* p_cmd, uint32_t cmd_count, tr_cmd** pp_cmds);
 void tr_internal_vk_cmd_end_render(tr_cmd* p_cmd);
 void tr_internal_vk_cmd_set_viewport(tr_cmd* p_cmd, float x, float, float width, float height, float min_depth, float max_depth);
 void tr_internal_vk_cmd_set_scissor(tr_cmd* p_cmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
@@ -813,21 +1321,26 @@ void tr_internal_vk_cmd_set_line_width(tr_cmd* p_cmd, float line_width);
 void tr_cmd_internal_vk_cmd_clear_color_attachment(tr_cmd* p_cmd, uint32_t attachment_index, const tr_clear_value* clear_value);
 void tr_cmd_internal_vk_cmd_clear_depth_stencil_attachment(tr_cmd* p_cmd, const tr_clear_value* clear_value);
 void tr_internal_vk_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline);
-void tr_internal_vk_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set);
+void tr_internal_vk_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t first_set, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets);
 void tr_internal_vk_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer);
+void tr_internal_vk_cmd_push_constants(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t offset, uint32_t size, const void* p_values);
 void tr_internal_vk_cmd_bind_vertex_buffers(tr_cmd* p_cmd, uint32_t buffer_count, tr_buffer** pp_buffers);
-void tr_internal_vk_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex);
-void tr_internal_vk_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index);
+void tr_internal_vk_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance);
+void tr_internal_vk_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance);
 void tr_internal_vk_cmd_draw_mesh(tr_cmd* p_cmd, const tr_mesh* p_mesh);
 void tr_internal_vk_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
 void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
 void tr_internal_vk_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage);
+void tr_internal_vk_cmd_flush_barriers(tr_cmd* p_cmd);
 void tr_internal_vk_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+void tr_internal_vk_cmd_draw_indirect(tr_cmd* p_cmd, bool indexed, tr_buffer* p_buffer, uint64_t offset, uint32_t draw_count, uint32_t stride);
+void tr_internal_vk_cmd_draw_indirect_count(tr_cmd* p_cmd, bool indexed, tr_buffer* p_buffer, uint64_t offset, tr_buffer* p_count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride);
+void tr_internal_vk_cmd_dispatch_indirect(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset);
 void tr_internal_vk_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t height, uint32_t row_pitch, uint64_t buffer_offset, uint32_t mip_level, tr_buffer* p_buffer, tr_texture* p_texture);
 
 // Internal queue/swapchain functions
 void tr_internal_vk_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence);
-void tr_internal_vk_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores);
+void tr_internal_vk_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores, tr_fence* p_signal_fence);
 void tr_internal_vk_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores);
 void tr_internal_vk_queue_wait_idle(tr_queue* p_queue);
 
@@ -1065,6 +1578,141 @@ typedef struct tr_internal_data {
 
 static tr_internal_data* s_tr_internal = NULL;
 
+// Threading primitives for the pipeline worker pool
+#if defined(TINY_RENDERER_MSW)
+typedef CRITICAL_SECTION   tr_internal_mutex;
+typedef CONDITION_VARIABLE tr_internal_cond;
+typedef HANDLE             tr_internal_thread;
+#define TINY_RENDERER_THREAD_FN DWORD WINAPI
+#define TINY_RENDERER_THREAD_RETURN 0
+#else
+#include <pthread.h>
+typedef pthread_mutex_t    tr_internal_mutex;
+typedef pthread_cond_t     tr_internal_cond;
+typedef pthread_t          tr_internal_thread;
+#define TINY_RENDERER_THREAD_FN void*
+#define TINY_RENDERER_THREAD_RETURN NULL
+#endif
+
+static void tr_internal_mutex_init(tr_internal_mutex* p_mutex)
+{
+#if defined(TINY_RENDERER_MSW)
+    InitializeCriticalSection(p_mutex);
+#else
+    int res = pthread_mutex_init(p_mutex, NULL);
+    assert(0 == res);
+#endif
+}
+
+static void tr_internal_mutex_destroy(tr_internal_mutex* p_mutex)
+{
+#if defined(TINY_RENDERER_MSW)
+    DeleteCriticalSection(p_mutex);
+#else
+    pthread_mutex_destroy(p_mutex);
+#endif
+}
+
+static void tr_internal_mutex_lock(tr_internal_mutex* p_mutex)
+{
+#if defined(TINY_RENDERER_MSW)
+    EnterCriticalSection(p_mutex);
+#else
+    pthread_mutex_lock(p_mutex);
+#endif
+}
+
+static void tr_internal_mutex_unlock(tr_internal_mutex* p_mutex)
+{
+#if defined(TINY_RENDERER_MSW)
+    LeaveCriticalSection(p_mutex);
+#else
+    pthread_mutex_unlock(p_mutex);
+#endif
+}
+
+static void tr_internal_cond_init(tr_internal_cond* p_cond)
+{
+#if defined(TINY_RENDERER_MSW)
+    InitializeConditionVariable(p_cond);
+#else
+    int res = pthread_cond_init(p_cond, NULL);
+    assert(0 == res);
+#endif
+}
+
+static void tr_internal_cond_destroy(tr_internal_cond* p_cond)
+{
+#if defined(TINY_RENDERER_MSW)
+    (void)p_cond;
+#else
+    pthread_cond_destroy(p_cond);
+#endif
+}
+
+static void tr_internal_cond_wait(tr_internal_cond* p_cond, tr_internal_mutex* p_mutex)
+{
+#if defined(TINY_RENDERER_MSW)
+    SleepConditionVariableCS(p_cond, p_mutex, INFINITE);
+#else
+    pthread_cond_wait(p_cond, p_mutex);
+#endif
+}
+
+static long tr_internal_atomic_load(volatile long* p_value)
+{
+#if defined(TINY_RENDERER_MSW)
+    return InterlockedCompareExchange(p_value, 0, 0);
+#else
+    return __atomic_load_n(p_value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void tr_internal_atomic_store(volatile long* p_value, long value)
+{
+#if defined(TINY_RENDERER_MSW)
+    InterlockedExchange(p_value, value);
+#else
+    __atomic_store_n(p_value, value, __ATOMIC_RELEASE);
+#endif
+}
+
+static void tr_internal_cond_broadcast(tr_internal_cond* p_cond)
+{
+#if defined(TINY_RENDERER_MSW)
+    WakeAllConditionVariable(p_cond);
+#else
+    pthread_cond_broadcast(p_cond);
+#endif
+}
+
+// Everything a worker needs to compile a pipeline, the shader program and
+// render target must outlive the job.
+typedef struct tr_pipeline_job tr_pipeline_job;
+typedef struct tr_pipeline_job {
+    tr_pipeline*                        pipeline;
+    tr_shader_program*                  shader_program;
+    tr_vertex_layout                    vertex_layout;
+    VkRenderPass                        vk_render_pass;
+    tr_sample_count                     sample_count;
+    tr_pipeline_job*                    next;
+} tr_pipeline_job;
+
+typedef struct tr_pipeline_worker_pool {
+    tr_renderer*                        renderer;
+    tr_internal_mutex                   mutex;
+    // Signaled when a job is queued or the pool shuts down
+    tr_internal_cond                    job_cond;
+    // Signaled when a job finishes
+    tr_internal_cond                    done_cond;
+    // FIFO, jobs are taken from the head
+    tr_pipeline_job*                    job_head;
+    tr_pipeline_job*                    job_tail;
+    bool                                shutdown;
+    uint32_t                            thread_count;
+    tr_internal_thread*                 threads;
+} tr_pipeline_worker_pool;
+
 // Proxy log callback
 static void tr_internal_log(tr_log_type type, const char* msg, const char* component)
 {
@@ -1077,6 +1725,8 @@ static void tr_internal_log(tr_log_type type, const char* msg, const char* compo
 static PFN_vkCreateDebugReportCallbackEXT  trVkCreateDebugReportCallbackEXT  = NULL;
 static PFN_vkDestroyDebugReportCallbackEXT trVkDestroyDebugReportCallbackEXT = NULL;
 static PFN_vkDebugReportMessageEXT         trVkDebugReportMessageEXT         = NULL;
+static PFN_vkCmdDrawIndirectCountKHR        trVkCmdDrawIndirectCountKHR        = NULL;
+static PFN_vkCmdDrawIndexedIndirectCountKHR trVkCmdDrawIndexedIndirectCountKHR = NULL;
 
 // Proxy debug callback for Vulkan layers
 static VKAPI_ATTR VkBool32 VKAPI_CALL tr_internal_debug_report_callback(
@@ -1133,14 +1783,31 @@ void tr_create_renderer(const char *app_name, const tr_renderer_settings* settin
         p_renderer->graphics_queue->renderer = p_renderer;
         p_renderer->present_queue->renderer = p_renderer;
 
+        const bool headless = p_renderer->settings.headless;
+        if (headless) {
+            tr_internal_log(tr_log_type_info, "Headless requested, swapchain render targets are offscreen", "tr_create_renderer");
+        }
+
         // Initialize the Vulkan bits
         {
             tr_internal_vk_create_instance(app_name, p_renderer);
-            tr_internal_vk_create_surface(p_renderer);
+            if (! headless) {
+                tr_internal_vk_create_surface(p_renderer);
+            }
             tr_internal_vk_create_device(p_renderer);
-            tr_internal_vk_create_swapchain(p_renderer);
+            tr_internal_vk_create_pipeline_cache(p_renderer);
+            tr_internal_vk_create_bindless_descriptor_set(p_renderer);
+            if (headless) {
+                tr_internal_vk_create_headless_swapchain(p_renderer);
+            }
+            else {
+                tr_internal_vk_create_swapchain(p_renderer);
+            }
         }
 
+        // Shared allocator for persistent descriptor sets
+        tr_create_descriptor_allocator(p_renderer, false, 0, &(p_renderer->descriptor_allocator));
+
         // Allocate and configure render target objects
         tr_internal_create_swapchain_renderpass(p_renderer);
 
@@ -1242,9 +1909,48 @@ void tr_destroy_renderer(tr_renderer* p_renderer)
         }
     }
 
+    // Destroy upload contexts used by the tr_util_* helpers
+    if (NULL != p_renderer->graphics_queue->util_upload_context) {
+        tr_destroy_upload_context(p_renderer, p_renderer->graphics_queue->util_upload_context);
+        p_renderer->graphics_queue->util_upload_context = NULL;
+    }
+    if (NULL != p_renderer->present_queue->util_upload_context) {
+        tr_destroy_upload_context(p_renderer, p_renderer->present_queue->util_upload_context);
+        p_renderer->present_queue->util_upload_context = NULL;
+    }
+
+    // Destroy the shared descriptor allocator along with any sets still in it
+    if (NULL != p_renderer->descriptor_allocator) {
+        tr_destroy_descriptor_allocator(p_renderer, p_renderer->descriptor_allocator);
+        p_renderer->descriptor_allocator = NULL;
+    }
+
+    // Destroy the bindless tables, slots still registered are dropped with them
+    tr_internal_vk_destroy_bindless_descriptor_set(p_renderer);
+
+    // Let the workers finish queued pipelines and stop them
+    if (NULL != p_renderer->pipeline_worker_pool) {
+        tr_internal_destroy_pipeline_worker_pool(p_renderer);
+    }
+
+    // Destroy pipelines that weren't destroyed, then any layouts still referenced
+    while (NULL != p_renderer->vk_pipelines) {
+        tr_pipeline* p_pipeline = p_renderer->vk_pipelines;
+        p_renderer->vk_pipelines = p_pipeline->next;
+        tr_internal_vk_destroy_pipeline(p_renderer, p_pipeline);
+        TINY_RENDERER_SAFE_FREE(p_pipeline);
+    }
+    tr_internal_vk_destroy_layout_caches(p_renderer);
+
+    // Release device memory blocks, any resource still alive at this point leaks its handle
+    tr_internal_vk_destroy_memory_blocks(p_renderer);
+
     // Destroy the Vulkan bits
-    tr_internal_vk_destroy_swapchain(p_renderer);
-    tr_internal_vk_destroy_surface(p_renderer);
+    if (! p_renderer->settings.headless) {
+        tr_internal_vk_destroy_swapchain(p_renderer);
+        tr_internal_vk_destroy_surface(p_renderer);
+    }
+    tr_internal_vk_destroy_pipeline_cache(p_renderer);
     tr_internal_vk_destroy_device(p_renderer);
     tr_internal_vk_destroy_instance(p_renderer);
 
@@ -1281,6 +1987,14 @@ void tr_destroy_fence(tr_renderer *p_renderer, tr_fence* p_fence)
     TINY_RENDERER_SAFE_FREE(p_fence);
 }
 
+void tr_wait_for_fence(tr_renderer* p_renderer, tr_fence* p_fence)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_fence);
+
+    tr_internal_vk_wait_for_fence(p_renderer, p_fence);
+}
+
 void tr_create_semaphore(tr_renderer *p_renderer, tr_semaphore** pp_semaphore)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -1303,10 +2017,51 @@ void tr_destroy_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore)
     TINY_RENDERER_SAFE_FREE(p_semaphore);
 }
 
+void tr_create_descriptor_allocator(tr_renderer* p_renderer, bool transient, uint32_t sets_per_pool, tr_descriptor_allocator** pp_descriptor_allocator)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+
+    tr_descriptor_allocator* p_descriptor_allocator = (tr_descriptor_allocator*)calloc(1, sizeof(*p_descriptor_allocator));
+    assert(NULL != p_descriptor_allocator);
+
+    p_descriptor_allocator->renderer      = p_renderer;
+    p_descriptor_allocator->transient     = transient;
+    p_descriptor_allocator->sets_per_pool = (sets_per_pool > 0) ? sets_per_pool : TINY_RENDERER_DESCRIPTOR_POOL_SETS;
+
+    // Pools are created on demand by the first allocation of each size class
+
+    *pp_descriptor_allocator = p_descriptor_allocator;
+}
+
+void tr_destroy_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_descriptor_allocator);
+
+    tr_internal_vk_destroy_descriptor_allocator(p_renderer, p_descriptor_allocator);
+
+    TINY_RENDERER_SAFE_FREE(p_descriptor_allocator);
+}
+
+void tr_reset_descriptor_allocator(tr_descriptor_allocator* p_descriptor_allocator)
+{
+    assert(NULL != p_descriptor_allocator);
+    assert(p_descriptor_allocator->transient);
+
+    tr_internal_vk_reset_descriptor_allocator(p_descriptor_allocator->renderer, p_descriptor_allocator);
+}
+
 void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count, const tr_descriptor* p_descriptors, tr_descriptor_set** pp_descriptor_set)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
 
+    tr_create_descriptor_set_from_allocator(p_renderer->descriptor_allocator, descriptor_count, p_descriptors, pp_descriptor_set);
+}
+
+void tr_create_descriptor_set_from_allocator(tr_descriptor_allocator* p_descriptor_allocator, uint32_t descriptor_count, const tr_descriptor* p_descriptors, tr_descriptor_set** pp_descriptor_set)
+{
+    assert(NULL != p_descriptor_allocator);
+
     tr_descriptor_set* p_descriptor_set = (tr_descriptor_set*)calloc(1, sizeof(*p_descriptor_set));
     assert(NULL != p_descriptor_set);
 
@@ -1316,7 +2071,15 @@ void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count
     p_descriptor_set->descriptor_count = descriptor_count;
     memcpy(p_descriptor_set->descriptors, p_descriptors, descriptor_count * sizeof(*(p_descriptor_set->descriptors)));
 
-    tr_internal_vk_create_descriptor_set(p_renderer, p_descriptor_set);
+    for (uint32_t i = 0; i < descriptor_count; ++i) {
+        if (tr_descriptor_type_uniform_buffer_dynamic == p_descriptors[i].type) {
+            p_descriptor_set->dynamic_offset_count += p_descriptors[i].count;
+        }
+    }
+
+    p_descriptor_set->allocator = p_descriptor_allocator;
+
+    tr_internal_vk_create_descriptor_set(p_descriptor_allocator->renderer, p_descriptor_set);
 
     *pp_descriptor_set = p_descriptor_set;
 }
@@ -1347,6 +2110,30 @@ void tr_create_cmd_pool(tr_renderer *p_renderer, tr_queue* p_queue, bool transie
     *pp_cmd_pool = p_cmd_pool;
 }
 
+void tr_create_cmd_pool_per_frame(tr_renderer* p_renderer, tr_queue* p_queue, tr_cmd_pool** pp_cmd_pool)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+
+    tr_cmd_pool* p_cmd_pool = (tr_cmd_pool*)calloc(1, sizeof(*p_cmd_pool));
+    assert(NULL != p_cmd_pool);
+
+    p_cmd_pool->renderer  = p_renderer;
+    p_cmd_pool->per_frame = true;
+
+    // Recorded every frame, so always transient
+    tr_internal_vk_create_cmd_pool(p_renderer, p_queue, true, p_cmd_pool);
+
+    *pp_cmd_pool = p_cmd_pool;
+}
+
+void tr_reset_cmd_pool(tr_cmd_pool* p_cmd_pool)
+{
+    assert(NULL != p_cmd_pool);
+    assert(p_cmd_pool->per_frame);
+
+    tr_internal_vk_reset_cmd_pool(p_cmd_pool);
+}
+
 void tr_destroy_cmd_pool(tr_renderer *p_renderer, tr_cmd_pool* p_cmd_pool)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -1364,7 +2151,8 @@ void tr_create_cmd(tr_cmd_pool* p_cmd_pool, bool secondary, tr_cmd** pp_cmd)
     tr_cmd* p_cmd = (tr_cmd*)calloc(1, sizeof(*p_cmd));
     assert(NULL != p_cmd);
 
-    p_cmd->cmd_pool = p_cmd_pool;
+    p_cmd->cmd_pool  = p_cmd_pool;
+    p_cmd->secondary = secondary;
 
     tr_internal_vk_create_cmd(p_cmd_pool, secondary, p_cmd);
     
@@ -1436,6 +2224,32 @@ void tr_create_uniform_buffer(tr_renderer* p_renderer, uint64_t size, bool host_
     tr_create_buffer(p_renderer, tr_buffer_usage_uniform_cbv, size, host_visible, pp_buffer);
 }
 
+void tr_create_uniform_buffer_dynamic(tr_renderer* p_renderer, uint64_t element_size, uint64_t element_count, bool host_visible, tr_buffer** pp_buffer)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(element_size > 0);
+    assert(element_count > 0);
+
+    // Elements start on offsets the device accepts as dynamic offsets, 
+    // element i is bound with a dynamic offset of i * struct_stride.
+    uint64_t struct_stride = tr_round_up_64(element_size, p_renderer->vk_active_gpu_properties.limits.minUniformBufferOffsetAlignment);
+    assert(struct_stride <= p_renderer->vk_active_gpu_properties.limits.maxUniformBufferRange);
+
+    tr_buffer* p_buffer = (tr_buffer*)calloc(1, sizeof(*p_buffer));
+    assert(NULL != p_buffer);
+
+    p_buffer->renderer      = p_renderer;
+    p_buffer->usage         = tr_buffer_usage_uniform_cbv;
+    p_buffer->size          = struct_stride * element_count;
+    p_buffer->host_visible  = host_visible;
+    p_buffer->element_count = element_count;
+    p_buffer->struct_stride = struct_stride;
+
+    tr_internal_vk_create_buffer(p_renderer, p_buffer);
+
+    *pp_buffer = p_buffer;
+}
+
 void tr_create_vertex_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, uint32_t vertex_stride, tr_buffer** pp_buffer)
 {
     tr_create_buffer(p_renderer, tr_buffer_usage_vertex, size, host_visible, pp_buffer);
@@ -1518,6 +2332,10 @@ void tr_destroy_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer)
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_buffer);
 
+    // Pending tr_util_* uploads may still reference the buffer
+    tr_internal_util_upload_flush(p_renderer->graphics_queue, true);
+    tr_internal_util_upload_flush(p_renderer->present_queue, true);
+
     tr_internal_vk_destroy_buffer(p_renderer, p_buffer);
 
     TINY_RENDERER_SAFE_FREE(p_buffer);
@@ -1627,6 +2445,10 @@ void tr_destroy_texture(tr_renderer* p_renderer, tr_texture* p_texture)
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_texture);
 
+    // Pending tr_util_* uploads may still reference the texture
+    tr_internal_util_upload_flush(p_renderer->graphics_queue, true);
+    tr_internal_util_upload_flush(p_renderer->present_queue, true);
+
     tr_internal_vk_destroy_texture(p_renderer, p_texture);
 
     TINY_RENDERER_SAFE_FREE(p_texture);
@@ -1748,43 +2570,220 @@ void tr_destroy_shader_program(tr_renderer* p_renderer, tr_shader_program* p_sha
 }
 
 void tr_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* p_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
+{
+    uint32_t descriptor_set_count = (NULL != p_descriptor_set) ? 1 : 0;
+    tr_create_pipeline_n(p_renderer, p_shader_program, p_vertex_layout, descriptor_set_count, &p_descriptor_set, p_render_target, p_pipeline_settings, pp_pipeline);
+}
+
+tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
+{
+    uint32_t descriptor_set_count = (NULL != p_descriptor_set) ? 1 : 0;
+    tr_create_compute_pipeline_n(p_renderer, p_shader_program, descriptor_set_count, &p_descriptor_set, p_pipeline_settings, pp_pipeline);
+}
+
+void tr_create_pipeline_n(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_render_target);
     assert(NULL != p_pipeline_settings);
+    assert(descriptor_set_count <= tr_max_descriptor_sets);
+    assert((0 == descriptor_set_count) || (NULL != pp_descriptor_sets));
+
+    tr_pipeline_key key;
+    uint64_t hash = 0;
+    tr_internal_vk_make_pipeline_key(p_renderer, tr_pipeline_type_graphics, p_shader_program, p_vertex_layout, descriptor_set_count, pp_descriptor_sets, p_render_target, p_pipeline_settings, &key, &hash);
+    tr_pipeline* p_existing = tr_internal_vk_find_pipeline(p_renderer, &key, hash);
+    if (NULL != p_existing) {
+        // Callers expect a usable pipeline, finish it if it came from tr_create_pipeline_async
+        tr_wait_pipeline(p_existing);
+        p_existing->ref_count += 1;
+        p_renderer->vk_pipeline_dedup_count += 1;
+        *pp_pipeline = p_existing;
+        return;
+    }
 
     tr_pipeline* p_pipeline = (tr_pipeline*)calloc(1, sizeof(*p_pipeline));
     assert(NULL != p_pipeline);
 
+    p_pipeline->renderer = p_renderer;
     memcpy(&(p_pipeline->settings), p_pipeline_settings, sizeof(*p_pipeline_settings));
+    p_pipeline->descriptor_set_count = descriptor_set_count;
+
+    tr_internal_vk_create_pipeline(p_renderer, p_shader_program, p_vertex_layout, descriptor_set_count, pp_descriptor_sets, p_render_target, p_pipeline_settings, p_pipeline);
+    p_pipeline->type  = tr_pipeline_type_graphics;
+    p_pipeline->ready = 1;
 
-    tr_internal_vk_create_pipeline(p_renderer, p_shader_program, p_vertex_layout, p_descriptor_set, p_render_target, p_pipeline_settings, p_pipeline);
-    p_pipeline->type = tr_pipeline_type_graphics;
+    p_pipeline->ref_count            = 1;
+    p_pipeline->vk_pipeline_key      = key;
+    p_pipeline->vk_pipeline_key_hash = hash;
+    p_pipeline->next                 = p_renderer->vk_pipelines;
+    p_renderer->vk_pipelines         = p_pipeline;
 
     *pp_pipeline = p_pipeline;
 }
 
-tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
+void tr_create_compute_pipeline_n(tr_renderer* p_renderer, tr_shader_program* p_shader_program, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_shader_program);
     assert(NULL != p_pipeline_settings);
+    assert(descriptor_set_count <= tr_max_descriptor_sets);
+    assert((0 == descriptor_set_count) || (NULL != pp_descriptor_sets));
+
+    tr_pipeline_key key;
+    uint64_t hash = 0;
+    tr_internal_vk_make_pipeline_key(p_renderer, tr_pipeline_type_compute, p_shader_program, NULL, descriptor_set_count, pp_descriptor_sets, NULL, p_pipeline_settings, &key, &hash);
+    tr_pipeline* p_existing = tr_internal_vk_find_pipeline(p_renderer, &key, hash);
+    if (NULL != p_existing) {
+        p_existing->ref_count += 1;
+        p_renderer->vk_pipeline_dedup_count += 1;
+        *pp_pipeline = p_existing;
+        return;
+    }
 
     tr_pipeline* p_pipeline = (tr_pipeline*)calloc(1, sizeof(*p_pipeline));
     assert(NULL != p_pipeline);
 
+    p_pipeline->renderer = p_renderer;
     memcpy(&(p_pipeline->settings), p_pipeline_settings, sizeof(*p_pipeline_settings));
+    p_pipeline->descriptor_set_count = descriptor_set_count;
+
+    tr_internal_vk_create_compute_pipeline(p_renderer, p_shader_program, descriptor_set_count, pp_descriptor_sets, p_pipeline_settings, p_pipeline);
+    p_pipeline->type  = tr_pipeline_type_compute;
+    p_pipeline->ready = 1;
+
+    p_pipeline->ref_count            = 1;
+    p_pipeline->vk_pipeline_key      = key;
+    p_pipeline->vk_pipeline_key_hash = hash;
+    p_pipeline->next                 = p_renderer->vk_pipelines;
+    p_renderer->vk_pipelines         = p_pipeline;
+
+    *pp_pipeline = p_pipeline;
+}
+
+void tr_create_pipeline_async(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_fallback_pipeline, tr_pipeline** pp_pipeline)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_shader_program);
+    assert(NULL != p_vertex_layout);
+    assert(NULL != p_render_target);
+    assert(VK_NULL_HANDLE != p_render_target->vk_render_pass);
+    assert(NULL != p_pipeline_settings);
+    assert(descriptor_set_count <= tr_max_descriptor_sets);
+    assert((0 == descriptor_set_count) || (NULL != pp_descriptor_sets));
+
+    tr_pipeline_key key;
+    uint64_t hash = 0;
+    tr_internal_vk_make_pipeline_key(p_renderer, tr_pipeline_type_graphics, p_shader_program, p_vertex_layout, descriptor_set_count, pp_descriptor_sets, p_render_target, p_pipeline_settings, &key, &hash);
+    tr_pipeline* p_existing = tr_internal_vk_find_pipeline(p_renderer, &key, hash);
+    if (NULL != p_existing) {
+        // The shared pipeline keeps its first fallback, a different one would be silently ignored
+        assert((! p_existing->async) || (p_existing->fallback == p_fallback_pipeline));
+        p_existing->ref_count += 1;
+        p_renderer->vk_pipeline_dedup_count += 1;
+        *pp_pipeline = p_existing;
+        return;
+    }
+
+    if (NULL == p_renderer->pipeline_worker_pool) {
+        tr_internal_create_pipeline_worker_pool(p_renderer);
+    }
+    tr_pipeline_worker_pool* p_pool = p_renderer->pipeline_worker_pool;
 
-    tr_internal_vk_create_compute_pipeline(p_renderer, p_shader_program, p_descriptor_set, p_pipeline_settings, p_pipeline);
-    p_pipeline->type = tr_pipeline_type_compute;
+    tr_pipeline* p_pipeline = (tr_pipeline*)calloc(1, sizeof(*p_pipeline));
+    assert(NULL != p_pipeline);
+
+    p_pipeline->renderer = p_renderer;
+    memcpy(&(p_pipeline->settings), p_pipeline_settings, sizeof(*p_pipeline_settings));
+    p_pipeline->descriptor_set_count = descriptor_set_count;
+    p_pipeline->type                 = tr_pipeline_type_graphics;
+    p_pipeline->async                = true;
+    p_pipeline->ready                = false;
+    p_pipeline->fallback             = p_fallback_pipeline;
+
+    // The layout touches renderer caches so it's created here, binding
+    // descriptor sets and push constants works before the pipeline is ready
+    tr_internal_vk_create_pipeline_layout(p_renderer, descriptor_set_count, pp_descriptor_sets, &(p_pipeline->settings), p_pipeline);
+
+    p_pipeline->ref_count            = 1;
+    p_pipeline->vk_pipeline_key      = key;
+    p_pipeline->vk_pipeline_key_hash = hash;
+    p_pipeline->next                 = p_renderer->vk_pipelines;
+    p_renderer->vk_pipelines         = p_pipeline;
+
+    tr_pipeline_job* p_job = (tr_pipeline_job*)calloc(1, sizeof(*p_job));
+    assert(NULL != p_job);
+    p_job->pipeline       = p_pipeline;
+    p_job->shader_program = p_shader_program;
+    p_job->vertex_layout  = *p_vertex_layout;
+    p_job->vk_render_pass = p_render_target->vk_render_pass;
+    p_job->sample_count   = p_render_target->sample_count;
+
+    tr_internal_mutex_lock(&(p_pool->mutex));
+    if (NULL == p_pool->job_tail) {
+        p_pool->job_head = p_job;
+    }
+    else {
+        p_pool->job_tail->next = p_job;
+    }
+    p_pool->job_tail = p_job;
+    tr_internal_cond_broadcast(&(p_pool->job_cond));
+    tr_internal_mutex_unlock(&(p_pool->mutex));
 
     *pp_pipeline = p_pipeline;
 }
 
+bool tr_pipeline_is_ready(tr_pipeline* p_pipeline)
+{
+    assert(NULL != p_pipeline);
+
+    // Only async pipelines are ever not ready, and all of them are once the pool is gone
+    tr_pipeline_worker_pool* p_pool = p_pipeline->renderer->pipeline_worker_pool;
+    if ((! p_pipeline->async) || (NULL == p_pool)) {
+        return true;
+    }
+
+    // Once latched ready never goes back, so this never takes the pool's lock
+    return 0 != tr_internal_atomic_load(&(p_pipeline->ready));
+}
+
+void tr_wait_pipeline(tr_pipeline* p_pipeline)
+{
+    assert(NULL != p_pipeline);
+
+    tr_pipeline_worker_pool* p_pool = p_pipeline->renderer->pipeline_worker_pool;
+    if ((! p_pipeline->async) || (NULL == p_pool)) {
+        return;
+    }
+
+    tr_internal_mutex_lock(&(p_pool->mutex));
+    while (0 == tr_internal_atomic_load(&(p_pipeline->ready))) {
+        tr_internal_cond_wait(&(p_pool->done_cond), &(p_pool->mutex));
+    }
+    tr_internal_mutex_unlock(&(p_pool->mutex));
+}
+
 void tr_destroy_pipeline(tr_renderer* p_renderer, tr_pipeline* p_pipeline)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_pipeline);
+    assert(p_pipeline->ref_count > 0);
+
+    // Other creates with the same key still use it
+    p_pipeline->ref_count -= 1;
+    if (p_pipeline->ref_count > 0) {
+        return;
+    }
+
+    // A worker may still be compiling it
+    tr_wait_pipeline(p_pipeline);
+
+    tr_pipeline** pp_link = &(p_renderer->vk_pipelines);
+    while (*pp_link != p_pipeline) {
+        assert(NULL != *pp_link);
+        pp_link = &((*pp_link)->next);
+    }
+    *pp_link = p_pipeline->next;
 
     tr_internal_vk_destroy_pipeline(p_renderer, p_pipeline);
 
@@ -1910,6 +2909,8 @@ void tr_update_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_desc
 {
     assert(NULL != p_renderer);
     assert(NULL != p_descriptor_set);
+    // Bindless slots are written when resources are created
+    assert(p_descriptor_set != p_renderer->bindless_descriptor_set);
 
     tr_internal_vk_update_descriptor_set(p_renderer, p_descriptor_set);
 }
@@ -1921,36 +2922,94 @@ void tr_begin_cmd(tr_cmd* p_cmd)
 {
     assert(NULL != p_cmd);
 
-    tr_internal_vk_begin_cmd(p_cmd);
+    tr_internal_vk_begin_cmd(p_cmd, NULL, tr_cmd_usage_default);
 }
 
-void tr_end_cmd(tr_cmd* p_cmd)
+void tr_begin_cmd_usage(tr_cmd* p_cmd, tr_cmd_usage_flags usage)
 {
     assert(NULL != p_cmd);
 
-    tr_internal_vk_end_cmd(p_cmd);
+    tr_internal_vk_begin_cmd(p_cmd, NULL, usage);
 }
 
-void tr_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_target)
+void tr_begin_cmd_secondary(tr_cmd* p_cmd, tr_render_target* p_render_target)
 {
     assert(NULL != p_cmd);
+    assert(p_cmd->secondary);
     assert(NULL != p_render_target);
 
-    s_tr_internal->bound_render_target = p_render_target;
-
-    tr_internal_vk_cmd_begin_render(p_cmd, p_render_target);
+    tr_internal_vk_begin_cmd(p_cmd, p_render_target, tr_cmd_usage_default);
 }
 
-void tr_cmd_end_render(tr_cmd* p_cmd)
+void tr_begin_cmd_secondary_usage(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_cmd_usage_flags usage)
 {
     assert(NULL != p_cmd);
+    assert(p_cmd->secondary);
+    assert(NULL != p_render_target);
 
-    tr_internal_vk_cmd_end_render(p_cmd);
-
-    s_tr_internal->bound_render_target = NULL;
+    tr_internal_vk_begin_cmd(p_cmd, p_render_target, usage);
 }
 
-void tr_cmd_set_viewport(tr_cmd* p_cmd, float x, float y, float width, float height, float min_depth, float max_depth)
+void tr_end_cmd(tr_cmd* p_cmd)
+{
+    assert(NULL != p_cmd);
+
+    tr_internal_vk_end_cmd(p_cmd);
+}
+
+void tr_cmd_invalidate_state(tr_cmd* p_cmd)
+{
+    assert(NULL != p_cmd);
+
+    memset(&(p_cmd->state), 0, sizeof(p_cmd->state));
+}
+
+void tr_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_target)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_render_target);
+
+    assert(! p_cmd->secondary);
+
+    s_tr_internal->bound_render_target = p_render_target;
+
+    tr_internal_vk_cmd_begin_render(p_cmd, p_render_target, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void tr_cmd_begin_render_secondary(tr_cmd* p_cmd, tr_render_target* p_render_target)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_render_target);
+    assert(! p_cmd->secondary);
+
+    s_tr_internal->bound_render_target = p_render_target;
+
+    tr_internal_vk_cmd_begin_render(p_cmd, p_render_target, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+}
+
+void tr_cmd_execute(tr_cmd* p_cmd, uint32_t cmd_count, tr_cmd** pp_cmds)
+{
+    assert(NULL != p_cmd);
+    assert(! p_cmd->secondary);
+    assert(NULL != pp_cmds);
+
+    if (0 == cmd_count) {
+        return;
+    }
+
+    tr_internal_vk_cmd_execute(p_cmd, cmd_count, pp_cmds);
+}
+
+void tr_cmd_end_render(tr_cmd* p_cmd)
+{
+    assert(NULL != p_cmd);
+
+    tr_internal_vk_cmd_end_render(p_cmd);
+
+    s_tr_internal->bound_render_target = NULL;
+}
+
+void tr_cmd_set_viewport(tr_cmd* p_cmd, float x, float y, float width, float height, float min_depth, float max_depth)
 {
     assert(NULL != p_cmd);
 
@@ -1990,6 +3049,21 @@ void tr_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline)
     assert(NULL != p_cmd);
     assert(NULL != p_pipeline);
 
+    // Fall back while the pipeline compiles, the fallback's layout must be
+    // compatible with the sets and push constants bound for the pipeline.
+    // Only graphics pipelines compile async, and skip_draws only tracks the
+    // graphics bind point so compute binds leave it alone.
+    if (! tr_pipeline_is_ready(p_pipeline)) {
+        p_pipeline = p_pipeline->fallback;
+        if ((NULL == p_pipeline) || (! tr_pipeline_is_ready(p_pipeline))) {
+            p_cmd->skip_draws = true;
+            return;
+        }
+    }
+    if (tr_pipeline_type_graphics == p_pipeline->type) {
+        p_cmd->skip_draws = false;
+    }
+
     tr_internal_vk_cmd_bind_pipeline(p_cmd, p_pipeline);
 }
 
@@ -1998,8 +3072,48 @@ void tr_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_desc
     assert(NULL != p_cmd);
     assert(NULL != p_pipeline);
     assert(NULL != p_descriptor_set);
+    assert(0 == p_descriptor_set->dynamic_offset_count);
+
+    tr_internal_vk_cmd_bind_descriptor_sets(p_cmd, p_pipeline, 0, 1, &p_descriptor_set, 0, NULL);
+}
+
+void tr_cmd_bind_descriptor_sets_dynamic(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_pipeline);
+    assert(NULL != p_descriptor_set);
+    assert(dynamic_offset_count == p_descriptor_set->dynamic_offset_count);
+    assert((0 == dynamic_offset_count) || (NULL != p_dynamic_offsets));
+
+    tr_internal_vk_cmd_bind_descriptor_sets(p_cmd, p_pipeline, 0, 1, &p_descriptor_set, dynamic_offset_count, p_dynamic_offsets);
+}
+
+void tr_cmd_bind_descriptor_sets_n(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t first_set, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_pipeline);
+    assert(NULL != pp_descriptor_sets);
+    assert((descriptor_set_count > 0) && ((first_set + descriptor_set_count) <= p_pipeline->descriptor_set_count));
+    assert((0 == dynamic_offset_count) || (NULL != p_dynamic_offsets));
+
+    uint32_t expected_dynamic_offset_count = 0;
+    for (uint32_t i = 0; i < descriptor_set_count; ++i) {
+        assert(NULL != pp_descriptor_sets[i]);
+        expected_dynamic_offset_count += pp_descriptor_sets[i]->dynamic_offset_count;
+    }
+    assert(dynamic_offset_count == expected_dynamic_offset_count);
+
+    tr_internal_vk_cmd_bind_descriptor_sets(p_cmd, p_pipeline, first_set, descriptor_set_count, pp_descriptor_sets, dynamic_offset_count, p_dynamic_offsets);
+}
+
+void tr_cmd_push_constants(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t offset, uint32_t size, const void* p_values)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_pipeline);
+    assert(NULL != p_values);
+    assert((0 == (offset % 4)) && (0 == (size % 4)) && (size > 0));
 
-    tr_internal_vk_cmd_bind_descriptor_sets(p_cmd, p_pipeline, p_descriptor_set);
+    tr_internal_vk_cmd_push_constants(p_cmd, p_pipeline, offset, size, p_values);
 }
 
 void tr_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer)
@@ -2023,14 +3137,44 @@ void tr_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex)
 {
     assert(NULL != p_cmd);
 
-    tr_internal_vk_cmd_draw(p_cmd, vertex_count, first_vertex);
+    if (p_cmd->skip_draws) {
+        return;
+    }
+
+    tr_internal_vk_cmd_draw(p_cmd, vertex_count, first_vertex, 1, 0);
 }
 
 void tr_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index)
 {
     assert(NULL != p_cmd);
 
-    tr_internal_vk_cmd_draw_indexed(p_cmd, index_count, first_index);
+    if (p_cmd->skip_draws) {
+        return;
+    }
+
+    tr_internal_vk_cmd_draw_indexed(p_cmd, index_count, first_index, 0, 1, 0);
+}
+
+void tr_cmd_draw_instanced(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance)
+{
+    assert(NULL != p_cmd);
+
+    if (p_cmd->skip_draws) {
+        return;
+    }
+
+    tr_internal_vk_cmd_draw(p_cmd, vertex_count, first_vertex, instance_count, first_instance);
+}
+
+void tr_cmd_draw_indexed_instanced(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance)
+{
+    assert(NULL != p_cmd);
+
+    if (p_cmd->skip_draws) {
+        return;
+    }
+
+    tr_internal_vk_cmd_draw_indexed(p_cmd, index_count, first_index, vertex_offset, instance_count, first_instance);
 }
 
 void tr_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
@@ -2046,13 +3190,13 @@ void tr_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_us
     assert(NULL != p_cmd);
     assert(NULL != p_texture);
 
-    // Vulkan doesn't have an VkImageLayout corresponding to tr_texture_usage_storage, so
-    // just ignore transitions into or out of tr_texture_usage_storage.
-    if ((old_usage == tr_texture_usage_storage_image) || (new_usage == tr_texture_usage_storage_image)) {
-      return;
+    // The tracked usage is what the image is really in, old_usage is only
+    // kept for D3D12 compatibility. Storage images use the general layout.
+    if (p_texture->current_usage == new_usage) {
+        return;
     }
 
-    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, old_usage, new_usage);
+    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, p_texture->current_usage, new_usage);
 }
 
 void tr_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage)
@@ -2065,12 +3209,93 @@ void tr_cmd_depth_stencil_transition(tr_cmd* p_cmd, tr_render_target* p_render_t
   // Vulkan render passes take care of transitions, so just ignore this for now...
 }
 
+void tr_cmd_transition_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage new_usage)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_buffer);
+
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->current_usage, new_usage);
+}
+
+void tr_cmd_transition_image(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage new_usage)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_texture);
+
+    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, p_texture->current_usage, new_usage);
+}
+
+void tr_cmd_flush_barriers(tr_cmd* p_cmd)
+{
+    assert(NULL != p_cmd);
+
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+}
+
 void tr_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
     assert(NULL != p_cmd);
     tr_internal_vk_cmd_dispatch(p_cmd, group_count_x, group_count_y, group_count_z);
 }
 
+void tr_cmd_draw_indirect(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_buffer);
+
+    if (p_cmd->skip_draws || (0 == draw_count)) {
+        return;
+    }
+
+    tr_internal_vk_cmd_draw_indirect(p_cmd, false, p_buffer, offset, draw_count, (0 != stride) ? stride : sizeof(tr_draw_indirect_args));
+}
+
+void tr_cmd_draw_indexed_indirect(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_buffer);
+
+    if (p_cmd->skip_draws || (0 == draw_count)) {
+        return;
+    }
+
+    tr_internal_vk_cmd_draw_indirect(p_cmd, true, p_buffer, offset, draw_count, (0 != stride) ? stride : sizeof(tr_draw_indexed_indirect_args));
+}
+
+void tr_cmd_draw_indirect_count(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset, tr_buffer* p_count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_buffer);
+    assert(NULL != p_count_buffer);
+
+    if (p_cmd->skip_draws || (0 == max_draw_count)) {
+        return;
+    }
+
+    tr_internal_vk_cmd_draw_indirect_count(p_cmd, false, p_buffer, offset, p_count_buffer, count_offset, max_draw_count, (0 != stride) ? stride : sizeof(tr_draw_indirect_args));
+}
+
+void tr_cmd_draw_indexed_indirect_count(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset, tr_buffer* p_count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_buffer);
+    assert(NULL != p_count_buffer);
+
+    if (p_cmd->skip_draws || (0 == max_draw_count)) {
+        return;
+    }
+
+    tr_internal_vk_cmd_draw_indirect_count(p_cmd, true, p_buffer, offset, p_count_buffer, count_offset, max_draw_count, (0 != stride) ? stride : sizeof(tr_draw_indexed_indirect_args));
+}
+
+void tr_cmd_dispatch_indirect(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_buffer);
+
+    tr_internal_vk_cmd_dispatch_indirect(p_cmd, p_buffer, offset);
+}
+
 void tr_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t height, uint32_t row_pitch, uint64_t buffer_offset, uint32_t mip_level, tr_buffer* p_buffer, tr_texture* p_texture)
 {
     assert(p_cmd != NULL);
@@ -2094,7 +3319,8 @@ void tr_queue_submit(
     uint32_t       wait_semaphore_count,
     tr_semaphore** pp_wait_semaphores,
     uint32_t       signal_semaphore_count,
-    tr_semaphore** pp_signal_semaphores
+    tr_semaphore** pp_signal_semaphores,
+    tr_fence*      p_signal_fence
 )
 {
     assert(NULL != p_queue);
@@ -2107,13 +3333,17 @@ void tr_queue_submit(
         assert(NULL != pp_signal_semaphores);
     }
 
+    // Uploads recorded by the tr_util_* helpers go first
+    tr_internal_util_upload_flush(p_queue, false);
+
     tr_internal_vk_queue_submit(p_queue, 
                                 cmd_count, 
                                 pp_cmds, 
                                 wait_semaphore_count, 
                                 pp_wait_semaphores, 
                                 signal_semaphore_count, 
-                                pp_signal_semaphores);
+                                pp_signal_semaphores,
+                                p_signal_fence);
 }
 
 void tr_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores)
@@ -2130,6 +3360,8 @@ void tr_queue_wait_idle(tr_queue* p_queue)
 {
     assert(NULL != p_queue);
 
+    tr_internal_util_upload_flush(p_queue, true);
+
     tr_internal_vk_queue_wait_idle(p_queue);
 }
 
@@ -2419,26 +3651,28 @@ uint32_t tr_util_format_channel_count(tr_format format)
     return result;
 }
 
+static tr_upload_context* tr_internal_util_upload_context(tr_queue* p_queue)
+{
+    if (NULL == p_queue->util_upload_context) {
+        tr_create_upload_context(p_queue->renderer, p_queue, 0, &(p_queue->util_upload_context));
+    }
+    return p_queue->util_upload_context;
+}
+
+void tr_internal_util_upload_flush(tr_queue* p_queue, bool wait)
+{
+    if (NULL != p_queue->util_upload_context) {
+        tr_upload_flush(p_queue->util_upload_context, wait);
+    }
+}
+
 void tr_util_transition_buffer(tr_queue* p_queue, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
 {
     assert(NULL != p_queue);
     assert(NULL != p_buffer);
 
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
-
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
-    
-    tr_begin_cmd(p_cmd);
-    tr_cmd_buffer_transition(p_cmd, p_buffer, old_usage, new_usage);
-    tr_end_cmd(p_cmd);
-
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
-
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    tr_upload_context* p_upload_context = tr_internal_util_upload_context(p_queue);
+    tr_upload_transition_buffer(p_upload_context, p_buffer, old_usage, new_usage);
 }
 
 void tr_util_transition_image(tr_queue* p_queue, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
@@ -2446,21 +3680,8 @@ void tr_util_transition_image(tr_queue* p_queue, tr_texture* p_texture, tr_textu
     assert(NULL != p_queue);
     assert(NULL != p_texture);
 
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
-
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
-    
-    tr_begin_cmd(p_cmd);
-    tr_cmd_image_transition(p_cmd, p_texture, old_usage, new_usage);
-    tr_end_cmd(p_cmd);
-
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
-
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    tr_upload_context* p_upload_context = tr_internal_util_upload_context(p_queue);
+    tr_upload_transition_image(p_upload_context, p_texture, old_usage, new_usage);
 }
 
 bool tr_image_resize_uint8_t(
@@ -2499,138 +3720,255 @@ void tr_util_set_storage_buffer_count(tr_queue* p_queue, uint64_t count_offset,
 {
     assert(NULL != p_queue);
     assert(NULL != p_counter_buffer);
-    assert(NULL != p_counter_buffer->vk_buffer);
-
-    tr_buffer* buffer = NULL;
-    tr_create_buffer(p_counter_buffer->renderer, tr_buffer_usage_transfer_src, p_counter_buffer->size, true, &buffer);
-    uint32_t* mapped_ptr = (uint32_t*)buffer->cpu_mapped_address;
-    *(mapped_ptr) = count;
-    
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
-
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
-
-    tr_begin_cmd(p_cmd);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_counter_buffer, tr_buffer_usage_storage_uav, tr_buffer_usage_transfer_dst);
-    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
-    region.srcOffset = 0;
-    region.dstOffset = 0;
-    region.size      = (VkDeviceSize)4;
-    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_counter_buffer->vk_buffer, 1, &region);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_counter_buffer, tr_buffer_usage_transfer_dst, tr_buffer_usage_storage_uav);
-    tr_end_cmd(p_cmd);
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
-
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
-
-    tr_destroy_buffer(p_counter_buffer->renderer, buffer);
+    tr_upload_context* p_upload_context = tr_internal_util_upload_context(p_queue);
+    tr_upload_set_storage_buffer_count(p_upload_context, count_offset, count, p_counter_buffer);
 }
 
 void tr_util_clear_buffer(tr_queue* p_queue, tr_buffer* p_buffer)
 {
     assert(NULL != p_queue);
     assert(NULL != p_buffer);
-    assert(NULL != p_buffer->vk_buffer);
 
-    tr_buffer* buffer = NULL;
-    tr_create_buffer(p_buffer->renderer, tr_buffer_usage_transfer_src, p_buffer->size, true, &buffer);
-    memset(buffer->cpu_mapped_address, 0, buffer->size);
-    
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+    tr_upload_context* p_upload_context = tr_internal_util_upload_context(p_queue);
+    tr_upload_clear_buffer(p_upload_context, p_buffer);
+}
 
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+void tr_util_update_buffer(tr_queue* p_queue, uint64_t size, const void* p_src_data, tr_buffer* p_buffer)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_buffer);
 
-    tr_begin_cmd(p_cmd);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->usage, tr_buffer_usage_transfer_dst);
-    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
-    region.srcOffset = 0;
-    region.dstOffset = 0;
-    region.size      = (VkDeviceSize)p_buffer->size;
-    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_buffer->vk_buffer, 1, &region);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, p_buffer->usage);
-    tr_end_cmd(p_cmd);
+    tr_upload_context* p_upload_context = tr_internal_util_upload_context(p_queue);
+    tr_upload_update_buffer(p_upload_context, size, p_src_data, p_buffer);
+}
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
+void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_texture);
 
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    tr_upload_context* p_upload_context = tr_internal_util_upload_context(p_queue);
+    tr_upload_update_texture_uint8(p_upload_context, src_width, src_height, src_row_stride, p_src_data, src_channel_count, p_texture, resize_fn, p_user_data);
+}
 
-    tr_destroy_buffer(p_buffer->renderer, buffer);
+void tr_util_update_texture_float(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data, uint32_t channels, tr_texture* p_texture, tr_image_resize_float_fn resize_fn, void* p_user_data)
+{
 }
 
-void tr_util_update_buffer(tr_queue* p_queue, uint64_t size, const void* p_src_data, tr_buffer* p_buffer)
+// -------------------------------------------------------------------------------------------------
+// Upload context functions
+// -------------------------------------------------------------------------------------------------
+static void tr_internal_upload_retire_batch(tr_upload_context* p_upload_context, uint32_t batch_index)
 {
-    assert(NULL != p_queue);
-    assert(NULL != p_src_data);
-    assert(NULL != p_buffer);
-    assert(NULL != p_buffer->vk_buffer);
-    assert(p_buffer->size >= size);
+    tr_internal_vk_wait_for_fence(p_upload_context->renderer, p_upload_context->batch_fences[batch_index]);
 
-    tr_buffer* buffer = NULL;
-    tr_create_buffer(p_buffer->renderer, tr_buffer_usage_transfer_src, size, true, &buffer);
-    memcpy(buffer->cpu_mapped_address, p_src_data, size);
-    
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+    // Batches retire in submission order, so everything before this batch's head is free
+    p_upload_context->tail = p_upload_context->batch_heads[batch_index];
+    p_upload_context->batch_pending[batch_index] = false;
+}
 
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+static bool tr_internal_upload_retire_oldest_batch(tr_upload_context* p_upload_context)
+{
+    // Batches are used round-robin, the oldest pending one follows the current one
+    for (uint32_t i = 0; i < tr_max_upload_batches; ++i) {
+        uint32_t batch_index = (p_upload_context->batch_index + i) % tr_max_upload_batches;
+        if (p_upload_context->batch_pending[batch_index]) {
+            tr_internal_upload_retire_batch(p_upload_context, batch_index);
+            return true;
+        }
+    }
+    return false;
+}
 
-    tr_begin_cmd(p_cmd);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->usage, tr_buffer_usage_transfer_dst);
-    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
-    region.srcOffset = 0;
-    region.dstOffset = 0;
-    region.size      = (VkDeviceSize)size;
-    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_buffer->vk_buffer, 1, &region);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, p_buffer->usage);
-    tr_end_cmd(p_cmd);
+static tr_cmd* tr_internal_upload_get_cmd(tr_upload_context* p_upload_context)
+{
+    if (! p_upload_context->recording) {
+        uint32_t batch_index = p_upload_context->batch_index;
+        if (p_upload_context->batch_pending[batch_index]) {
+            tr_internal_upload_retire_batch(p_upload_context, batch_index);
+        }
+        tr_begin_cmd_usage(p_upload_context->batch_cmds[batch_index], tr_cmd_usage_one_time_submit);
+        p_upload_context->recording = true;
+    }
+    return p_upload_context->batch_cmds[p_upload_context->batch_index];
+}
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
+static uint8_t* tr_internal_upload_alloc(tr_upload_context* p_upload_context, uint64_t size, uint64_t alignment, uint64_t* p_offset)
+{
+    // Grow the ring if a single upload doesn't fit, this needs everything in flight to finish
+    if (size > p_upload_context->staging_buffer->size) {
+        tr_upload_flush(p_upload_context, true);
+        uint64_t new_size = tr_round_up_64(size, p_upload_context->staging_buffer->size);
+        tr_destroy_buffer(p_upload_context->renderer, p_upload_context->staging_buffer);
+        tr_create_buffer(p_upload_context->renderer, tr_buffer_usage_transfer_src, new_size, true, &(p_upload_context->staging_buffer));
+        p_upload_context->head = 0;
+        p_upload_context->tail = 0;
+    }
 
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    const uint64_t capacity = p_upload_context->staging_buffer->size;
+    for (;;) {
+        uint64_t base   = p_upload_context->head - (p_upload_context->head % capacity);
+        uint64_t offset = tr_round_up_64(p_upload_context->head % capacity, alignment);
+        // Don't straddle the end of the buffer, skip to the start instead
+        if ((offset + size) > capacity) {
+            base  += capacity;
+            offset = 0;
+        }
+        uint64_t end = base + offset + size;
+        if ((end - p_upload_context->tail) <= capacity) {
+            p_upload_context->head = end;
+            *p_offset = offset;
+            return (uint8_t*)p_upload_context->staging_buffer->cpu_mapped_address + offset;
+        }
 
-    tr_destroy_buffer(p_buffer->renderer, buffer);
+        // Out of space - wait on the oldest batch, or submit the current one if nothing else is in flight
+        if (! tr_internal_upload_retire_oldest_batch(p_upload_context)) {
+            assert(p_upload_context->recording);
+            tr_upload_flush(p_upload_context, true);
+        }
+    }
 }
 
-void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data)
+void tr_create_upload_context(tr_renderer* p_renderer, tr_queue* p_queue, uint64_t staging_size, tr_upload_context** pp_upload_context)
 {
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_queue);
-    assert(NULL != p_src_data);
-    assert(NULL != p_texture);
-    assert(NULL != p_texture->vk_image);
-    assert((src_width > 0) && (src_height > 0) && (src_row_stride > 0));
-    assert(tr_sample_count_1 == p_texture->sample_count);
 
-    uint8_t* p_expanded_src_data = NULL;
-    const uint32_t dst_channel_count = tr_util_format_channel_count(p_texture->format);
-    assert(src_channel_count <= dst_channel_count);
+    tr_upload_context* p_upload_context = (tr_upload_context*)calloc(1, sizeof(*p_upload_context));
+    assert(NULL != p_upload_context);
 
-    if (src_channel_count < dst_channel_count) {
-        uint32_t expanded_row_stride = src_width * dst_channel_count;
-        uint32_t expanded_size = expanded_row_stride * src_height;
-        p_expanded_src_data = (uint8_t*)calloc(1, expanded_size);
-        assert(NULL != p_expanded_src_data);
+    p_upload_context->renderer = p_renderer;
+    p_upload_context->queue    = p_queue;
 
-        const uint32_t src_pixel_stride = src_channel_count;
-        const uint32_t expanded_pixel_stride = dst_channel_count;
-        const uint8_t* src_row = p_src_data;
-        uint8_t* expanded_row = p_expanded_src_data;
-        for (uint32_t y = 0; y < src_height; ++y) {
-            const uint8_t* src_pixel = src_row;
-            uint8_t* expanded_pixel = expanded_row;
-            for (uint32_t x = 0; x < src_width; ++x) {
-                uint32_t c = 0; 
+    if (0 == staging_size) {
+        staging_size = TINY_RENDERER_UPLOAD_STAGING_SIZE;
+    }
+    tr_create_buffer(p_renderer, tr_buffer_usage_transfer_src, staging_size, true, &(p_upload_context->staging_buffer));
+
+    tr_create_cmd_pool(p_renderer, p_queue, true, &(p_upload_context->cmd_pool));
+    for (uint32_t i = 0; i < tr_max_upload_batches; ++i) {
+        tr_create_cmd(p_upload_context->cmd_pool, false, &(p_upload_context->batch_cmds[i]));
+        tr_create_fence(p_renderer, &(p_upload_context->batch_fences[i]));
+    }
+
+    *pp_upload_context = p_upload_context;
+}
+
+void tr_destroy_upload_context(tr_renderer* p_renderer, tr_upload_context* p_upload_context)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_upload_context);
+
+    tr_upload_flush(p_upload_context, true);
+
+    for (uint32_t i = 0; i < tr_max_upload_batches; ++i) {
+        tr_destroy_fence(p_renderer, p_upload_context->batch_fences[i]);
+        tr_destroy_cmd(p_upload_context->cmd_pool, p_upload_context->batch_cmds[i]);
+    }
+    tr_destroy_cmd_pool(p_renderer, p_upload_context->cmd_pool);
+    tr_destroy_buffer(p_renderer, p_upload_context->staging_buffer);
+
+    TINY_RENDERER_SAFE_FREE(p_upload_context);
+}
+
+void tr_upload_transition_buffer(tr_upload_context* p_upload_context, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
+{
+    assert(NULL != p_upload_context);
+    assert(NULL != p_buffer);
+
+    tr_cmd* p_cmd = tr_internal_upload_get_cmd(p_upload_context);
+    tr_cmd_buffer_transition(p_cmd, p_buffer, old_usage, new_usage);
+}
+
+void tr_upload_transition_image(tr_upload_context* p_upload_context, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
+{
+    assert(NULL != p_upload_context);
+    assert(NULL != p_texture);
+
+    tr_cmd* p_cmd = tr_internal_upload_get_cmd(p_upload_context);
+    tr_cmd_image_transition(p_cmd, p_texture, old_usage, new_usage);
+}
+
+void tr_upload_set_storage_buffer_count(tr_upload_context* p_upload_context, uint64_t count_offset, uint32_t count, tr_buffer* p_counter_buffer)
+{
+    assert(NULL != p_upload_context);
+    assert(NULL != p_counter_buffer);
+    assert(NULL != p_counter_buffer->vk_buffer);
+    assert((count_offset + sizeof(count)) <= p_counter_buffer->size);
+
+    // Small enough to go inline in the command buffer, no staging needed
+    tr_cmd* p_cmd = tr_internal_upload_get_cmd(p_upload_context);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_counter_buffer, p_counter_buffer->current_usage, tr_buffer_usage_transfer_dst);
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+    vkCmdUpdateBuffer(p_cmd->vk_cmd_buf, p_counter_buffer->vk_buffer, (VkDeviceSize)count_offset, (VkDeviceSize)sizeof(count), &count);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_counter_buffer, tr_buffer_usage_transfer_dst, tr_buffer_usage_storage_uav);
+}
+
+void tr_upload_clear_buffer(tr_upload_context* p_upload_context, tr_buffer* p_buffer)
+{
+    assert(NULL != p_upload_context);
+    assert(NULL != p_buffer);
+    assert(NULL != p_buffer->vk_buffer);
+
+    tr_cmd* p_cmd = tr_internal_upload_get_cmd(p_upload_context);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->current_usage, tr_buffer_usage_transfer_dst);
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+    vkCmdFillBuffer(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, 0, VK_WHOLE_SIZE, 0);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, p_buffer->usage);
+}
+
+void tr_upload_update_buffer(tr_upload_context* p_upload_context, uint64_t size, const void* p_src_data, tr_buffer* p_buffer)
+{
+    assert(NULL != p_upload_context);
+    assert(NULL != p_src_data);
+    assert(NULL != p_buffer);
+    assert(NULL != p_buffer->vk_buffer);
+    assert(p_buffer->size >= size);
+
+    uint64_t staging_offset = 0;
+    uint8_t* p_staging = tr_internal_upload_alloc(p_upload_context, size, 4, &staging_offset);
+    memcpy(p_staging, p_src_data, size);
+
+    tr_cmd* p_cmd = tr_internal_upload_get_cmd(p_upload_context);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->current_usage, tr_buffer_usage_transfer_dst);
+    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
+    region.srcOffset = (VkDeviceSize)staging_offset;
+    region.dstOffset = 0;
+    region.size      = (VkDeviceSize)size;
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, p_upload_context->staging_buffer->vk_buffer, p_buffer->vk_buffer, 1, &region);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, p_buffer->usage);
+}
+
+void tr_upload_update_texture_uint8(tr_upload_context* p_upload_context, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data)
+{
+    assert(NULL != p_upload_context);
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(NULL != p_texture->vk_image);
+    assert((src_width > 0) && (src_height > 0) && (src_row_stride > 0));
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    uint8_t* p_expanded_src_data = NULL;
+    const uint32_t dst_channel_count = tr_util_format_channel_count(p_texture->format);
+    assert(src_channel_count <= dst_channel_count);
+
+    if (src_channel_count < dst_channel_count) {
+        uint32_t expanded_row_stride = src_width * dst_channel_count;
+        uint32_t expanded_size = expanded_row_stride * src_height;
+        p_expanded_src_data = (uint8_t*)calloc(1, expanded_size);
+        assert(NULL != p_expanded_src_data);
+
+        const uint32_t src_pixel_stride = src_channel_count;
+        const uint32_t expanded_pixel_stride = dst_channel_count;
+        const uint8_t* src_row = p_src_data;
+        uint8_t* expanded_row = p_expanded_src_data;
+        for (uint32_t y = 0; y < src_height; ++y) {
+            const uint8_t* src_pixel = src_row;
+            uint8_t* expanded_pixel = expanded_row;
+            for (uint32_t x = 0; x < src_width; ++x) {
+                uint32_t c = 0; 
                 for (; c < src_channel_count; ++c) {
                     *(expanded_pixel + c) = *(src_pixel + c);
                 }
@@ -2651,9 +3989,10 @@ void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_
     // Get memory requirements that covers all mip levels
     TINY_RENDERER_DECLARE_ZERO(VkMemoryRequirements, mem_reqs);
     vkGetImageMemoryRequirements(p_texture->renderer->vk_device, p_texture->vk_image, &mem_reqs);
-    // Create temporary buffer big enough to fit all mip levels
-    tr_buffer* buffer = NULL;
-    tr_create_buffer(p_texture->renderer, tr_buffer_usage_transfer_src, mem_reqs.size, true, &buffer);
+    // Staging space big enough to fit all mip levels, copy offsets must be a multiple of 4 and the texel size
+    const uint64_t staging_alignment = 4 * (uint64_t)tr_max(tr_util_format_stride(p_texture->format), 1);
+    uint64_t staging_offset = 0;
+    uint8_t* p_staging = tr_internal_upload_alloc(p_upload_context, mem_reqs.size, staging_alignment, &staging_offset);
     //
     // If you're coming from D3D12, you might want to do something like:
     //
@@ -2688,7 +4027,7 @@ void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_
     VkDeviceSize buffer_offset = 0;
     for (uint32_t mip_level = 0; mip_level < p_texture->mip_levels; ++mip_level) {
         uint32_t dst_row_stride = src_row_stride >> mip_level;
-        uint8_t* p_dst_data = (uint8_t*)buffer->cpu_mapped_address + buffer_offset;
+        uint8_t* p_dst_data = p_staging + buffer_offset;
         resize_fn(src_width, src_height, src_row_stride, p_src_data, dst_width, dst_height, dst_row_stride, p_dst_data, dst_channel_count, p_user_data);
         buffer_offset += dst_row_stride * dst_height;
         dst_width >>= 1;
@@ -2696,7 +4035,7 @@ void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_
     }
 
     // Copy buffer to texture
-    buffer_offset = 0;
+    buffer_offset = staging_offset;
     VkFormat format = tr_util_to_vk_format(p_texture->format);
     VkImageAspectFlags aspect_mask = tr_util_vk_determine_aspect_mask(format);
     {
@@ -2725,38 +4064,159 @@ void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_
             dst_height >>= 1;
         }
         
-        tr_cmd_pool* p_cmd_pool = NULL;
-        tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
-
-        tr_cmd* p_cmd = NULL;
-        tr_create_cmd(p_cmd_pool, false, &p_cmd);
-
-        tr_begin_cmd(p_cmd);
+        tr_cmd* p_cmd = tr_internal_upload_get_cmd(p_upload_context);
         //
         // Vulkan textures are created with VK_IMAGE_LAYOUT_UNDEFFINED (tr_texture_usage_undefined)
         //
         tr_internal_vk_cmd_image_transition(p_cmd, p_texture, tr_texture_usage_undefined, tr_texture_usage_transfer_dst);
-        vkCmdCopyBufferToImage(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_texture->vk_image,
+        tr_internal_vk_cmd_flush_barriers(p_cmd);
+        vkCmdCopyBufferToImage(p_cmd->vk_cmd_buf, p_upload_context->staging_buffer->vk_buffer, p_texture->vk_image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region_count, regions);
         tr_internal_vk_cmd_image_transition(p_cmd, p_texture, tr_texture_usage_transfer_dst, tr_texture_usage_sampled_image);
+
+        TINY_RENDERER_SAFE_FREE(regions);
+    }
+
+    TINY_RENDERER_SAFE_FREE(p_expanded_src_data);
+}
+
+void tr_upload_flush(tr_upload_context* p_upload_context, bool wait)
+{
+    assert(NULL != p_upload_context);
+
+    if (p_upload_context->recording) {
+        uint32_t batch_index = p_upload_context->batch_index;
+        tr_cmd* p_cmd = p_upload_context->batch_cmds[batch_index];
         tr_end_cmd(p_cmd);
 
-        tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-        tr_queue_wait_idle(p_queue);
+        TINY_RENDERER_DECLARE_ZERO(VkSubmitInfo, submit_info);
+        submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext              = NULL;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers    = &(p_cmd->vk_cmd_buf);
+        VkResult vk_res = vkQueueSubmit(p_upload_context->queue->vk_queue, 1, &submit_info, p_upload_context->batch_fences[batch_index]->vk_fence);
+        assert(VK_SUCCESS == vk_res);
 
-        tr_destroy_cmd(p_cmd_pool, p_cmd);
-        tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+        p_upload_context->batch_heads[batch_index]   = p_upload_context->head;
+        p_upload_context->batch_pending[batch_index] = true;
+        p_upload_context->batch_index = (batch_index + 1) % tr_max_upload_batches;
+        p_upload_context->recording   = false;
+    }
 
-        tr_destroy_buffer(p_texture->renderer, buffer);
+    if (wait) {
+        while (tr_internal_upload_retire_oldest_batch(p_upload_context)) {
+        }
+    }
+}
 
-        TINY_RENDERER_SAFE_FREE(regions);
+// -------------------------------------------------------------------------------------------------
+// Frame context functions
+// -------------------------------------------------------------------------------------------------
+void tr_create_frame_context(tr_renderer* p_renderer, tr_queue* p_queue, uint32_t frame_count, tr_frame_context** pp_frame_context)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_queue);
+    assert((frame_count > 0) && (frame_count <= tr_max_frames_in_flight));
+
+    tr_frame_context* p_frame_context = (tr_frame_context*)calloc(1, sizeof(*p_frame_context));
+    assert(NULL != p_frame_context);
+
+    p_frame_context->renderer    = p_renderer;
+    p_frame_context->queue       = p_queue;
+    p_frame_context->frame_count = frame_count;
+    p_frame_context->image_count = p_renderer->settings.swapchain.image_count;
+
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        tr_create_cmd_pool_per_frame(p_renderer, p_queue, &(p_frame_context->cmd_pools[i]));
+        tr_create_cmd(p_frame_context->cmd_pools[i], false, &(p_frame_context->cmds[i]));
+        tr_create_fence(p_renderer, &(p_frame_context->render_complete_fences[i]));
+        tr_create_semaphore(p_renderer, &(p_frame_context->image_acquired_semaphores[i]));
+        tr_create_descriptor_allocator(p_renderer, true, 0, &(p_frame_context->descriptor_allocators[i]));
     }
 
-    TINY_RENDERER_SAFE_FREE(p_expanded_src_data);
+    p_frame_context->render_complete_semaphores = (tr_semaphore**)calloc(p_frame_context->image_count, 
+                                                                         sizeof(*(p_frame_context->render_complete_semaphores)));
+    assert(NULL != p_frame_context->render_complete_semaphores);
+
+    for (uint32_t i = 0; i < p_frame_context->image_count; ++i) {
+        tr_create_semaphore(p_renderer, &(p_frame_context->render_complete_semaphores[i]));
+    }
+
+    *pp_frame_context = p_frame_context;
 }
 
-void tr_util_update_texture_float(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data, uint32_t channels, tr_texture* p_texture, tr_image_resize_float_fn resize_fn, void* p_user_data)
+void tr_destroy_frame_context(tr_renderer* p_renderer, tr_frame_context* p_frame_context)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_frame_context);
+
+    for (uint32_t i = 0; i < p_frame_context->frame_count; ++i) {
+        if (p_frame_context->fence_pending[i]) {
+            tr_wait_for_fence(p_renderer, p_frame_context->render_complete_fences[i]);
+        }
+        tr_destroy_descriptor_allocator(p_renderer, p_frame_context->descriptor_allocators[i]);
+        tr_destroy_semaphore(p_renderer, p_frame_context->image_acquired_semaphores[i]);
+        tr_destroy_fence(p_renderer, p_frame_context->render_complete_fences[i]);
+        tr_destroy_cmd(p_frame_context->cmd_pools[i], p_frame_context->cmds[i]);
+        tr_destroy_cmd_pool(p_renderer, p_frame_context->cmd_pools[i]);
+    }
+
+    for (uint32_t i = 0; i < p_frame_context->image_count; ++i) {
+        tr_destroy_semaphore(p_renderer, p_frame_context->render_complete_semaphores[i]);
+    }
+
+    TINY_RENDERER_SAFE_FREE(p_frame_context->render_complete_semaphores);
+    TINY_RENDERER_SAFE_FREE(p_frame_context);
+}
+
+void tr_begin_frame(tr_frame_context* p_frame_context, tr_cmd** pp_cmd, tr_render_target** pp_render_target)
+{
+    assert(NULL != p_frame_context);
+
+    tr_renderer* p_renderer = p_frame_context->renderer;
+    uint32_t frame_index = p_frame_context->frame_index;
+
+    // Only the submission that last used this slot has to finish, the
+    // other slots can still be in flight.
+    if (p_frame_context->fence_pending[frame_index]) {
+        tr_wait_for_fence(p_renderer, p_frame_context->render_complete_fences[frame_index]);
+        p_frame_context->fence_pending[frame_index] = false;
+    }
+
+    // The GPU is done with this slot's command buffers and transient descriptor sets
+    tr_reset_cmd_pool(p_frame_context->cmd_pools[frame_index]);
+    tr_reset_descriptor_allocator(p_frame_context->descriptor_allocators[frame_index]);
+
+    tr_acquire_next_image(p_renderer, p_frame_context->image_acquired_semaphores[frame_index], NULL);
+
+    if (NULL != pp_cmd) {
+        *pp_cmd = p_frame_context->cmds[frame_index];
+    }
+    if (NULL != pp_render_target) {
+        *pp_render_target = p_renderer->swapchain_render_targets[p_renderer->swapchain_image_index];
+    }
+}
+
+void tr_end_frame(tr_frame_context* p_frame_context)
 {
+    assert(NULL != p_frame_context);
+
+    tr_renderer* p_renderer = p_frame_context->renderer;
+    uint32_t frame_index = p_frame_context->frame_index;
+    uint32_t image_index = p_renderer->swapchain_image_index;
+    assert(image_index < p_frame_context->image_count);
+
+    tr_queue_submit(p_frame_context->queue, 
+                    1, &(p_frame_context->cmds[frame_index]), 
+                    1, &(p_frame_context->image_acquired_semaphores[frame_index]), 
+                    1, &(p_frame_context->render_complete_semaphores[image_index]),
+                    p_frame_context->render_complete_fences[frame_index]);
+    p_frame_context->fence_pending[frame_index] = true;
+
+    tr_queue_present(p_renderer->present_queue, 1, &(p_frame_context->render_complete_semaphores[image_index]));
+
+    p_frame_context->frame_index = (frame_index + 1) % p_frame_context->frame_count;
+    ++p_frame_context->frame_number;
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -2775,6 +4235,23 @@ VkSampleCountFlagBits tr_util_to_vk_sample_count(tr_sample_count sample_count)
     return result;
 }
 
+VkDescriptorType tr_util_to_vk_descriptor_type(tr_descriptor_type type)
+{
+    VkDescriptorType result = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    switch (type) {
+        case tr_descriptor_type_sampler                  : result = VK_DESCRIPTOR_TYPE_SAMPLER; break;
+        case tr_descriptor_type_uniform_buffer_cbv       : result = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; break;
+        case tr_descriptor_type_storage_buffer_srv       : result = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; break;
+        case tr_descriptor_type_storage_buffer_uav       : result = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; break;
+        case tr_descriptor_type_uniform_texel_buffer_srv : result = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER; break;
+        case tr_descriptor_type_storage_texel_buffer_uav : result = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER; break;
+        case tr_descriptor_type_texture_srv              : result = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE; break;
+        case tr_descriptor_type_texture_uav              : result = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE; break;
+        case tr_descriptor_type_uniform_buffer_dynamic   : result = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; break;
+    }
+    return result;
+}
+
 VkBufferUsageFlags tr_util_to_vk_buffer_usage(tr_buffer_usage usage)
 {
     VkBufferUsageFlags result = 0;
@@ -3018,7 +4495,7 @@ void tr_internal_vk_create_instance(const char* app_name, tr_renderer* p_rendere
             extensions[extension_count] = p_renderer->settings.instance_extensions.names[extension_count];
           }
         }
-        else {
+        else if (! p_renderer->settings.headless) {
           // Use default extensions
           extensions[extension_count++] = VK_KHR_SURFACE_EXTENSION_NAME;
 #if defined(TINY_RENDERER_GGP)
@@ -3140,10 +4617,12 @@ void tr_internal_vk_create_device(tr_renderer* p_renderer)
             continue;
         }
 
-        // Make sure GPU supports present
-        uint32_t present_queue_family_index = UINT32_MAX;
-        if (! tr_internal_vk_find_present_queue_family(gpu, p_renderer->vk_surface, &present_queue_family_index)) {
-            continue;
+        // Make sure GPU supports present, headless presents on the graphics queue
+        uint32_t present_queue_family_index = graphics_queue_family_index;
+        if (! p_renderer->settings.headless) {
+            if (! tr_internal_vk_find_present_queue_family(gpu, p_renderer->vk_surface, &present_queue_family_index)) {
+                continue;
+            }
         }
             
         if ((UINT32_MAX != graphics_queue_family_index) && (UINT32_MAX != present_queue_family_index)) {
@@ -3163,8 +4642,28 @@ void tr_internal_vk_create_device(tr_renderer* p_renderer)
     VkExtensionProperties exts[tr_max_device_extensions];
     vkEnumerateDeviceExtensionProperties(p_renderer->vk_active_gpu, NULL, &count, NULL);
     vkEnumerateDeviceExtensionProperties(p_renderer->vk_active_gpu, NULL, &count, exts);
+    bool has_swapchain = false;
+    bool has_pipeline_creation_feedback = false;
+    bool has_descriptor_indexing = false;
+    bool has_maintenance3 = false;
+    bool has_draw_indirect_count = false;
     for (uint32_t i =0; i < count; ++i) {
         tr_internal_log(tr_log_type_info, exts[i].extensionName, "vkdevice-ext");
+        if (0 == strcmp(exts[i].extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME)) {
+            has_swapchain = true;
+        }
+        if (0 == strcmp(exts[i].extensionName, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME)) {
+            has_pipeline_creation_feedback = true;
+        }
+        if (0 == strcmp(exts[i].extensionName, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+            has_descriptor_indexing = true;
+        }
+        if (0 == strcmp(exts[i].extensionName, VK_KHR_MAINTENANCE3_EXTENSION_NAME)) {
+            has_maintenance3 = true;
+        }
+        if (0 == strcmp(exts[i].extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+            has_draw_indirect_count = true;
+        }
     }
 
     // Get memory properties
@@ -3195,26 +4694,83 @@ void tr_internal_vk_create_device(tr_renderer* p_renderer)
     // Device extensions
     uint32_t extension_count = 0;
     const char* extensions[tr_max_instance_extensions] = { 0 };
+    bool descriptor_indexing_enabled = false;
     // Copy extensions if they're present
     if (p_renderer->settings.device_extensions.count > 0) {
       for (; extension_count < p_renderer->settings.device_extensions.count; ++extension_count) {
         extensions[extension_count] = p_renderer->settings.device_extensions.names[extension_count];
+        if (0 == strcmp(extensions[extension_count], VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME)) {
+          p_renderer->vk_device_ext_VK_EXT_pipeline_creation_feedback = true;
+        }
+        if (0 == strcmp(extensions[extension_count], VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+          descriptor_indexing_enabled = true;
+        }
+        if (0 == strcmp(extensions[extension_count], VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+          p_renderer->vk_device_ext_VK_KHR_draw_indirect_count = true;
+        }
       }
     }
     else {
-      // Use default extensions
-      extensions[extension_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+      // Use default extensions, headless still enables the swapchain extension
+      // when it's there so transitions to and from tr_texture_usage_present are valid.
+      if ((! p_renderer->settings.headless) || has_swapchain) {
+        extensions[extension_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+      }
       extensions[extension_count++] = VK_KHR_MAINTENANCE1_EXTENSION_NAME;
+      if (has_pipeline_creation_feedback) {
+        extensions[extension_count++] = VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME;
+        p_renderer->vk_device_ext_VK_EXT_pipeline_creation_feedback = true;
+      }
+      if (p_renderer->settings.vk_bindless && has_descriptor_indexing) {
+        // VK_EXT_descriptor_indexing depends on VK_KHR_maintenance3
+        if (has_maintenance3) {
+          extensions[extension_count++] = VK_KHR_MAINTENANCE3_EXTENSION_NAME;
+        }
+        extensions[extension_count++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+        descriptor_indexing_enabled = true;
+      }
+      if (has_draw_indirect_count) {
+        extensions[extension_count++] = VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+        p_renderer->vk_device_ext_VK_KHR_draw_indirect_count = true;
+      }
+    }
+
+    // Bindless tables are runtime sized, partially bound and updated after bind
+    TINY_RENDERER_DECLARE_ZERO(VkPhysicalDeviceDescriptorIndexingFeaturesEXT, descriptor_indexing_features);
+    descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    descriptor_indexing_features.pNext = NULL;
+    if (p_renderer->settings.vk_bindless) {
+        if (descriptor_indexing_enabled) {
+            TINY_RENDERER_DECLARE_ZERO(VkPhysicalDeviceFeatures2, gpu_features2);
+            gpu_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            gpu_features2.pNext = &descriptor_indexing_features;
+            vkGetPhysicalDeviceFeatures2(p_renderer->vk_active_gpu, &gpu_features2);
+
+            p_renderer->vk_device_ext_VK_EXT_descriptor_indexing = 
+                descriptor_indexing_features.runtimeDescriptorArray &&
+                descriptor_indexing_features.descriptorBindingPartiallyBound &&
+                descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+                descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+                descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind;
+        }
+        if (! p_renderer->vk_device_ext_VK_EXT_descriptor_indexing) {
+            tr_internal_log(tr_log_type_warn, "VK_EXT_descriptor_indexing or its update after bind features are missing - disabling bindless", "tr_internal_vk_create_device");
+        }
     }
 
     VkPhysicalDeviceFeatures gpu_features = { 0 };
     vkGetPhysicalDeviceFeatures(p_renderer->vk_active_gpu, &gpu_features);
     gpu_features.multiViewport  = VK_FALSE;
     gpu_features.geometryShader = VK_TRUE;
+    // Indirect draws read multiDrawIndirect from here. drawIndirectFirstInstance
+    // is enabled when the device has it, the arguments are GPU data so it's
+    // up to the app to keep first_instance at 0 when it doesn't.
+    p_renderer->vk_active_gpu_features = gpu_features;
         
     TINY_RENDERER_DECLARE_ZERO(VkDeviceCreateInfo, create_info);
     create_info.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    create_info.pNext                   = NULL;
+    // Enables every descriptor indexing feature the device reported
+    create_info.pNext                   = p_renderer->vk_device_ext_VK_EXT_descriptor_indexing ? &descriptor_indexing_features : NULL;
     create_info.flags                   = 0;
     create_info.queueCreateInfoCount    = queue_create_infos_count;
     create_info.pQueueCreateInfos       = queue_create_infos;
@@ -3226,6 +4782,12 @@ void tr_internal_vk_create_device(tr_renderer* p_renderer)
     vk_res = vkCreateDevice(p_renderer->vk_active_gpu, &create_info, NULL, &(p_renderer->vk_device));
     assert(VK_SUCCESS == vk_res);
 
+    if (p_renderer->vk_device_ext_VK_KHR_draw_indirect_count) {
+        trVkCmdDrawIndirectCountKHR        = (PFN_vkCmdDrawIndirectCountKHR)vkGetDeviceProcAddr(p_renderer->vk_device, "vkCmdDrawIndirectCountKHR");
+        trVkCmdDrawIndexedIndirectCountKHR = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(p_renderer->vk_device, "vkCmdDrawIndexedIndirectCountKHR");
+        p_renderer->vk_device_ext_VK_KHR_draw_indirect_count = (NULL != trVkCmdDrawIndirectCountKHR) && (NULL != trVkCmdDrawIndexedIndirectCountKHR);
+    }
+
     vkGetDeviceQueue(p_renderer->vk_device, p_renderer->graphics_queue->vk_queue_family_index, 0, &(p_renderer->graphics_queue->vk_queue));
     assert(VK_NULL_HANDLE != p_renderer->graphics_queue->vk_queue);
 
@@ -3233,6 +4795,84 @@ void tr_internal_vk_create_device(tr_renderer* p_renderer)
     assert(VK_NULL_HANDLE != p_renderer->present_queue->vk_queue);
 }
 
+// Header written in front of the driver's cache blob, the blob is only handed back
+// to the driver when it was produced by the same device and driver version.
+typedef struct tr_internal_vk_pipeline_cache_header {
+    uint32_t    magic;
+    uint32_t    data_size;
+    uint32_t    vendor_id;
+    uint32_t    device_id;
+    uint32_t    driver_version;
+    uint8_t     pipeline_cache_uuid[VK_UUID_SIZE];
+} tr_internal_vk_pipeline_cache_header;
+
+#define TINY_RENDERER_VK_PIPELINE_CACHE_MAGIC 0x43505254 // 'TRPC'
+
+void tr_internal_vk_create_pipeline_cache(tr_renderer* p_renderer)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    const VkPhysicalDeviceProperties* p_props = &(p_renderer->vk_active_gpu_properties);
+
+    // Load previous cache data if it matches the active device
+    void* data = NULL;
+    size_t data_size = 0;
+    if (NULL != p_renderer->settings.vk_pipeline_cache_path) {
+        FILE* fp = fopen(p_renderer->settings.vk_pipeline_cache_path, "rb");
+        if (NULL != fp) {
+            // A truncated file must not size the allocation below
+            long file_size = -1;
+            if (0 == fseek(fp, 0, SEEK_END)) {
+                file_size = ftell(fp);
+                fseek(fp, 0, SEEK_SET);
+            }
+
+            TINY_RENDERER_DECLARE_ZERO(tr_internal_vk_pipeline_cache_header, header);
+            bool valid = (file_size >= (long)sizeof(header)) &&
+                         (1 == fread(&header, sizeof(header), 1, fp)) &&
+                         (TINY_RENDERER_VK_PIPELINE_CACHE_MAGIC == header.magic) &&
+                         (p_props->vendorID == header.vendor_id) &&
+                         (p_props->deviceID == header.device_id) &&
+                         (p_props->driverVersion == header.driver_version) &&
+                         (0 == memcmp(p_props->pipelineCacheUUID, header.pipeline_cache_uuid, VK_UUID_SIZE)) &&
+                         (header.data_size > 0) &&
+                         ((unsigned long)header.data_size == (unsigned long)file_size - sizeof(header));
+            if (valid) {
+                data = calloc(1, header.data_size);
+                assert(NULL != data);
+                if (1 == fread(data, header.data_size, 1, fp)) {
+                    data_size = header.data_size;
+                }
+                else {
+                    TINY_RENDERER_SAFE_FREE(data);
+                }
+            }
+            fclose(fp);
+
+            if (0 == data_size) {
+                tr_internal_log(tr_log_type_warn, "Discarding stale or invalid pipeline cache file", "tr_internal_vk_create_pipeline_cache");
+            }
+        }
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(VkPipelineCacheCreateInfo, create_info);
+    create_info.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    create_info.pNext           = NULL;
+    create_info.flags           = 0;
+    create_info.initialDataSize = data_size;
+    create_info.pInitialData    = data;
+    VkResult vk_res = vkCreatePipelineCache(p_renderer->vk_device, &create_info, NULL, &(p_renderer->vk_pipeline_cache));
+    if ((VK_SUCCESS != vk_res) && (NULL != data)) {
+        // Driver rejected the data, start over with an empty cache
+        create_info.initialDataSize = 0;
+        create_info.pInitialData    = NULL;
+        vk_res = vkCreatePipelineCache(p_renderer->vk_device, &create_info, NULL, &(p_renderer->vk_pipeline_cache));
+    }
+    assert(VK_SUCCESS == vk_res);
+
+    TINY_RENDERER_SAFE_FREE(data);
+}
+
 void tr_internal_vk_create_swapchain(tr_renderer* p_renderer)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_active_gpu);
@@ -3385,6 +5025,27 @@ void tr_internal_vk_create_swapchain(tr_renderer* p_renderer)
     }
 }
 
+void tr_internal_vk_create_headless_swapchain(tr_renderer* p_renderer)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_active_gpu);
+    assert((p_renderer->settings.width > 0) && (p_renderer->settings.height > 0));
+
+    // Most GPUs will not go beyond VK_SAMPLE_COUNT_8_BIT
+    assert(0 != (p_renderer->vk_active_gpu_properties.limits.framebufferColorSampleCounts & p_renderer->settings.swapchain.sample_count));
+
+    // Same defaults a surface would most likely give us
+    if (0 == p_renderer->settings.swapchain.image_count) {
+        p_renderer->settings.swapchain.image_count = 2;
+    }
+    if (tr_format_undefined == p_renderer->settings.swapchain.color_format) {
+        p_renderer->settings.swapchain.color_format = tr_format_b8g8r8a8_unorm;
+    }
+
+    // Acquire advances before it returns, start on the last image so the
+    // first acquire returns image 0 like a real swapchain would
+    p_renderer->swapchain_image_index = p_renderer->settings.swapchain.image_count - 1;
+}
+
 void tr_internal_create_swapchain_renderpass(tr_renderer* p_renderer)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -3436,6 +5097,10 @@ void tr_internal_create_swapchain_renderpass(tr_renderer* p_renderer)
         render_target->color_attachments[0]->clear_value.b = p_renderer->settings.swapchain.color_clear_value.b;
         render_target->color_attachments[0]->clear_value.a = p_renderer->settings.swapchain.color_clear_value.a;
         render_target->color_attachments[0]->sample_count  = tr_sample_count_1;
+        if (p_renderer->settings.headless) {
+            // Offscreen images are read back instead of presented
+            render_target->color_attachments[0]->usage = (tr_texture_usage)(render_target->color_attachments[0]->usage | tr_texture_usage_transfer_src);
+        }
 
         if (p_renderer->settings.swapchain.sample_count > tr_sample_count_1) {
             render_target->color_attachments_multisample[0]->type          = tr_texture_type_2d;
@@ -3484,17 +5149,20 @@ void tr_internal_vk_create_swapchain_renderpass(tr_renderer* p_renderer)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
-    uint32_t image_count = 0;
-    VkResult vk_res = vkGetSwapchainImagesKHR(p_renderer->vk_device, p_renderer->vk_swapchain, &image_count, NULL);
-    assert(VK_SUCCESS == vk_res);
-
-    assert(image_count == p_renderer->settings.swapchain.image_count);
-
+    uint32_t image_count = p_renderer->settings.swapchain.image_count;
     VkImage* swapchain_images = (VkImage*)calloc(image_count, sizeof(*swapchain_images));
     assert(NULL != swapchain_images);
 
-    vk_res = vkGetSwapchainImagesKHR(p_renderer->vk_device, p_renderer->vk_swapchain, &image_count, swapchain_images);
-    assert(VK_SUCCESS == vk_res);
+    // Headless leaves the images as VK_NULL_HANDLE so the textures allocate their own
+    if (! p_renderer->settings.headless) {
+        VkResult vk_res = vkGetSwapchainImagesKHR(p_renderer->vk_device, p_renderer->vk_swapchain, &image_count, NULL);
+        assert(VK_SUCCESS == vk_res);
+
+        assert(image_count == p_renderer->settings.swapchain.image_count);
+
+        vk_res = vkGetSwapchainImagesKHR(p_renderer->vk_device, p_renderer->vk_swapchain, &image_count, swapchain_images);
+        assert(VK_SUCCESS == vk_res);
+    }
 
     // Populate the vk_image field and create the Vulkan texture objects
     for (size_t i = 0; i < p_renderer->settings.swapchain.image_count; ++i) {
@@ -3521,6 +5189,14 @@ void tr_internal_vk_create_swapchain_renderpass(tr_renderer* p_renderer)
         tr_internal_vk_create_render_target(p_renderer, true, render_target);
     }
 
+    // Put offscreen images where a freshly acquired swapchain image would be
+    if (p_renderer->settings.headless) {
+        for (uint32_t i = 0; i < p_renderer->settings.swapchain.image_count; ++i) {
+            tr_render_target* render_target = p_renderer->swapchain_render_targets[i];
+            tr_util_transition_image(p_renderer->graphics_queue, render_target->color_attachments[0], tr_texture_usage_undefined, tr_texture_usage_present);
+        }
+    }
+
     TINY_RENDERER_SAFE_FREE(swapchain_images);
 }
 
@@ -3544,11 +5220,73 @@ void tr_internal_vk_destroy_surface(tr_renderer* p_renderer)
 
 void tr_internal_vk_destroy_device(tr_renderer* p_renderer)
 {
-    assert(VK_NULL_HANDLE != p_renderer->vk_surface);
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
     vkDestroyDevice(p_renderer->vk_device, NULL);
 }
 
+void tr_internal_vk_destroy_pipeline_cache(tr_renderer* p_renderer)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    if (VK_NULL_HANDLE == p_renderer->vk_pipeline_cache) {
+        return;
+    }
+
+    // Serialize the cache so the next run can skip compilation
+    if (NULL != p_renderer->settings.vk_pipeline_cache_path) {
+        size_t data_size = 0;
+        VkResult vk_res = vkGetPipelineCacheData(p_renderer->vk_device, p_renderer->vk_pipeline_cache, &data_size, NULL);
+        if ((VK_SUCCESS == vk_res) && (data_size > 0)) {
+            void* data = calloc(1, data_size);
+            assert(NULL != data);
+            vk_res = vkGetPipelineCacheData(p_renderer->vk_device, p_renderer->vk_pipeline_cache, &data_size, data);
+            if (VK_SUCCESS == vk_res) {
+                const VkPhysicalDeviceProperties* p_props = &(p_renderer->vk_active_gpu_properties);
+                TINY_RENDERER_DECLARE_ZERO(tr_internal_vk_pipeline_cache_header, header);
+                header.magic          = TINY_RENDERER_VK_PIPELINE_CACHE_MAGIC;
+                header.data_size      = (uint32_t)data_size;
+                header.vendor_id      = p_props->vendorID;
+                header.device_id      = p_props->deviceID;
+                header.driver_version = p_props->driverVersion;
+                memcpy(header.pipeline_cache_uuid, p_props->pipelineCacheUUID, VK_UUID_SIZE);
+
+                // Write to a temporary file and rename it so a failed write
+                // never leaves a partial cache behind
+                const char* path = p_renderer->settings.vk_pipeline_cache_path;
+                size_t path_len = strlen(path);
+                char* tmp_path = (char*)calloc(path_len + 5, sizeof(*tmp_path));
+                assert(NULL != tmp_path);
+                memcpy(tmp_path, path, path_len);
+                memcpy(tmp_path + path_len, ".tmp", 4);
+
+                bool written = false;
+                FILE* fp = fopen(tmp_path, "wb");
+                if (NULL != fp) {
+                    written = (1 == fwrite(&header, sizeof(header), 1, fp)) &&
+                              (1 == fwrite(data, data_size, 1, fp));
+                    written = (0 == fclose(fp)) && written;
+                    if (written) {
+                        remove(path);
+                        written = (0 == rename(tmp_path, path));
+                    }
+                    if (! written) {
+                        remove(tmp_path);
+                    }
+                }
+                if (! written) {
+                    tr_internal_log(tr_log_type_warn, "Unable to write pipeline cache file", "tr_internal_vk_destroy_pipeline_cache");
+                }
+                TINY_RENDERER_SAFE_FREE(tmp_path);
+            }
+            TINY_RENDERER_SAFE_FREE(data);
+        }
+    }
+
+    vkDestroyPipelineCache(p_renderer->vk_device, p_renderer->vk_pipeline_cache, NULL);
+    p_renderer->vk_pipeline_cache = VK_NULL_HANDLE;
+}
+
 void tr_internal_vk_destroy_swapchain(tr_renderer* p_renderer)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_swapchain);
@@ -3558,33 +5296,264 @@ void tr_internal_vk_destroy_swapchain(tr_renderer* p_renderer)
 }
 
 // -------------------------------------------------------------------------------------------------
-// Internal create functions
+// Internal memory functions
 // -------------------------------------------------------------------------------------------------
-void tr_internal_vk_create_fence(tr_renderer *p_renderer, tr_fence* p_fence)
-{   
-    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+static void tr_internal_vk_insert_free_range(tr_memory_block* p_block, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (0 == size) {
+        return;
+    }
 
-    TINY_RENDERER_DECLARE_ZERO(VkFenceCreateInfo, create_info);
-    create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    create_info.pNext = NULL;
-    create_info.flags = 0;
-    VkResult vk_res = vkCreateFence(p_renderer->vk_device,  &create_info, NULL, &(p_fence->vk_fence));
-    assert(VK_SUCCESS == vk_res);
-}
+    // Ranges are kept sorted by offset
+    uint32_t index = 0;
+    while ((index < p_block->free_range_count) && (p_block->free_ranges[index].offset < offset)) {
+        ++index;
+    }
 
-void tr_internal_vk_destroy_fence(tr_renderer *p_renderer, tr_fence* p_fence)
-{   
-    assert(VK_NULL_HANDLE != p_renderer->vk_device);
-    assert(VK_NULL_HANDLE != p_fence->vk_fence);
+    // Merge with previous range and possibly the next one
+    if ((index > 0) && ((p_block->free_ranges[index - 1].offset + p_block->free_ranges[index - 1].size) == offset)) {
+        tr_memory_range* p_prev = &(p_block->free_ranges[index - 1]);
+        p_prev->size += size;
+        if ((index < p_block->free_range_count) && ((p_prev->offset + p_prev->size) == p_block->free_ranges[index].offset)) {
+            p_prev->size += p_block->free_ranges[index].size;
+            memmove(&(p_block->free_ranges[index]), 
+                    &(p_block->free_ranges[index + 1]), 
+                    (p_block->free_range_count - index - 1) * sizeof(*(p_block->free_ranges)));
+            p_block->free_range_count -= 1;
+        }
+        return;
+    }
 
-    vkDestroyFence(p_renderer->vk_device, p_fence->vk_fence, NULL);
-}
+    // Merge with next range
+    if ((index < p_block->free_range_count) && ((offset + size) == p_block->free_ranges[index].offset)) {
+        p_block->free_ranges[index].offset = offset;
+        p_block->free_ranges[index].size  += size;
+        return;
+    }
 
-void tr_internal_vk_create_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore)
-{   
-    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    if (p_block->free_range_count == p_block->free_range_capacity) {
+        uint32_t new_capacity = (0 == p_block->free_range_capacity) ? 16 : (2 * p_block->free_range_capacity);
+        tr_memory_range* new_ranges = (tr_memory_range*)realloc(p_block->free_ranges, new_capacity * sizeof(*new_ranges));
+        assert(NULL != new_ranges);
+        p_block->free_ranges = new_ranges;
+        p_block->free_range_capacity = new_capacity;
+    }
 
-    TINY_RENDERER_DECLARE_ZERO(VkSemaphoreCreateInfo, create_info);
+    memmove(&(p_block->free_ranges[index + 1]), 
+            &(p_block->free_ranges[index]), 
+            (p_block->free_range_count - index) * sizeof(*(p_block->free_ranges)));
+    p_block->free_ranges[index].offset = offset;
+    p_block->free_ranges[index].size   = size;
+    p_block->free_range_count += 1;
+}
+
+static bool tr_internal_vk_block_alloc(tr_memory_block* p_block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* p_offset)
+{
+    // First fit - the free list is small enough in practice that a linear scan is fine
+    for (uint32_t i = 0; i < p_block->free_range_count; ++i) {
+        tr_memory_range range = p_block->free_ranges[i];
+        VkDeviceSize aligned_offset = tr_round_up_64(range.offset, alignment);
+        VkDeviceSize padding = aligned_offset - range.offset;
+        if ((padding + size) > range.size) {
+            continue;
+        }
+
+        // Take the range out and give back whatever is left on either side of the allocation
+        memmove(&(p_block->free_ranges[i]), 
+                &(p_block->free_ranges[i + 1]), 
+                (p_block->free_range_count - i - 1) * sizeof(*(p_block->free_ranges)));
+        p_block->free_range_count -= 1;
+        tr_internal_vk_insert_free_range(p_block, range.offset, padding);
+        tr_internal_vk_insert_free_range(p_block, aligned_offset + size, range.size - padding - size);
+
+        p_block->allocation_count += 1;
+        *p_offset = aligned_offset;
+        return true;
+    }
+    return false;
+}
+
+static void tr_internal_vk_destroy_memory_block(tr_renderer* p_renderer, tr_memory_block* p_block)
+{
+    // Unlink
+    tr_memory_block** pp_link = &(p_renderer->vk_memory_blocks[p_block->memory_type_index]);
+    while ((NULL != *pp_link) && (p_block != *pp_link)) {
+        pp_link = &((*pp_link)->next);
+    }
+    assert(NULL != *pp_link);
+    *pp_link = p_block->next;
+
+    if (NULL != p_block->cpu_mapped_address) {
+        vkUnmapMemory(p_renderer->vk_device, p_block->vk_memory);
+    }
+    vkFreeMemory(p_renderer->vk_device, p_block->vk_memory, NULL);
+
+    TINY_RENDERER_SAFE_FREE(p_block->free_ranges);
+    TINY_RENDERER_SAFE_FREE(p_block);
+}
+
+void tr_internal_vk_allocate_memory(tr_renderer* p_renderer, const VkMemoryRequirements* p_mem_reqs, VkMemoryPropertyFlags mem_flags, bool linear, tr_memory_allocation* p_allocation)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(NULL != p_mem_reqs);
+    assert(NULL != p_allocation);
+
+    uint32_t memory_type_index = UINT32_MAX;
+    bool found_memory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, p_mem_reqs->memoryTypeBits, mem_flags, &memory_type_index);
+    assert(found_memory);
+
+    VkDeviceSize alignment = (p_mem_reqs->alignment > 0) ? p_mem_reqs->alignment : 1;
+    bool dedicated = p_mem_reqs->size > (TINY_RENDERER_MEMORY_BLOCK_SIZE / 2);
+
+    // Try the existing blocks first
+    tr_memory_block* p_block = NULL;
+    VkDeviceSize offset = 0;
+    if (! dedicated) {
+        for (tr_memory_block* p_it = p_renderer->vk_memory_blocks[memory_type_index]; NULL != p_it; p_it = p_it->next) {
+            if (p_it->dedicated || (p_it->linear != linear)) {
+                continue;
+            }
+            if (tr_internal_vk_block_alloc(p_it, p_mem_reqs->size, alignment, &offset)) {
+                p_block = p_it;
+                break;
+            }
+        }
+    }
+
+    // Otherwise, allocate a new block
+    if (NULL == p_block) {
+        VkDeviceSize block_size = dedicated ? p_mem_reqs->size : TINY_RENDERER_MEMORY_BLOCK_SIZE;
+        // Don't let a single block eat up a small heap
+        if (! dedicated) {
+            uint32_t heap_index = p_renderer->vk_memory_properties.memoryTypes[memory_type_index].heapIndex;
+            VkDeviceSize heap_limit = p_renderer->vk_memory_properties.memoryHeaps[heap_index].size / 8;
+            if (block_size > heap_limit) {
+                block_size = (heap_limit > p_mem_reqs->size) ? heap_limit : p_mem_reqs->size;
+            }
+        }
+
+        p_block = (tr_memory_block*)calloc(1, sizeof(*p_block));
+        assert(NULL != p_block);
+
+        p_block->memory_type_index = memory_type_index;
+        p_block->linear            = linear;
+        p_block->dedicated         = dedicated;
+        p_block->size              = block_size;
+
+        TINY_RENDERER_DECLARE_ZERO(VkMemoryAllocateInfo, alloc_info);
+        alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.pNext           = NULL;
+        alloc_info.allocationSize  = block_size;
+        alloc_info.memoryTypeIndex = memory_type_index;
+        VkResult vk_res = vkAllocateMemory(p_renderer->vk_device, &alloc_info, NULL, &(p_block->vk_memory));
+        assert(VK_SUCCESS == vk_res);
+
+        VkMemoryPropertyFlags type_flags = p_renderer->vk_memory_properties.memoryTypes[memory_type_index].propertyFlags;
+        if (type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            vk_res = vkMapMemory(p_renderer->vk_device, p_block->vk_memory, 0, VK_WHOLE_SIZE, 0, &(p_block->cpu_mapped_address));
+            assert(VK_SUCCESS == vk_res);
+        }
+
+        tr_internal_vk_insert_free_range(p_block, 0, block_size);
+
+        p_block->next = p_renderer->vk_memory_blocks[memory_type_index];
+        p_renderer->vk_memory_blocks[memory_type_index] = p_block;
+
+        bool allocated = tr_internal_vk_block_alloc(p_block, p_mem_reqs->size, alignment, &offset);
+        assert(allocated);
+    }
+
+    p_allocation->block  = p_block;
+    p_allocation->offset = offset;
+    p_allocation->size   = p_mem_reqs->size;
+}
+
+void tr_internal_vk_free_memory(tr_renderer* p_renderer, tr_memory_allocation* p_allocation)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(NULL != p_allocation);
+
+    tr_memory_block* p_block = p_allocation->block;
+    if (NULL == p_block) {
+        return;
+    }
+
+    assert(p_block->allocation_count > 0);
+    tr_internal_vk_insert_free_range(p_block, p_allocation->offset, p_allocation->size);
+    p_block->allocation_count -= 1;
+
+    // Release empty blocks, but keep the last block of each kind around so 
+    // create/destroy churn doesn't end up in vkAllocateMemory every time.
+    if (0 == p_block->allocation_count) {
+        bool release = p_block->dedicated;
+        if (! release) {
+            for (tr_memory_block* p_it = p_renderer->vk_memory_blocks[p_block->memory_type_index]; NULL != p_it; p_it = p_it->next) {
+                if ((p_it != p_block) && (! p_it->dedicated) && (p_it->linear == p_block->linear)) {
+                    release = true;
+                    break;
+                }
+            }
+        }
+        if (release) {
+            tr_internal_vk_destroy_memory_block(p_renderer, p_block);
+        }
+    }
+
+    memset(p_allocation, 0, sizeof(*p_allocation));
+}
+
+void tr_internal_vk_destroy_memory_blocks(tr_renderer* p_renderer)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+        while (NULL != p_renderer->vk_memory_blocks[i]) {
+            tr_internal_vk_destroy_memory_block(p_renderer, p_renderer->vk_memory_blocks[i]);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Internal create functions
+// -------------------------------------------------------------------------------------------------
+void tr_internal_vk_create_fence(tr_renderer *p_renderer, tr_fence* p_fence)
+{   
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    TINY_RENDERER_DECLARE_ZERO(VkFenceCreateInfo, create_info);
+    create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    VkResult vk_res = vkCreateFence(p_renderer->vk_device,  &create_info, NULL, &(p_fence->vk_fence));
+    assert(VK_SUCCESS == vk_res);
+}
+
+void tr_internal_vk_destroy_fence(tr_renderer *p_renderer, tr_fence* p_fence)
+{   
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(VK_NULL_HANDLE != p_fence->vk_fence);
+
+    vkDestroyFence(p_renderer->vk_device, p_fence->vk_fence, NULL);
+}
+
+void tr_internal_vk_wait_for_fence(tr_renderer *p_renderer, tr_fence* p_fence)
+{   
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(VK_NULL_HANDLE != p_fence->vk_fence);
+
+    VkResult vk_res = vkWaitForFences(p_renderer->vk_device, 1, &(p_fence->vk_fence), VK_TRUE, UINT64_MAX);
+    assert(VK_SUCCESS == vk_res);
+
+    // Reset so the fence can be passed to the next submit
+    vk_res = vkResetFences(p_renderer->vk_device, 1, &(p_fence->vk_fence));
+    assert(VK_SUCCESS == vk_res);
+}
+
+void tr_internal_vk_create_semaphore(tr_renderer *p_renderer, tr_semaphore* p_semaphore)
+{   
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    TINY_RENDERER_DECLARE_ZERO(VkSemaphoreCreateInfo, create_info);
     create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     create_info.pNext = NULL;
     create_info.flags = 0;
@@ -3600,24 +5569,330 @@ void tr_internal_vk_destroy_semaphore(tr_renderer *p_renderer, tr_semaphore* p_s
     vkDestroySemaphore(p_renderer->vk_device, p_semaphore->vk_semaphore, NULL);
 }
 
+// FNV-1a
+static uint64_t tr_internal_hash(uint64_t hash, const void* p_data, size_t size)
+{
+    const uint8_t* p_bytes = (const uint8_t*)p_data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= p_bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static const uint64_t tr_internal_hash_seed = 14695981039346656037ULL;
+
+static tr_descriptor_set_layout_entry* tr_internal_vk_acquire_descriptor_set_layout(tr_renderer* p_renderer, uint32_t binding_count, VkDescriptorSetLayoutBinding* p_bindings)
+{
+    // Sort by binding so the declaration order of descriptors doesn't matter
+    for (uint32_t i = 1; i < binding_count; ++i) {
+        VkDescriptorSetLayoutBinding binding = p_bindings[i];
+        uint32_t j = i;
+        while ((j > 0) && (p_bindings[j - 1].binding > binding.binding)) {
+            p_bindings[j] = p_bindings[j - 1];
+            --j;
+        }
+        p_bindings[j] = binding;
+    }
+
+    // Immutable samplers aren't used so only these fields make up the key
+    uint64_t hash = tr_internal_hash(tr_internal_hash_seed, &binding_count, sizeof(binding_count));
+    for (uint32_t i = 0; i < binding_count; ++i) {
+        const VkDescriptorSetLayoutBinding* binding = &(p_bindings[i]);
+        hash = tr_internal_hash(hash, &(binding->binding), sizeof(binding->binding));
+        hash = tr_internal_hash(hash, &(binding->descriptorType), sizeof(binding->descriptorType));
+        hash = tr_internal_hash(hash, &(binding->descriptorCount), sizeof(binding->descriptorCount));
+        hash = tr_internal_hash(hash, &(binding->stageFlags), sizeof(binding->stageFlags));
+    }
+
+    for (tr_descriptor_set_layout_entry* p_entry = p_renderer->vk_descriptor_set_layouts; NULL != p_entry; p_entry = p_entry->next) {
+        if ((p_entry->hash != hash) || (p_entry->binding_count != binding_count)) {
+            continue;
+        }
+        bool match = true;
+        for (uint32_t i = 0; i < binding_count; ++i) {
+            const VkDescriptorSetLayoutBinding* a = &(p_entry->bindings[i]);
+            const VkDescriptorSetLayoutBinding* b = &(p_bindings[i]);
+            if ((a->binding != b->binding) || (a->descriptorType != b->descriptorType) || (a->descriptorCount != b->descriptorCount) || (a->stageFlags != b->stageFlags)) {
+                match = false;
+                break;
+            }
+        }
+        if (match) {
+            p_entry->ref_count += 1;
+            return p_entry;
+        }
+    }
+
+    tr_descriptor_set_layout_entry* p_entry = (tr_descriptor_set_layout_entry*)calloc(1, sizeof(*p_entry));
+    assert(NULL != p_entry);
+
+    p_entry->hash          = hash;
+    p_entry->binding_count = binding_count;
+    p_entry->ref_count     = 1;
+    if (binding_count > 0) {
+        p_entry->bindings = (VkDescriptorSetLayoutBinding*)calloc(binding_count, sizeof(*(p_entry->bindings)));
+        assert(NULL != p_entry->bindings);
+        memcpy(p_entry->bindings, p_bindings, binding_count * sizeof(*(p_entry->bindings)));
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorSetLayoutCreateInfo, create_info);
+    create_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    create_info.pNext        = NULL;
+    create_info.flags        = 0;
+    create_info.bindingCount = binding_count;
+    create_info.pBindings    = p_entry->bindings;
+    VkResult vk_res = vkCreateDescriptorSetLayout(p_renderer->vk_device, &create_info, NULL, &(p_entry->vk_descriptor_set_layout));
+    assert(VK_SUCCESS == vk_res);
+
+    p_entry->next = p_renderer->vk_descriptor_set_layouts;
+    p_renderer->vk_descriptor_set_layouts = p_entry;
+
+    return p_entry;
+}
+
+static void tr_internal_vk_release_descriptor_set_layout(tr_renderer* p_renderer, tr_descriptor_set_layout_entry* p_entry)
+{
+    assert(p_entry->ref_count > 0);
+
+    p_entry->ref_count -= 1;
+    if (p_entry->ref_count > 0) {
+        return;
+    }
+
+    tr_descriptor_set_layout_entry** pp_link = &(p_renderer->vk_descriptor_set_layouts);
+    while (*pp_link != p_entry) {
+        assert(NULL != *pp_link);
+        pp_link = &((*pp_link)->next);
+    }
+    *pp_link = p_entry->next;
+
+    vkDestroyDescriptorSetLayout(p_renderer->vk_device, p_entry->vk_descriptor_set_layout, NULL);
+    TINY_RENDERER_SAFE_FREE(p_entry->bindings);
+    TINY_RENDERER_SAFE_FREE(p_entry);
+}
+
+static tr_pipeline_layout_entry* tr_internal_vk_acquire_pipeline_layout(tr_renderer* p_renderer, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t push_constant_range_count, const VkPushConstantRange* p_push_constant_ranges)
+{
+    assert(descriptor_set_count <= tr_max_descriptor_sets);
+    assert(push_constant_range_count <= tr_max_push_constant_ranges);
+
+    // Every set below descriptor_set_count needs a layout, even if the shaders skip it
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorSetLayout, set_layouts[tr_max_descriptor_sets]);
+    for (uint32_t i = 0; i < descriptor_set_count; ++i) {
+        assert(NULL != pp_descriptor_sets[i]);
+        assert(VK_NULL_HANDLE != pp_descriptor_sets[i]->vk_descriptor_set_layout);
+        set_layouts[i] = pp_descriptor_sets[i]->vk_descriptor_set_layout;
+    }
+
+    uint64_t hash = tr_internal_hash(tr_internal_hash_seed, &descriptor_set_count, sizeof(descriptor_set_count));
+    hash = tr_internal_hash(hash, set_layouts, descriptor_set_count * sizeof(*set_layouts));
+    hash = tr_internal_hash(hash, &push_constant_range_count, sizeof(push_constant_range_count));
+    for (uint32_t i = 0; i < push_constant_range_count; ++i) {
+        const VkPushConstantRange* range = &(p_push_constant_ranges[i]);
+        hash = tr_internal_hash(hash, &(range->stageFlags), sizeof(range->stageFlags));
+        hash = tr_internal_hash(hash, &(range->offset), sizeof(range->offset));
+        hash = tr_internal_hash(hash, &(range->size), sizeof(range->size));
+    }
+
+    for (tr_pipeline_layout_entry* p_entry = p_renderer->vk_pipeline_layouts; NULL != p_entry; p_entry = p_entry->next) {
+        if ((p_entry->hash != hash) || (p_entry->set_layout_count != descriptor_set_count) || (p_entry->push_constant_range_count != push_constant_range_count)) {
+            continue;
+        }
+        bool match = (0 == memcmp(p_entry->set_layouts, set_layouts, descriptor_set_count * sizeof(*set_layouts)));
+        for (uint32_t i = 0; match && (i < push_constant_range_count); ++i) {
+            const VkPushConstantRange* a = &(p_entry->push_constant_ranges[i]);
+            const VkPushConstantRange* b = &(p_push_constant_ranges[i]);
+            match = (a->stageFlags == b->stageFlags) && (a->offset == b->offset) && (a->size == b->size);
+        }
+        if (match) {
+            p_entry->ref_count += 1;
+            return p_entry;
+        }
+    }
+
+    tr_pipeline_layout_entry* p_entry = (tr_pipeline_layout_entry*)calloc(1, sizeof(*p_entry));
+    assert(NULL != p_entry);
+
+    p_entry->hash                      = hash;
+    p_entry->set_layout_count          = descriptor_set_count;
+    p_entry->push_constant_range_count = push_constant_range_count;
+    p_entry->ref_count                 = 1;
+    for (uint32_t i = 0; i < descriptor_set_count; ++i) {
+        p_entry->set_layouts[i] = set_layouts[i];
+        // The bindless set layout isn't cached and lives as long as the renderer
+        tr_descriptor_set_layout_entry* p_set_layout_entry = pp_descriptor_sets[i]->vk_descriptor_set_layout_entry;
+        if (NULL != p_set_layout_entry) {
+            p_set_layout_entry->ref_count += 1;
+        }
+        p_entry->set_layout_entries[i] = p_set_layout_entry;
+    }
+    for (uint32_t i = 0; i < push_constant_range_count; ++i) {
+        p_entry->push_constant_ranges[i] = p_push_constant_ranges[i];
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(VkPipelineLayoutCreateInfo, create_info);
+    create_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    create_info.pNext                  = NULL;
+    create_info.flags                  = 0;
+    create_info.setLayoutCount         = descriptor_set_count;
+    create_info.pSetLayouts            = (descriptor_set_count > 0) ? p_entry->set_layouts : NULL;
+    create_info.pushConstantRangeCount = push_constant_range_count;
+    create_info.pPushConstantRanges    = (push_constant_range_count > 0) ? p_entry->push_constant_ranges : NULL;
+    VkResult vk_res = vkCreatePipelineLayout(p_renderer->vk_device, &create_info, NULL, &(p_entry->vk_pipeline_layout));
+    assert(VK_SUCCESS == vk_res);
+
+    p_entry->next = p_renderer->vk_pipeline_layouts;
+    p_renderer->vk_pipeline_layouts = p_entry;
+
+    return p_entry;
+}
+
+static void tr_internal_vk_release_pipeline_layout(tr_renderer* p_renderer, tr_pipeline_layout_entry* p_entry)
+{
+    assert(p_entry->ref_count > 0);
+
+    p_entry->ref_count -= 1;
+    if (p_entry->ref_count > 0) {
+        return;
+    }
+
+    tr_pipeline_layout_entry** pp_link = &(p_renderer->vk_pipeline_layouts);
+    while (*pp_link != p_entry) {
+        assert(NULL != *pp_link);
+        pp_link = &((*pp_link)->next);
+    }
+    *pp_link = p_entry->next;
+
+    vkDestroyPipelineLayout(p_renderer->vk_device, p_entry->vk_pipeline_layout, NULL);
+    for (uint32_t i = 0; i < p_entry->set_layout_count; ++i) {
+        if (NULL != p_entry->set_layout_entries[i]) {
+            tr_internal_vk_release_descriptor_set_layout(p_renderer, p_entry->set_layout_entries[i]);
+        }
+    }
+    TINY_RENDERER_SAFE_FREE(p_entry);
+}
+
+void tr_internal_vk_destroy_layout_caches(tr_renderer* p_renderer)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    // Pipeline layouts first, they hold references on the set layouts
+    tr_pipeline_layout_entry* p_pipeline_layout = p_renderer->vk_pipeline_layouts;
+    while (NULL != p_pipeline_layout) {
+        tr_pipeline_layout_entry* p_next = p_pipeline_layout->next;
+        vkDestroyPipelineLayout(p_renderer->vk_device, p_pipeline_layout->vk_pipeline_layout, NULL);
+        TINY_RENDERER_SAFE_FREE(p_pipeline_layout);
+        p_pipeline_layout = p_next;
+    }
+    p_renderer->vk_pipeline_layouts = NULL;
+
+    tr_descriptor_set_layout_entry* p_set_layout = p_renderer->vk_descriptor_set_layouts;
+    while (NULL != p_set_layout) {
+        tr_descriptor_set_layout_entry* p_next = p_set_layout->next;
+        vkDestroyDescriptorSetLayout(p_renderer->vk_device, p_set_layout->vk_descriptor_set_layout, NULL);
+        TINY_RENDERER_SAFE_FREE(p_set_layout->bindings);
+        TINY_RENDERER_SAFE_FREE(p_set_layout);
+        p_set_layout = p_next;
+    }
+    p_renderer->vk_descriptor_set_layouts = NULL;
+}
+
+static tr_descriptor_pool* tr_internal_vk_create_descriptor_pool(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator, const uint32_t* p_size_class)
+{
+    tr_descriptor_pool* p_pool = (tr_descriptor_pool*)calloc(1, sizeof(*p_pool));
+    assert(NULL != p_pool);
+
+    memcpy(p_pool->size_class, p_size_class, sizeof(p_pool->size_class));
+    p_pool->max_sets = p_descriptor_allocator->sets_per_pool;
+
+    uint32_t pool_size_count = 0;
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorPoolSize, pool_sizes[tr_max_descriptor_types]);
+    for (uint32_t i = 0; i < tr_max_descriptor_types; ++i) {
+        if (p_size_class[i] > 0) {
+            pool_sizes[pool_size_count].type = (VkDescriptorType)i;
+            pool_sizes[pool_size_count].descriptorCount = p_size_class[i] * p_pool->max_sets;
+            ++pool_size_count;
+        }
+    }
+
+    assert(0 != pool_size_count);
+
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorPoolCreateInfo, create_info);
+    create_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    create_info.pNext         = NULL;
+    create_info.flags         = p_descriptor_allocator->transient ? 0 : VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    create_info.maxSets       = p_pool->max_sets;
+    create_info.poolSizeCount = pool_size_count;
+    create_info.pPoolSizes    = pool_sizes;
+    VkResult vk_res = vkCreateDescriptorPool(p_renderer->vk_device, &create_info, NULL, &(p_pool->vk_descriptor_pool));
+    assert(VK_SUCCESS == vk_res);
+
+    p_pool->next = p_descriptor_allocator->pools;
+    p_descriptor_allocator->pools = p_pool;
+
+    return p_pool;
+}
+
+static bool tr_internal_vk_descriptor_pool_alloc(tr_renderer* p_renderer, tr_descriptor_pool* p_pool, VkDescriptorSetLayout vk_layout, VkDescriptorSet* p_vk_descriptor_set)
+{
+    if (p_pool->exhausted || (p_pool->allocated_count >= p_pool->max_sets)) {
+        return false;
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorSetAllocateInfo, alloc_info);
+    alloc_info.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.pNext              = NULL;
+    alloc_info.descriptorPool     = p_pool->vk_descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts        = &vk_layout;
+    VkResult vk_res = vkAllocateDescriptorSets(p_renderer->vk_device, &alloc_info, p_vk_descriptor_set);
+    if (VK_SUCCESS != vk_res) {
+        // Out of pool memory or fragmented, skip this pool until a set is returned
+        assert((VK_ERROR_OUT_OF_POOL_MEMORY == vk_res) || (VK_ERROR_FRAGMENTED_POOL == vk_res));
+        p_pool->exhausted = true;
+        return false;
+    }
+
+    p_pool->allocated_count += 1;
+    return true;
+}
+
+void tr_internal_vk_destroy_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    tr_descriptor_pool* p_pool = p_descriptor_allocator->pools;
+    while (NULL != p_pool) {
+        tr_descriptor_pool* p_next = p_pool->next;
+        vkDestroyDescriptorPool(p_renderer->vk_device, p_pool->vk_descriptor_pool, NULL);
+        TINY_RENDERER_SAFE_FREE(p_pool);
+        p_pool = p_next;
+    }
+    p_descriptor_allocator->pools = NULL;
+}
+
+void tr_internal_vk_reset_descriptor_allocator(tr_renderer* p_renderer, tr_descriptor_allocator* p_descriptor_allocator)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    for (tr_descriptor_pool* p_pool = p_descriptor_allocator->pools; NULL != p_pool; p_pool = p_pool->next) {
+        if (0 == p_pool->allocated_count) {
+            continue;
+        }
+        VkResult vk_res = vkResetDescriptorPool(p_renderer->vk_device, p_pool->vk_descriptor_pool, 0);
+        assert(VK_SUCCESS == vk_res);
+        p_pool->allocated_count = 0;
+        p_pool->exhausted = false;
+    }
+}
+
 void tr_internal_vk_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(NULL != p_descriptor_set->allocator);
 
-    enum {max_types = 12};
-
-    TINY_RENDERER_DECLARE_ZERO(VkDescriptorPoolSize, pool_sizes_by_type[max_types]);
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_SAMPLER               ].type = VK_DESCRIPTOR_TYPE_SAMPLER;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE         ].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_STORAGE_IMAGE         ].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER  ].type = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER  ].type = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER        ].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER        ].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
-    pool_sizes_by_type[VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT      ].type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    uint32_t descriptor_counts[tr_max_descriptor_types] = { 0 };
 
     VkDescriptorSetLayoutBinding* bindings = (VkDescriptorSetLayoutBinding*)calloc(p_descriptor_set->descriptor_count, sizeof(*bindings));
     assert(NULL != bindings);
@@ -3635,6 +5910,7 @@ void tr_internal_vk_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor
             case tr_descriptor_type_storage_texel_buffer_uav : type_index = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER; break;
             case tr_descriptor_type_texture_srv              : type_index = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE; break;
             case tr_descriptor_type_texture_uav              : type_index = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE; break;
+            case tr_descriptor_type_uniform_buffer_dynamic   : type_index = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; break;
         }
         if (UINT32_MAX != type_index) {
             binding->binding            = descriptor->binding;
@@ -3643,87 +5919,297 @@ void tr_internal_vk_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor
             binding->stageFlags         = tr_util_to_vk_shader_stages(descriptor->shader_stages);
             binding->pImmutableSamplers = NULL;
 
-            pool_sizes_by_type[type_index].descriptorCount += descriptor->count;
+            descriptor_counts[type_index] += descriptor->count;
         }
     }
 
-    uint32_t pool_size_count = 0;
-    TINY_RENDERER_DECLARE_ZERO(VkDescriptorPoolSize, pool_sizes[max_types]);
-    for (uint32_t i = 0; i < max_types; ++i) {
-        if (pool_sizes_by_type[i].descriptorCount > 0) {
-            pool_sizes[pool_size_count].type = pool_sizes_by_type[i].type;
-            pool_sizes[pool_size_count].descriptorCount = pool_sizes_by_type[i].descriptorCount;
-            ++pool_size_count;
+    // Per element state for incremental updates
+    uint32_t element_count = 0;
+    for (uint32_t i = 0; i < p_descriptor_set->descriptor_count; ++i) {
+        tr_descriptor* descriptor = &(p_descriptor_set->descriptors[i]);
+        descriptor->vk_element_offset = element_count;
+        element_count += descriptor->count;
+    }
+    p_descriptor_set->vk_element_count = element_count;
+    if (element_count > 0) {
+        p_descriptor_set->vk_written_resource_ids = (uint64_t*)calloc(element_count, sizeof(*(p_descriptor_set->vk_written_resource_ids)));
+        assert(NULL != p_descriptor_set->vk_written_resource_ids);
+        p_descriptor_set->vk_image_infos = (VkDescriptorImageInfo*)calloc(element_count, sizeof(*(p_descriptor_set->vk_image_infos)));
+        assert(NULL != p_descriptor_set->vk_image_infos);
+        p_descriptor_set->vk_buffer_infos = (VkDescriptorBufferInfo*)calloc(element_count, sizeof(*(p_descriptor_set->vk_buffer_infos)));
+        assert(NULL != p_descriptor_set->vk_buffer_infos);
+        p_descriptor_set->vk_texel_buffer_views = (VkBufferView*)calloc(element_count, sizeof(*(p_descriptor_set->vk_texel_buffer_views)));
+        assert(NULL != p_descriptor_set->vk_texel_buffer_views);
+        // At most one write per element
+        p_descriptor_set->vk_writes = (VkWriteDescriptorSet*)calloc(element_count, sizeof(*(p_descriptor_set->vk_writes)));
+        assert(NULL != p_descriptor_set->vk_writes);
+    }
+
+    // Round each count up to a power of two to get the pool size class
+    uint32_t size_class[tr_max_descriptor_types] = { 0 };
+    for (uint32_t i = 0; i < tr_max_descriptor_types; ++i) {
+        uint32_t count = descriptor_counts[i];
+        if (count > 0) {
+            size_class[i] = 1;
+            while (size_class[i] < count) {
+                size_class[i] <<= 1;
+            }
         }
     }
 
-    assert(0 != pool_size_count);
+    // Descriptor set layout, shared with other sets that have the same bindings
+    p_descriptor_set->vk_descriptor_set_layout_entry = tr_internal_vk_acquire_descriptor_set_layout(p_renderer, p_descriptor_set->descriptor_count, bindings);
+    p_descriptor_set->vk_descriptor_set_layout = p_descriptor_set->vk_descriptor_set_layout_entry->vk_descriptor_set_layout;
 
-    // Descriptor pool
+    // Allocate descriptor set from the first pool of the same size class that has room
     {
-        TINY_RENDERER_DECLARE_ZERO(VkDescriptorPoolCreateInfo, create_info);
-        create_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        create_info.pNext         = NULL;
-        create_info.flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT ;
-        create_info.maxSets       = 1;
-        create_info.poolSizeCount = pool_size_count;
-        create_info.pPoolSizes    = pool_sizes;
-        VkResult vk_res = vkCreateDescriptorPool(p_renderer->vk_device, &create_info, NULL, &(p_descriptor_set->vk_descriptor_pool));
+        tr_descriptor_allocator* p_allocator = p_descriptor_set->allocator;
+        for (tr_descriptor_pool* p_pool = p_allocator->pools; NULL != p_pool; p_pool = p_pool->next) {
+            if (0 != memcmp(p_pool->size_class, size_class, sizeof(size_class))) {
+                continue;
+            }
+            if (tr_internal_vk_descriptor_pool_alloc(p_renderer, p_pool, p_descriptor_set->vk_descriptor_set_layout, &(p_descriptor_set->vk_descriptor_set))) {
+                p_descriptor_set->pool = p_pool;
+                break;
+            }
+        }
+
+        if (NULL == p_descriptor_set->pool) {
+            tr_descriptor_pool* p_pool = tr_internal_vk_create_descriptor_pool(p_renderer, p_allocator, size_class);
+            bool allocated = tr_internal_vk_descriptor_pool_alloc(p_renderer, p_pool, p_descriptor_set->vk_descriptor_set_layout, &(p_descriptor_set->vk_descriptor_set));
+            assert(allocated);
+            p_descriptor_set->pool = p_pool;
+        }
+    }
+
+    TINY_RENDERER_SAFE_FREE(bindings);
+}
+
+void tr_internal_vk_destroy_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(VK_NULL_HANDLE != p_descriptor_set->vk_descriptor_set_layout);
+    assert(VK_NULL_HANDLE != p_descriptor_set->vk_descriptor_set);
+    assert(NULL != p_descriptor_set->pool);
+
+    // Sets from transient allocators go back to their pool on reset
+    if (! p_descriptor_set->allocator->transient) {
+        tr_descriptor_pool* p_pool = p_descriptor_set->pool;
+        VkResult vk_res = vkFreeDescriptorSets(p_renderer->vk_device, p_pool->vk_descriptor_pool, 1, &(p_descriptor_set->vk_descriptor_set));
         assert(VK_SUCCESS == vk_res);
+        p_pool->allocated_count -= 1;
+        p_pool->exhausted = false;
+    }
+
+    // Pipelines created with this set keep their own reference on the layout
+    tr_internal_vk_release_descriptor_set_layout(p_renderer, p_descriptor_set->vk_descriptor_set_layout_entry);
+    p_descriptor_set->vk_descriptor_set_layout_entry = NULL;
+    p_descriptor_set->vk_descriptor_set_layout = VK_NULL_HANDLE;
+
+    TINY_RENDERER_SAFE_FREE(p_descriptor_set->vk_written_resource_ids);
+    TINY_RENDERER_SAFE_FREE(p_descriptor_set->vk_image_infos);
+    TINY_RENDERER_SAFE_FREE(p_descriptor_set->vk_buffer_infos);
+    TINY_RENDERER_SAFE_FREE(p_descriptor_set->vk_texel_buffer_views);
+    TINY_RENDERER_SAFE_FREE(p_descriptor_set->vk_writes);
+}
+
+void tr_internal_vk_create_bindless_descriptor_set(tr_renderer* p_renderer)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    if (! p_renderer->vk_device_ext_VK_EXT_descriptor_indexing) {
+        return;
+    }
+
+    const uint32_t table_capacities[tr_bindless_table_type_count] = { 
+        tr_max_bindless_textures, 
+        tr_max_bindless_storage_buffers, 
+        tr_max_bindless_samplers 
+    };
+    const tr_descriptor_type table_descriptor_types[tr_bindless_table_type_count] = {
+        tr_descriptor_type_texture_srv,
+        tr_descriptor_type_storage_buffer_uav,
+        tr_descriptor_type_sampler
+    };
+    const VkDescriptorType table_vk_descriptor_types[tr_bindless_table_type_count] = {
+        VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_SAMPLER
+    };
+
+    tr_descriptor_set* p_descriptor_set = (tr_descriptor_set*)calloc(1, sizeof(*p_descriptor_set));
+    assert(NULL != p_descriptor_set);
+
+    p_descriptor_set->descriptors = (tr_descriptor*)calloc(tr_bindless_table_type_count, sizeof(*(p_descriptor_set->descriptors)));
+    assert(NULL != p_descriptor_set->descriptors);
+    p_descriptor_set->descriptor_count = tr_bindless_table_type_count;
+
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorSetLayoutBinding, bindings[tr_bindless_table_type_count]);
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorBindingFlagsEXT, binding_flags[tr_bindless_table_type_count]);
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorPoolSize, pool_sizes[tr_bindless_table_type_count]);
+    for (uint32_t i = 0; i < tr_bindless_table_type_count; ++i) {
+        tr_descriptor* descriptor = &(p_descriptor_set->descriptors[i]);
+        descriptor->type          = table_descriptor_types[i];
+        descriptor->binding       = i;
+        descriptor->count         = table_capacities[i];
+        descriptor->shader_stages = (tr_shader_stage)(tr_shader_stage_all_graphics | tr_shader_stage_comp);
+
+        bindings[i].binding            = descriptor->binding;
+        bindings[i].descriptorType     = table_vk_descriptor_types[i];
+        bindings[i].descriptorCount    = descriptor->count;
+        bindings[i].stageFlags         = tr_util_to_vk_shader_stages(descriptor->shader_stages);
+        bindings[i].pImmutableSamplers = NULL;
+
+        // Slots are written while the table is bound and only the ones a 
+        // draw indexes need to be valid
+        binding_flags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT |
+                           VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+
+        pool_sizes[i].type            = table_vk_descriptor_types[i];
+        pool_sizes[i].descriptorCount = descriptor->count;
+
+        tr_bindless_table* p_table = &(p_renderer->bindless_tables[i]);
+        p_table->capacity         = table_capacities[i];
+        p_table->high_water_index = 1;
+        p_table->free_count       = 0;
+        p_table->free_indices     = (uint32_t*)calloc(p_table->capacity, sizeof(*(p_table->free_indices)));
+        assert(NULL != p_table->free_indices);
     }
 
     // Descriptor set layout
     {
+        TINY_RENDERER_DECLARE_ZERO(VkDescriptorSetLayoutBindingFlagsCreateInfoEXT, binding_flags_info);
+        binding_flags_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        binding_flags_info.pNext         = NULL;
+        binding_flags_info.bindingCount  = tr_bindless_table_type_count;
+        binding_flags_info.pBindingFlags = binding_flags;
+
         TINY_RENDERER_DECLARE_ZERO(VkDescriptorSetLayoutCreateInfo, create_info);
         create_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        create_info.pNext        = NULL;
-        create_info.flags        = 0;
-        create_info.bindingCount = p_descriptor_set->descriptor_count;
+        create_info.pNext        = &binding_flags_info;
+        create_info.flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        create_info.bindingCount = tr_bindless_table_type_count;
         create_info.pBindings    = bindings;
         VkResult vk_res = vkCreateDescriptorSetLayout(p_renderer->vk_device, &create_info, NULL, &(p_descriptor_set->vk_descriptor_set_layout));
         assert(VK_SUCCESS == vk_res);
     }
 
-    // Allocate descriptor set
-    {
-        TINY_RENDERER_DECLARE_ZERO(VkDescriptorSetAllocateInfo, alloc_info);
-        alloc_info.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        alloc_info.pNext              = NULL;
-        alloc_info.descriptorPool     = p_descriptor_set->vk_descriptor_pool;
-        alloc_info.descriptorSetCount = 1;
-        alloc_info.pSetLayouts        = &(p_descriptor_set->vk_descriptor_set_layout);
-        VkResult vk_res = vkAllocateDescriptorSets(p_renderer->vk_device, &alloc_info, &(p_descriptor_set->vk_descriptor_set));
-        assert(VK_SUCCESS == vk_res);
+    // Dedicated pool, update after bind sets can't come from regular pools
+    {
+        TINY_RENDERER_DECLARE_ZERO(VkDescriptorPoolCreateInfo, create_info);
+        create_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        create_info.pNext         = NULL;
+        create_info.flags         = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+        create_info.maxSets       = 1;
+        create_info.poolSizeCount = tr_bindless_table_type_count;
+        create_info.pPoolSizes    = pool_sizes;
+        VkResult vk_res = vkCreateDescriptorPool(p_renderer->vk_device, &create_info, NULL, &(p_renderer->vk_bindless_descriptor_pool));
+        assert(VK_SUCCESS == vk_res);
+
+        TINY_RENDERER_DECLARE_ZERO(VkDescriptorSetAllocateInfo, alloc_info);
+        alloc_info.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.pNext              = NULL;
+        alloc_info.descriptorPool     = p_renderer->vk_bindless_descriptor_pool;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts        = &(p_descriptor_set->vk_descriptor_set_layout);
+        vk_res = vkAllocateDescriptorSets(p_renderer->vk_device, &alloc_info, &(p_descriptor_set->vk_descriptor_set));
+        assert(VK_SUCCESS == vk_res);
+    }
+
+    p_renderer->bindless_descriptor_set = p_descriptor_set;
+}
+
+void tr_internal_vk_destroy_bindless_descriptor_set(tr_renderer* p_renderer)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    tr_descriptor_set* p_descriptor_set = p_renderer->bindless_descriptor_set;
+    if (NULL == p_descriptor_set) {
+        return;
+    }
+
+    // The set goes away with its pool
+    vkDestroyDescriptorPool(p_renderer->vk_device, p_renderer->vk_bindless_descriptor_pool, NULL);
+    vkDestroyDescriptorSetLayout(p_renderer->vk_device, p_descriptor_set->vk_descriptor_set_layout, NULL);
+    p_renderer->vk_bindless_descriptor_pool = VK_NULL_HANDLE;
+
+    for (uint32_t i = 0; i < tr_bindless_table_type_count; ++i) {
+        TINY_RENDERER_SAFE_FREE(p_renderer->bindless_tables[i].free_indices);
+    }
+
+    TINY_RENDERER_SAFE_FREE(p_descriptor_set->descriptors);
+    TINY_RENDERER_SAFE_FREE(p_descriptor_set);
+    p_renderer->bindless_descriptor_set = NULL;
+}
+
+uint32_t tr_internal_vk_register_bindless(tr_renderer* p_renderer, tr_bindless_table_type table_type, const VkDescriptorImageInfo* p_image_info, const VkDescriptorBufferInfo* p_buffer_info)
+{
+    if (NULL == p_renderer->bindless_descriptor_set) {
+        return 0;
+    }
+
+    const VkDescriptorType table_vk_descriptor_types[tr_bindless_table_type_count] = {
+        VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_SAMPLER
+    };
+    assert(table_type < tr_bindless_table_type_count);
+
+    // Reuse the most recently freed slot first
+    tr_bindless_table* p_table = &(p_renderer->bindless_tables[table_type]);
+    uint32_t index = 0;
+    if (p_table->free_count > 0) {
+        p_table->free_count -= 1;
+        index = p_table->free_indices[p_table->free_count];
+    }
+    else {
+        assert(p_table->high_water_index < p_table->capacity);
+        index = p_table->high_water_index;
+        p_table->high_water_index += 1;
     }
 
-    TINY_RENDERER_SAFE_FREE(bindings);
+    const tr_descriptor* descriptor = &(p_renderer->bindless_descriptor_set->descriptors[table_type]);
+    TINY_RENDERER_DECLARE_ZERO(VkWriteDescriptorSet, write);
+    write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext           = NULL;
+    write.dstSet          = p_renderer->bindless_descriptor_set->vk_descriptor_set;
+    write.dstBinding      = descriptor->binding;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType  = table_vk_descriptor_types[table_type];
+    write.pImageInfo      = p_image_info;
+    write.pBufferInfo     = p_buffer_info;
+    vkUpdateDescriptorSets(p_renderer->vk_device, 1, &write, 0, NULL);
+
+    return index;
 }
 
-void tr_internal_vk_destroy_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set)
+void tr_internal_vk_unregister_bindless(tr_renderer* p_renderer, tr_bindless_table_type table_type, uint32_t index)
 {
-    assert(VK_NULL_HANDLE != p_renderer->vk_device);
-    assert(VK_NULL_HANDLE != p_descriptor_set->vk_descriptor_set_layout);
-    assert(VK_NULL_HANDLE != p_descriptor_set->vk_descriptor_set);
-    assert(VK_NULL_HANDLE != p_descriptor_set->vk_descriptor_pool);
-
-    VkResult vk_res = vkFreeDescriptorSets(p_renderer->vk_device, p_descriptor_set->vk_descriptor_pool, 1, &(p_descriptor_set->vk_descriptor_set));
-    assert(VK_SUCCESS == vk_res);
+    if ((NULL == p_renderer->bindless_descriptor_set) || (0 == index)) {
+        return;
+    }
 
-    vkDestroyDescriptorSetLayout(p_renderer->vk_device, p_descriptor_set->vk_descriptor_set_layout, NULL);
-    vkDestroyDescriptorPool(p_renderer->vk_device, p_descriptor_set->vk_descriptor_pool, NULL);
+    // The stale descriptor stays in the slot, partially bound tables only
+    // require the slots a draw indexes to be valid
+    tr_bindless_table* p_table = &(p_renderer->bindless_tables[table_type]);
+    assert(index < p_table->high_water_index);
+    assert(p_table->free_count < p_table->capacity);
+    p_table->free_indices[p_table->free_count] = index;
+    p_table->free_count += 1;
 }
 
 void tr_internal_vk_create_cmd_pool(tr_renderer *p_renderer, tr_queue* p_queue, bool transient, tr_cmd_pool* p_cmd_pool)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
-    assert(p_renderer->graphics_queue->vk_queue_family_index == p_queue->vk_queue_family_index);
     assert((p_queue->vk_queue_family_index == p_renderer->graphics_queue->vk_queue_family_index) ||
            (p_queue->vk_queue_family_index == p_renderer->present_queue->vk_queue_family_index));
 
     TINY_RENDERER_DECLARE_ZERO(VkCommandPoolCreateInfo, create_info);
     create_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     create_info.pNext            = NULL;
-    create_info.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    create_info.flags            = p_cmd_pool->per_frame ? 0 : VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     create_info.queueFamilyIndex = p_queue->vk_queue_family_index;
     if (transient) {
         create_info.flags |= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
@@ -3732,6 +6218,16 @@ void tr_internal_vk_create_cmd_pool(tr_renderer *p_renderer, tr_queue* p_queue,
     assert(VK_SUCCESS == vk_res);
 }
 
+void tr_internal_vk_reset_cmd_pool(tr_cmd_pool* p_cmd_pool)
+{
+    assert(VK_NULL_HANDLE != p_cmd_pool->renderer->vk_device);
+    assert(VK_NULL_HANDLE != p_cmd_pool->vk_cmd_pool);
+
+    // Keeps the pool's memory for the next frame's recording
+    VkResult vk_res = vkResetCommandPool(p_cmd_pool->renderer->vk_device, p_cmd_pool->vk_cmd_pool, 0);
+    assert(VK_SUCCESS == vk_res);
+}
+
 void tr_internal_vk_destroy_cmd_pool(tr_renderer *p_renderer, tr_cmd_pool* p_cmd_pool)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
@@ -3768,6 +6264,12 @@ void tr_internal_vk_create_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
+    p_renderer->vk_last_resource_id += 1;
+    p_buffer->vk_resource_id = p_renderer->vk_last_resource_id;
+
+    // Buffers start out in the usage they were created for
+    p_buffer->current_usage = p_buffer->usage;
+
     // Align the buffer size to multiples of the dynamic uniform buffer minimum size
     if (p_buffer->usage & tr_buffer_usage_uniform_cbv) {
         // Make minimum size 256 bytes to match D3D12
@@ -3799,24 +6301,15 @@ void tr_internal_vk_create_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer)
         mem_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
     }
 
-    uint32_t memory_type_index = UINT32_MAX;
-    bool found_memmory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, mem_reqs.memoryTypeBits, mem_flags, &memory_type_index);
-    assert(found_memmory);
-
-    TINY_RENDERER_DECLARE_ZERO(VkMemoryAllocateInfo, alloc_info);
-    alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.pNext           = NULL;
-    alloc_info.allocationSize  = mem_reqs.size;
-    alloc_info.memoryTypeIndex = memory_type_index;
-    vk_res = vkAllocateMemory(p_renderer->vk_device, &alloc_info, NULL, &(p_buffer->vk_memory));
-    assert(VK_SUCCESS == vk_res);
+    tr_internal_vk_allocate_memory(p_renderer, &mem_reqs, mem_flags, true, &(p_buffer->vk_allocation));
+    p_buffer->vk_memory = p_buffer->vk_allocation.block->vk_memory;
 
-    vk_res = vkBindBufferMemory(p_renderer->vk_device, p_buffer->vk_buffer, p_buffer->vk_memory, 0);
+    vk_res = vkBindBufferMemory(p_renderer->vk_device, p_buffer->vk_buffer, p_buffer->vk_memory, p_buffer->vk_allocation.offset);
     assert(VK_SUCCESS == vk_res);
 
     if (p_buffer->host_visible) {
-        vk_res = vkMapMemory(p_renderer->vk_device, p_buffer->vk_memory, 0, VK_WHOLE_SIZE, 0, &(p_buffer->cpu_mapped_address));
-        assert(VK_SUCCESS == vk_res);
+        assert(NULL != p_buffer->vk_allocation.block->cpu_mapped_address);
+        p_buffer->cpu_mapped_address = (uint8_t*)p_buffer->vk_allocation.block->cpu_mapped_address + p_buffer->vk_allocation.offset;
     }
 
     switch (p_buffer->usage) {
@@ -3833,12 +6326,21 @@ void tr_internal_vk_create_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer)
         }
         break;
 
-        case tr_buffer_usage_uniform_cbv:
+        case tr_buffer_usage_uniform_cbv: {
+            // Dynamic uniform buffers expose one element, the bind offset picks which
+            p_buffer->vk_buffer_info.buffer = p_buffer->vk_buffer;
+            p_buffer->vk_buffer_info.offset = 0;
+            p_buffer->vk_buffer_info.range  = (p_buffer->struct_stride > 0) ? p_buffer->struct_stride : VK_WHOLE_SIZE;
+        }
+        break;
+
         case tr_buffer_usage_storage_srv:
         case tr_buffer_usage_storage_uav: {
             p_buffer->vk_buffer_info.buffer = p_buffer->vk_buffer;
             p_buffer->vk_buffer_info.offset = 0;
             p_buffer->vk_buffer_info.range  = VK_WHOLE_SIZE;
+
+            p_buffer->bindless_index = tr_internal_vk_register_bindless(p_renderer, tr_bindless_table_type_storage_buffer, NULL, &(p_buffer->vk_buffer_info));
         }
         break;
     }
@@ -3848,8 +6350,15 @@ void tr_internal_vk_destroy_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
     assert(VK_NULL_HANDLE != p_buffer->vk_buffer);
+
+    tr_internal_vk_unregister_bindless(p_renderer, tr_bindless_table_type_storage_buffer, p_buffer->bindless_index);
+    p_buffer->bindless_index = 0;
     
     vkDestroyBuffer(p_renderer->vk_device, p_buffer->vk_buffer, NULL);
+
+    tr_internal_vk_free_memory(p_renderer, &(p_buffer->vk_allocation));
+    p_buffer->vk_memory = VK_NULL_HANDLE;
+    p_buffer->cpu_mapped_address = NULL;
 }
 
 void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_texture)
@@ -3858,6 +6367,9 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
 
     p_texture->renderer = p_renderer;
 
+    p_renderer->vk_last_resource_id += 1;
+    p_texture->vk_resource_id = p_renderer->vk_last_resource_id;
+
     if (VK_NULL_HANDLE == p_texture->vk_image) {
         VkImageType image_type = VK_IMAGE_TYPE_2D;
         switch (p_texture->type) {
@@ -3922,24 +6434,16 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
             mem_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
         }
 
-        uint32_t memory_type_index = UINT32_MAX;
-        bool found_memory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, mem_reqs.memoryTypeBits, mem_flags, &memory_type_index);
-        assert(found_memory);
-
-        TINY_RENDERER_DECLARE_ZERO(VkMemoryAllocateInfo, alloc_info);
-        alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        alloc_info.pNext           = NULL;
-        alloc_info.allocationSize  = mem_reqs.size;
-        alloc_info.memoryTypeIndex = memory_type_index;
-        vk_res = vkAllocateMemory(p_renderer->vk_device, &alloc_info, NULL, &(p_texture->vk_memory));
-        assert(VK_SUCCESS == vk_res);
+        bool linear = (VK_IMAGE_TILING_LINEAR == create_info.tiling);
+        tr_internal_vk_allocate_memory(p_renderer, &mem_reqs, mem_flags, linear, &(p_texture->vk_allocation));
+        p_texture->vk_memory = p_texture->vk_allocation.block->vk_memory;
 
-        vk_res = vkBindImageMemory(p_renderer->vk_device, p_texture->vk_image, p_texture->vk_memory, 0);
+        vk_res = vkBindImageMemory(p_renderer->vk_device, p_texture->vk_image, p_texture->vk_memory, p_texture->vk_allocation.offset);
         assert(VK_SUCCESS == vk_res);
 
         if (p_texture->host_visible) {
-            vk_res = vkMapMemory(p_renderer->vk_device, p_texture->vk_memory, 0, VK_WHOLE_SIZE, 0, &(p_texture->cpu_mapped_address));
-            assert(VK_SUCCESS == vk_res);
+            assert(NULL != p_texture->vk_allocation.block->cpu_mapped_address);
+            p_texture->cpu_mapped_address = (uint8_t*)p_texture->vk_allocation.block->cpu_mapped_address + p_texture->vk_allocation.offset;
         }
 
         p_texture->owns_image = true;
@@ -3980,6 +6484,10 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
     p_texture->vk_texture_view.imageView = p_texture->vk_image_view;
     p_texture->vk_texture_view.imageLayout = (p_texture->usage & tr_texture_usage_storage_image) ? VK_IMAGE_LAYOUT_GENERAL
                                                                                                  : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    if (p_texture->usage & tr_texture_usage_sampled_image) {
+        p_texture->bindless_index = tr_internal_vk_register_bindless(p_renderer, tr_bindless_table_type_texture, &(p_texture->vk_texture_view), NULL);
+    }
 }
 
 void tr_internal_vk_destroy_texture(tr_renderer* p_renderer, tr_texture* p_texture)
@@ -3991,14 +6499,19 @@ void tr_internal_vk_destroy_texture(tr_renderer* p_renderer, tr_texture* p_textu
         assert(VK_NULL_HANDLE != p_texture->vk_memory);
     }
 
-    if (VK_NULL_HANDLE != p_texture->vk_memory) {
-        vkFreeMemory(p_renderer->vk_device, p_texture->vk_memory, NULL);
-    }
+    tr_internal_vk_unregister_bindless(p_renderer, tr_bindless_table_type_texture, p_texture->bindless_index);
+    p_texture->bindless_index = 0;
 
     if ((VK_NULL_HANDLE != p_texture->vk_image) && (p_texture->owns_image)) {
         vkDestroyImage(p_renderer->vk_device, p_texture->vk_image, NULL);
     }
 
+    if (NULL != p_texture->vk_allocation.block) {
+        tr_internal_vk_free_memory(p_renderer, &(p_texture->vk_allocation));
+        p_texture->vk_memory = VK_NULL_HANDLE;
+        p_texture->cpu_mapped_address = NULL;
+    }
+
     if (VK_NULL_HANDLE != p_texture->vk_image_view) {
         vkDestroyImageView(p_renderer->vk_device, p_texture->vk_image_view, NULL);
     }
@@ -4008,6 +6521,9 @@ void tr_internal_vk_create_sampler(tr_renderer* p_renderer, tr_sampler* p_sample
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
+    p_renderer->vk_last_resource_id += 1;
+    p_sampler->vk_resource_id = p_renderer->vk_last_resource_id;
+
     TINY_RENDERER_DECLARE_ZERO(VkSamplerCreateInfo, create_info);
     create_info.sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
     create_info.pNext                   = NULL;
@@ -4031,6 +6547,8 @@ void tr_internal_vk_create_sampler(tr_renderer* p_renderer, tr_sampler* p_sample
     assert(VK_SUCCESS == vk_res);
 
     p_sampler->vk_sampler_view.sampler = p_sampler->vk_sampler;
+
+    p_sampler->bindless_index = tr_internal_vk_register_bindless(p_renderer, tr_bindless_table_type_sampler, &(p_sampler->vk_sampler_view), NULL);
 }
 
 void tr_internal_vk_destroy_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler)
@@ -4038,6 +6556,9 @@ void tr_internal_vk_destroy_sampler(tr_renderer* p_renderer, tr_sampler* p_sampl
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
     assert(VK_NULL_HANDLE != p_sampler->vk_sampler);
 
+    tr_internal_vk_unregister_bindless(p_renderer, tr_bindless_table_type_sampler, p_sampler->bindless_index);
+    p_sampler->bindless_index = 0;
+
     vkDestroySampler(p_renderer->vk_device, p_sampler->vk_sampler, NULL);
 }
 
@@ -4045,6 +6566,9 @@ void tr_internal_vk_create_shader_program(tr_renderer* p_renderer, uint32_t vert
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
+    p_renderer->vk_last_resource_id += 1;
+    p_shader_program->vk_resource_id = p_renderer->vk_last_resource_id;
+
     for (uint32_t i = 0; i < tr_shader_stage_count; ++i) {
         tr_shader_stage stage_mask = (tr_shader_stage)(1 << i);
         if (stage_mask == (p_shader_program->shader_stages & stage_mask)) {
@@ -4119,28 +6643,105 @@ void tr_internal_vk_destroy_shader_program(tr_renderer* p_renderer, tr_shader_pr
     }
 }
 
-void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* p_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
+static void tr_internal_vk_record_pipeline_feedback(tr_renderer* p_renderer, const VkPipelineCreationFeedbackEXT* p_feedback)
+{
+    // Workers compile pipelines too once the pool exists
+    tr_pipeline_worker_pool* p_pool = p_renderer->pipeline_worker_pool;
+    if (NULL != p_pool) {
+        tr_internal_mutex_lock(&(p_pool->mutex));
+    }
+
+    p_renderer->vk_pipeline_create_count += 1;
+    if (0 != (p_feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT)) {
+        if (0 != (p_feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)) {
+            p_renderer->vk_pipeline_cache_hit_count += 1;
+        }
+        p_renderer->vk_pipeline_create_duration_ns += p_feedback->duration;
+    }
+
+    if (NULL != p_pool) {
+        tr_internal_mutex_unlock(&(p_pool->mutex));
+    }
+}
+
+static uint32_t tr_internal_vk_fill_push_constant_ranges(tr_renderer* p_renderer, const tr_pipeline_settings* p_pipeline_settings, VkPushConstantRange* p_ranges)
+{
+    assert(p_pipeline_settings->push_constant_range_count <= tr_max_push_constant_ranges);
+
+    for (uint32_t i = 0; i < p_pipeline_settings->push_constant_range_count; ++i) {
+        const tr_push_constant_range* p_range = &(p_pipeline_settings->push_constant_ranges[i]);
+        assert((0 == (p_range->offset % 4)) && (0 == (p_range->size % 4)) && (p_range->size > 0));
+        assert((p_range->offset + p_range->size) <= p_renderer->vk_active_gpu_properties.limits.maxPushConstantsSize);
+
+        p_ranges[i].stageFlags = tr_util_to_vk_shader_stages(p_range->shader_stages);
+        p_ranges[i].offset     = p_range->offset;
+        p_ranges[i].size       = p_range->size;
+    }
+    return p_pipeline_settings->push_constant_range_count;
+}
+
+void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
     assert((VK_NULL_HANDLE != p_shader_program->vk_vert) || (VK_NULL_HANDLE != p_shader_program->vk_tesc) || (VK_NULL_HANDLE != p_shader_program->vk_tese) || (VK_NULL_HANDLE != p_shader_program->vk_geom) || (VK_NULL_HANDLE != p_shader_program->vk_frag));
     assert(VK_NULL_HANDLE != p_render_target->vk_render_pass);
 
-    // Pipeline layout
+    tr_internal_vk_create_pipeline_layout(p_renderer, descriptor_set_count, pp_descriptor_sets, p_pipeline_settings, p_pipeline);
+    tr_internal_vk_compile_pipeline(p_renderer, p_shader_program, p_vertex_layout, p_render_target->vk_render_pass, p_render_target->sample_count, p_pipeline_settings, p_pipeline);
+}
+
+void tr_internal_vk_create_pipeline_layout(tr_renderer* p_renderer, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    // Pipeline layout, shared with other pipelines that have the same layout
     {
-        TINY_RENDERER_DECLARE_ZERO(VkPipelineLayoutCreateInfo, create_info);
-        create_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        create_info.pNext                  = NULL;
-        create_info.flags                  = 0;
-        create_info.setLayoutCount         = (NULL != p_descriptor_set) ? 1 : 0;
-        create_info.pSetLayouts            = (NULL != p_descriptor_set) ? &(p_descriptor_set->vk_descriptor_set_layout) : NULL;
-        create_info.pushConstantRangeCount = 0;
-        create_info.pPushConstantRanges    = NULL;
-        VkResult vk_res = vkCreatePipelineLayout(p_renderer->vk_device, &create_info, NULL, &(p_pipeline->vk_pipeline_layout));
-        assert(VK_SUCCESS == vk_res);
+        TINY_RENDERER_DECLARE_ZERO(VkPushConstantRange, push_constant_ranges[tr_max_push_constant_ranges]);
+        uint32_t push_constant_range_count = tr_internal_vk_fill_push_constant_ranges(p_renderer, p_pipeline_settings, push_constant_ranges);
+
+        p_pipeline->vk_pipeline_layout_entry = tr_internal_vk_acquire_pipeline_layout(p_renderer, descriptor_set_count, pp_descriptor_sets, push_constant_range_count, push_constant_ranges);
+        p_pipeline->vk_pipeline_layout = p_pipeline->vk_pipeline_layout_entry->vk_pipeline_layout;
     }
+}
+
+// Points p_info at the entries and data, returns NULL if there are no constants
+static const VkSpecializationInfo* tr_internal_vk_fill_specialization_info(const tr_pipeline_settings* p_pipeline_settings, VkSpecializationMapEntry* p_entries, uint32_t* p_data, VkSpecializationInfo* p_info)
+{
+    uint32_t count = p_pipeline_settings->specialization_constant_count;
+    assert(count <= tr_max_specialization_constants);
+    if (0 == count) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const tr_specialization_constant* constant = &(p_pipeline_settings->specialization_constants[i]);
+        p_entries[i].constantID = constant->constant_id;
+        p_entries[i].offset     = i * sizeof(uint32_t);
+        p_entries[i].size       = sizeof(uint32_t);
+        p_data[i]               = constant->uint_value;
+    }
+
+    p_info->mapEntryCount = count;
+    p_info->pMapEntries   = p_entries;
+    p_info->dataSize      = count * sizeof(uint32_t);
+    p_info->pData         = p_data;
+    return p_info;
+}
+
+// Only reads its arguments and the pipeline cache, so it's safe to call from pipeline workers
+void tr_internal_vk_compile_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, VkRenderPass vk_render_pass, tr_sample_count sample_count, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(VK_NULL_HANDLE != p_pipeline->vk_pipeline_layout);
+    assert(VK_NULL_HANDLE != vk_render_pass);
 
     // Pipeline
     {
+        TINY_RENDERER_DECLARE_ZERO(VkSpecializationMapEntry, specialization_entries[tr_max_specialization_constants]);
+        TINY_RENDERER_DECLARE_ZERO(uint32_t, specialization_data[tr_max_specialization_constants]);
+        TINY_RENDERER_DECLARE_ZERO(VkSpecializationInfo, specialization_info);
+        const VkSpecializationInfo* p_specialization_info = tr_internal_vk_fill_specialization_info(p_pipeline_settings, specialization_entries, specialization_data, &specialization_info);
+
         uint32_t stage_count = 0;
         TINY_RENDERER_DECLARE_ZERO(VkPipelineShaderStageCreateInfo, stages[5]);
         for (uint32_t i = 0; i < 5; ++i) {
@@ -4149,7 +6750,7 @@ void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program*
                 stages[stage_count].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
                 stages[stage_count].pNext = NULL;
                 stages[stage_count].flags = 0;
-                stages[stage_count].pSpecializationInfo = NULL;         
+                stages[stage_count].pSpecializationInfo = p_specialization_info;
                 switch(stage_mask) {
                     case tr_shader_stage_vert: {
                         stages[stage_count].pName  = p_shader_program->vert_entry_point;
@@ -4200,10 +6801,11 @@ void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program*
             if (binding_value != attrib->binding) {
                 binding_value = attrib->binding;
                 ++input_binding_count;
+                input_bindings[input_binding_count - 1].inputRate = (tr_vertex_input_rate_instance == attrib->input_rate) ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
             }
+            assert(input_bindings[input_binding_count - 1].inputRate == ((tr_vertex_input_rate_instance == attrib->input_rate) ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX));
 
             input_bindings[input_binding_count - 1].binding = binding_value;
-            input_bindings[input_binding_count - 1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
             input_bindings[input_binding_count - 1].stride += tr_util_format_stride(attrib->format);
             
             input_attributes[input_attribute_count].location = attrib->location;
@@ -4294,7 +6896,7 @@ void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program*
         ms.sType                                    = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
         ms.pNext                                    = NULL;
         ms.flags                                    = 0;
-        ms.rasterizationSamples                     = tr_util_to_vk_sample_count(p_render_target->sample_count);
+        ms.rasterizationSamples                     = tr_util_to_vk_sample_count(sample_count);
         ms.sampleShadingEnable                      = VK_FALSE;
         ms.minSampleShading                         = 0.0f;
         ms.pSampleMask                              = 0;
@@ -4382,36 +6984,44 @@ void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program*
         create_info.pColorBlendState                = &cb;
         create_info.pDynamicState                   = &dy;
         create_info.layout                          = p_pipeline->vk_pipeline_layout;
-        create_info.renderPass                      = p_render_target->vk_render_pass;
+        create_info.renderPass                      = vk_render_pass;
         create_info.subpass                         = 0;
         create_info.basePipelineHandle              = VK_NULL_HANDLE;
         create_info.basePipelineIndex               = -1;
-        VkResult vk_res = vkCreateGraphicsPipelines(p_renderer->vk_device, VK_NULL_HANDLE, 1, &create_info, NULL, &(p_pipeline->vk_pipeline));
+
+        // The extension's first revision requires one stage feedback per stage
+        TINY_RENDERER_DECLARE_ZERO(VkPipelineCreationFeedbackEXT, feedback);
+        TINY_RENDERER_DECLARE_ZERO(VkPipelineCreationFeedbackEXT, stage_feedbacks[5]);
+        TINY_RENDERER_DECLARE_ZERO(VkPipelineCreationFeedbackCreateInfoEXT, feedback_info);
+        if (p_renderer->vk_device_ext_VK_EXT_pipeline_creation_feedback) {
+            feedback_info.sType                                 = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+            feedback_info.pNext                                 = NULL;
+            feedback_info.pPipelineCreationFeedback             = &feedback;
+            feedback_info.pipelineStageCreationFeedbackCount    = stage_count;
+            feedback_info.pPipelineStageCreationFeedbacks       = stage_feedbacks;
+            create_info.pNext                                   = &feedback_info;
+        }
+
+        VkResult vk_res = vkCreateGraphicsPipelines(p_renderer->vk_device, p_renderer->vk_pipeline_cache, 1, &create_info, NULL, &(p_pipeline->vk_pipeline));
         assert(VK_SUCCESS == vk_res);
+
+        tr_internal_vk_record_pipeline_feedback(p_renderer, &feedback);
     }
 }
 
-void tr_internal_vk_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
+void tr_internal_vk_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline)
 {
     assert(p_renderer->vk_device != VK_NULL_HANDLE);
     assert(p_shader_program->vk_comp != VK_NULL_HANDLE);
 
-    // Pipeline layout
-    {
-        TINY_RENDERER_DECLARE_ZERO(VkPipelineLayoutCreateInfo, create_info);
-        create_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        create_info.pNext                  = NULL;
-        create_info.flags                  = 0;
-        create_info.setLayoutCount         = (NULL != p_descriptor_set) ? 1 : 0;
-        create_info.pSetLayouts            = (NULL != p_descriptor_set) ? &(p_descriptor_set->vk_descriptor_set_layout) : NULL;
-        create_info.pushConstantRangeCount = 0;
-        create_info.pPushConstantRanges    = NULL;
-        VkResult vk_res = vkCreatePipelineLayout(p_renderer->vk_device, &create_info, NULL, &(p_pipeline->vk_pipeline_layout));
-        assert(VK_SUCCESS == vk_res);
-    }
+    tr_internal_vk_create_pipeline_layout(p_renderer, descriptor_set_count, pp_descriptor_sets, p_pipeline_settings, p_pipeline);
 
     // Pipeline
     {
+      TINY_RENDERER_DECLARE_ZERO(VkSpecializationMapEntry, specialization_entries[tr_max_specialization_constants]);
+      TINY_RENDERER_DECLARE_ZERO(uint32_t, specialization_data[tr_max_specialization_constants]);
+      TINY_RENDERER_DECLARE_ZERO(VkSpecializationInfo, specialization_info);
+
       TINY_RENDERER_DECLARE_ZERO(VkPipelineShaderStageCreateInfo , stage);
       stage.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
       stage.pNext               = NULL;
@@ -4419,7 +7029,7 @@ void tr_internal_vk_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_p
       stage.stage               = VK_SHADER_STAGE_COMPUTE_BIT;
       stage.module              = p_shader_program->vk_comp;
       stage.pName               = p_shader_program->comp_entry_point;
-      stage.pSpecializationInfo = NULL;  
+      stage.pSpecializationInfo = tr_internal_vk_fill_specialization_info(p_pipeline_settings, specialization_entries, specialization_data, &specialization_info);
 
       TINY_RENDERER_DECLARE_ZERO(VkComputePipelineCreateInfo, create_info);
       create_info.sType               = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -4429,8 +7039,23 @@ void tr_internal_vk_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_p
       create_info.layout              = p_pipeline->vk_pipeline_layout;
       create_info.basePipelineHandle  = 0;
       create_info.basePipelineIndex   = 0;
-      VkResult vk_res = vkCreateComputePipelines(p_renderer->vk_device, VK_NULL_HANDLE, 1, &create_info, NULL, &(p_pipeline->vk_pipeline));
+
+      TINY_RENDERER_DECLARE_ZERO(VkPipelineCreationFeedbackEXT, feedback);
+      TINY_RENDERER_DECLARE_ZERO(VkPipelineCreationFeedbackEXT, stage_feedback);
+      TINY_RENDERER_DECLARE_ZERO(VkPipelineCreationFeedbackCreateInfoEXT, feedback_info);
+      if (p_renderer->vk_device_ext_VK_EXT_pipeline_creation_feedback) {
+          feedback_info.sType                              = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+          feedback_info.pNext                              = NULL;
+          feedback_info.pPipelineCreationFeedback          = &feedback;
+          feedback_info.pipelineStageCreationFeedbackCount = 1;
+          feedback_info.pPipelineStageCreationFeedbacks    = &stage_feedback;
+          create_info.pNext                                = &feedback_info;
+      }
+
+      VkResult vk_res = vkCreateComputePipelines(p_renderer->vk_device, p_renderer->vk_pipeline_cache, 1, &create_info, NULL, &(p_pipeline->vk_pipeline));
       assert(VK_SUCCESS == vk_res);
+
+      tr_internal_vk_record_pipeline_feedback(p_renderer, &feedback);
     }
 }
 
@@ -4441,7 +7066,180 @@ void tr_internal_vk_destroy_pipeline(tr_renderer* p_renderer, tr_pipeline* p_pip
     assert(VK_NULL_HANDLE != p_pipeline->vk_pipeline_layout);
 
     vkDestroyPipeline(p_renderer->vk_device, p_pipeline->vk_pipeline, NULL);
-    vkDestroyPipelineLayout(p_renderer->vk_device, p_pipeline->vk_pipeline_layout, NULL);
+    tr_internal_vk_release_pipeline_layout(p_renderer, p_pipeline->vk_pipeline_layout_entry);
+    p_pipeline->vk_pipeline_layout_entry = NULL;
+    p_pipeline->vk_pipeline_layout = VK_NULL_HANDLE;
+}
+
+void tr_internal_vk_make_pipeline_key(tr_renderer* p_renderer, tr_pipeline_type type, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline_key* p_key, uint64_t* p_hash)
+{
+    assert(NULL != p_shader_program);
+    assert(descriptor_set_count <= tr_max_descriptor_sets);
+
+    // Padding has to be zero for the byte compare
+    memset(p_key, 0, sizeof(*p_key));
+
+    p_key->type              = (uint32_t)type;
+    p_key->shader_program_id = p_shader_program->vk_resource_id;
+
+    // Set layouts are shared between identical sets, so the handles identify
+    // the structure. Cached layouts stay alive while a pipeline uses them.
+    p_key->descriptor_set_count = descriptor_set_count;
+    for (uint32_t i = 0; i < descriptor_set_count; ++i) {
+        assert(NULL != pp_descriptor_sets[i]);
+        p_key->set_layouts[i] = pp_descriptor_sets[i]->vk_descriptor_set_layout;
+    }
+
+    uint32_t push_constant_range_count = p_pipeline_settings->push_constant_range_count;
+    assert(push_constant_range_count <= tr_max_push_constant_ranges);
+    p_key->push_constant_range_count = push_constant_range_count;
+    for (uint32_t i = 0; i < push_constant_range_count; ++i) {
+        const tr_push_constant_range* range = &(p_pipeline_settings->push_constant_ranges[i]);
+        p_key->push_constant_ranges[i][0] = (uint32_t)range->shader_stages;
+        p_key->push_constant_ranges[i][1] = range->offset;
+        p_key->push_constant_ranges[i][2] = range->size;
+    }
+
+    uint32_t specialization_constant_count = p_pipeline_settings->specialization_constant_count;
+    assert(specialization_constant_count <= tr_max_specialization_constants);
+    p_key->specialization_constant_count = specialization_constant_count;
+    for (uint32_t i = 0; i < specialization_constant_count; ++i) {
+        const tr_specialization_constant* constant = &(p_pipeline_settings->specialization_constants[i]);
+        p_key->specialization_constants[i][0] = constant->constant_id;
+        p_key->specialization_constants[i][1] = constant->uint_value;
+    }
+
+    if (tr_pipeline_type_graphics == type) {
+        assert(NULL != p_vertex_layout);
+        assert(NULL != p_render_target);
+
+        // Same fields and clamp as the vertex input state
+        uint32_t attrib_count = p_vertex_layout->attrib_count > tr_max_vertex_attribs ? tr_max_vertex_attribs : p_vertex_layout->attrib_count;
+        p_key->vertex_attrib_count = attrib_count;
+        for (uint32_t i = 0; i < attrib_count; ++i) {
+            const tr_vertex_attrib* attrib = &(p_vertex_layout->attribs[i]);
+            p_key->vertex_attribs[i][0] = (uint32_t)attrib->format;
+            p_key->vertex_attribs[i][1] = attrib->binding;
+            p_key->vertex_attribs[i][2] = attrib->location;
+            p_key->vertex_attribs[i][3] = attrib->offset;
+            p_key->vertex_attribs[i][4] = (uint32_t)attrib->input_rate;
+        }
+
+        p_key->color_format               = (uint32_t)p_render_target->color_format;
+        p_key->color_attachment_count     = p_render_target->color_attachment_count;
+        p_key->depth_stencil_format       = (uint32_t)p_render_target->depth_stencil_format;
+        p_key->sample_count               = (uint32_t)p_render_target->sample_count;
+        p_key->primitive_topo             = (uint32_t)p_pipeline_settings->primitive_topo;
+        p_key->cull_mode                  = (uint32_t)p_pipeline_settings->cull_mode;
+        p_key->front_face                 = (uint32_t)p_pipeline_settings->front_face;
+        p_key->depth                      = p_pipeline_settings->depth ? 1 : 0;
+        p_key->tessellation_domain_origin = (uint32_t)p_pipeline_settings->tessellation_domain_origin;
+    }
+
+    *p_hash = tr_internal_hash(tr_internal_hash_seed, p_key, sizeof(*p_key));
+}
+
+tr_pipeline* tr_internal_vk_find_pipeline(tr_renderer* p_renderer, const tr_pipeline_key* p_key, uint64_t hash)
+{
+    for (tr_pipeline* p_pipeline = p_renderer->vk_pipelines; NULL != p_pipeline; p_pipeline = p_pipeline->next) {
+        if ((p_pipeline->vk_pipeline_key_hash == hash) && (0 == memcmp(&(p_pipeline->vk_pipeline_key), p_key, sizeof(*p_key)))) {
+            return p_pipeline;
+        }
+    }
+    return NULL;
+}
+
+static TINY_RENDERER_THREAD_FN tr_internal_pipeline_worker(void* p_arg)
+{
+    tr_pipeline_worker_pool* p_pool = (tr_pipeline_worker_pool*)p_arg;
+    tr_renderer* p_renderer = p_pool->renderer;
+
+    tr_internal_mutex_lock(&(p_pool->mutex));
+    for (;;) {
+        while ((NULL == p_pool->job_head) && (! p_pool->shutdown)) {
+            tr_internal_cond_wait(&(p_pool->job_cond), &(p_pool->mutex));
+        }
+        // Queued jobs are drained before shutting down
+        tr_pipeline_job* p_job = p_pool->job_head;
+        if (NULL == p_job) {
+            break;
+        }
+        p_pool->job_head = p_job->next;
+        if (NULL == p_pool->job_head) {
+            p_pool->job_tail = NULL;
+        }
+        tr_internal_mutex_unlock(&(p_pool->mutex));
+
+        tr_pipeline* p_pipeline = p_job->pipeline;
+        tr_internal_vk_compile_pipeline(p_renderer, p_job->shader_program, &(p_job->vertex_layout), p_job->vk_render_pass, p_job->sample_count, &(p_pipeline->settings), p_pipeline);
+        TINY_RENDERER_SAFE_FREE(p_job);
+
+        tr_internal_mutex_lock(&(p_pool->mutex));
+        tr_internal_atomic_store(&(p_pipeline->ready), 1);
+        tr_internal_cond_broadcast(&(p_pool->done_cond));
+    }
+    tr_internal_mutex_unlock(&(p_pool->mutex));
+
+    return TINY_RENDERER_THREAD_RETURN;
+}
+
+void tr_internal_create_pipeline_worker_pool(tr_renderer* p_renderer)
+{
+    assert(NULL == p_renderer->pipeline_worker_pool);
+
+    tr_pipeline_worker_pool* p_pool = (tr_pipeline_worker_pool*)calloc(1, sizeof(*p_pool));
+    assert(NULL != p_pool);
+
+    p_pool->renderer     = p_renderer;
+    p_pool->thread_count = (p_renderer->settings.pipeline_worker_count > 0) ? p_renderer->settings.pipeline_worker_count : 1;
+    p_pool->threads      = (tr_internal_thread*)calloc(p_pool->thread_count, sizeof(*(p_pool->threads)));
+    assert(NULL != p_pool->threads);
+
+    tr_internal_mutex_init(&(p_pool->mutex));
+    tr_internal_cond_init(&(p_pool->job_cond));
+    tr_internal_cond_init(&(p_pool->done_cond));
+
+    // Publish the pool before the threads start, feedback recording locks it
+    p_renderer->pipeline_worker_pool = p_pool;
+
+    for (uint32_t i = 0; i < p_pool->thread_count; ++i) {
+#if defined(TINY_RENDERER_MSW)
+        p_pool->threads[i] = CreateThread(NULL, 0, tr_internal_pipeline_worker, p_pool, 0, NULL);
+        assert(NULL != p_pool->threads[i]);
+#else
+        int res = pthread_create(&(p_pool->threads[i]), NULL, tr_internal_pipeline_worker, p_pool);
+        assert(0 == res);
+#endif
+    }
+}
+
+void tr_internal_destroy_pipeline_worker_pool(tr_renderer* p_renderer)
+{
+    tr_pipeline_worker_pool* p_pool = p_renderer->pipeline_worker_pool;
+    assert(NULL != p_pool);
+
+    tr_internal_mutex_lock(&(p_pool->mutex));
+    p_pool->shutdown = true;
+    tr_internal_cond_broadcast(&(p_pool->job_cond));
+    tr_internal_mutex_unlock(&(p_pool->mutex));
+
+    for (uint32_t i = 0; i < p_pool->thread_count; ++i) {
+#if defined(TINY_RENDERER_MSW)
+        WaitForSingleObject(p_pool->threads[i], INFINITE);
+        CloseHandle(p_pool->threads[i]);
+#else
+        pthread_join(p_pool->threads[i], NULL);
+#endif
+    }
+
+    // Async pipelines stay async, but they're all ready now
+    p_renderer->pipeline_worker_pool = NULL;
+
+    tr_internal_cond_destroy(&(p_pool->done_cond));
+    tr_internal_cond_destroy(&(p_pool->job_cond));
+    tr_internal_mutex_destroy(&(p_pool->mutex));
+    TINY_RENDERER_SAFE_FREE(p_pool->threads);
+    TINY_RENDERER_SAFE_FREE(p_pool);
 }
 
 void tr_internal_vk_create_render_pass(tr_renderer* p_renderer, bool is_swapchain, tr_render_target* p_render_target)
@@ -4710,222 +7508,174 @@ void tr_internal_vk_update_descriptor_set(tr_renderer* p_renderer, tr_descriptor
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
     assert(VK_NULL_HANDLE != p_descriptor_set->vk_descriptor_set);
 
-    // Not really efficient, just write less frequently ;)
+    // Only elements whose resource changed since the last update are written,
+    // runs of changed elements in a descriptor share a write. NULL entries
+    // are skipped and keep whatever was written before.
     uint32_t write_count = 0;
-    uint32_t sampler_view_count = 0;
-    uint32_t image_view_count = 0;
-    uint32_t buffer_view_count = 0;
-    for (uint32_t descriptor_index = 0; descriptor_index < p_descriptor_set->descriptor_count; ++descriptor_index) {
-        tr_descriptor* descriptor = &(p_descriptor_set->descriptors[descriptor_index]);
-        switch (descriptor->type) {
-            case tr_descriptor_type_sampler: {
-                sampler_view_count += descriptor->count;
-                ++write_count;
-            }
-            break;
-
-            case tr_descriptor_type_uniform_buffer_cbv:
-            case tr_descriptor_type_storage_buffer_srv:
-            case tr_descriptor_type_storage_buffer_uav:
-            case tr_descriptor_type_uniform_texel_buffer_srv:
-            case tr_descriptor_type_storage_texel_buffer_uav: {
-                buffer_view_count += descriptor->count;
-                ++write_count;
-            }
-            break;
-
-            case tr_descriptor_type_texture_srv:
-            case tr_descriptor_type_texture_uav: {
-                image_view_count += descriptor->count;
-                ++write_count;
-            }
-            break;
-        }
-    }
-    // Bail if there's nothing to write
-    if (0 == write_count) {
-        return;
-    }
-
-    VkWriteDescriptorSet* writes = (VkWriteDescriptorSet*)calloc(write_count, sizeof(*writes));
-    assert(NULL != writes);
-    VkDescriptorImageInfo* sampler_views = (VkDescriptorImageInfo*)calloc(sampler_view_count, sizeof(*sampler_views));
-    assert(NULL != sampler_views);
-    VkDescriptorImageInfo* image_views = (VkDescriptorImageInfo*)calloc(image_view_count, sizeof(*image_views));
-    assert(NULL != image_views);
-    VkDescriptorBufferInfo* buffer_views = (VkDescriptorBufferInfo*)calloc(buffer_view_count, sizeof(*buffer_views));
-    assert(NULL != buffer_views);
-
-    uint32_t write_index = 0;
-    uint32_t sampler_view_index = 0;
-    uint32_t texture_view_index = 0;
-    uint32_t buffer_view_index = 0;
     for (uint32_t descriptor_index = 0; descriptor_index < p_descriptor_set->descriptor_count; ++descriptor_index) {
         tr_descriptor* descriptor = &(p_descriptor_set->descriptors[descriptor_index]);
-        if ((NULL == descriptor->samplers) && (NULL == descriptor->textures) && (NULL == descriptor->uniform_buffers)) {
+        VkDescriptorType descriptor_type = tr_util_to_vk_descriptor_type(descriptor->type);
+        if (VK_DESCRIPTOR_TYPE_MAX_ENUM == descriptor_type) {
             continue;
         }
 
-        writes[write_index].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writes[write_index].pNext           = NULL;
-        writes[write_index].dstSet          = p_descriptor_set->vk_descriptor_set;
-        writes[write_index].dstBinding      = descriptor->binding;
-        writes[write_index].dstArrayElement = 0;
-        writes[write_index].descriptorCount = descriptor->count;
-        switch (descriptor->type) {
-            case tr_descriptor_type_sampler: {
-                assert(NULL != descriptor->samplers);
-
-                writes[write_index].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-                writes[write_index].pImageInfo = &(sampler_views[sampler_view_index]);
-                for (uint32_t i = 0; i < descriptor->count; ++i) {
-                    memcpy(&(sampler_views[sampler_view_index]), 
-                           &(descriptor->samplers[i]->vk_sampler_view),
-                           sizeof(descriptor->samplers[i]->vk_sampler_view));
-                    ++sampler_view_index;
-                }
-            }
-            break;
-
-            case tr_descriptor_type_uniform_buffer_cbv: {
-                assert(NULL != descriptor->uniform_buffers);
+        VkWriteDescriptorSet* p_write = NULL;
+        for (uint32_t i = 0; i < descriptor->count; ++i) {
+            uint32_t element = descriptor->vk_element_offset + i;
+            assert(element < p_descriptor_set->vk_element_count);
 
-                writes[write_index].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                writes[write_index].pBufferInfo = &(buffer_views[buffer_view_index]);
-                for (uint32_t i = 0; i < descriptor->count; ++i) {
-                    memcpy(&(buffer_views[buffer_view_index]), 
-                           &(descriptor->uniform_buffers[i]->vk_buffer_info),
-                           sizeof(descriptor->uniform_buffers[i]->vk_buffer_info));
-                    ++buffer_view_index;
+            uint64_t resource_id = 0;
+            switch (descriptor->type) {
+                case tr_descriptor_type_sampler: {
+                    const tr_sampler* p_sampler = descriptor->samplers[i];
+                    if (NULL != p_sampler) {
+                        resource_id = p_sampler->vk_resource_id;
+                        p_descriptor_set->vk_image_infos[element] = p_sampler->vk_sampler_view;
+                    }
                 }
-            }
-            break;
-
-            case tr_descriptor_type_storage_buffer_srv: {
-                assert(NULL != descriptor->buffers);
+                break;
 
-                writes[write_index].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-                writes[write_index].pBufferInfo = &(buffer_views[buffer_view_index]);
-                for (uint32_t i = 0; i < descriptor->count; ++i) {
-                    memcpy(&(buffer_views[buffer_view_index]), 
-                           &(descriptor->buffers[i]->vk_buffer_info),
-                           sizeof(descriptor->buffers[i]->vk_buffer_info));
-                    ++buffer_view_index;
+                case tr_descriptor_type_texture_srv:
+                case tr_descriptor_type_texture_uav: {
+                    const tr_texture* p_texture = descriptor->textures[i];
+                    if (NULL != p_texture) {
+                        resource_id = p_texture->vk_resource_id;
+                        p_descriptor_set->vk_image_infos[element] = p_texture->vk_texture_view;
+                    }
                 }
-            }
-            break;
-
-            case tr_descriptor_type_storage_buffer_uav: {
-                assert(NULL != descriptor->buffers);
+                break;
 
-                writes[write_index].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-                writes[write_index].pBufferInfo = &(buffer_views[buffer_view_index]);
-                for (uint32_t i = 0; i < descriptor->count; ++i) {
-                    memcpy(&(buffer_views[buffer_view_index]), 
-                           &(descriptor->buffers[i]->vk_buffer_info),
-                           sizeof(descriptor->buffers[i]->vk_buffer_info));
-                    ++buffer_view_index;
+                case tr_descriptor_type_uniform_buffer_cbv:
+                case tr_descriptor_type_uniform_buffer_dynamic: {
+                    const tr_buffer* p_buffer = descriptor->uniform_buffers[i];
+                    if (NULL != p_buffer) {
+                        assert((tr_descriptor_type_uniform_buffer_dynamic != descriptor->type) || (p_buffer->struct_stride > 0));
+                        resource_id = p_buffer->vk_resource_id;
+                        p_descriptor_set->vk_buffer_infos[element] = p_buffer->vk_buffer_info;
+                    }
                 }
-            }
-            break;
-
-            case tr_descriptor_type_uniform_texel_buffer_srv: {
-                assert(NULL != descriptor->buffers);
+                break;
 
-                writes[write_index].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
-                writes[write_index].pBufferInfo = &(buffer_views[buffer_view_index]);
-                for (uint32_t i = 0; i < descriptor->count; ++i) {
-                    memcpy(&(buffer_views[buffer_view_index]), 
-                           &(descriptor->buffers[i]->vk_buffer_info),
-                           sizeof(descriptor->buffers[i]->vk_buffer_info));
-                    ++buffer_view_index;
+                case tr_descriptor_type_storage_buffer_srv:
+                case tr_descriptor_type_storage_buffer_uav: {
+                    const tr_buffer* p_buffer = descriptor->buffers[i];
+                    if (NULL != p_buffer) {
+                        resource_id = p_buffer->vk_resource_id;
+                        p_descriptor_set->vk_buffer_infos[element] = p_buffer->vk_buffer_info;
+                    }
                 }
-            }
-            break;
-
-            case tr_descriptor_type_storage_texel_buffer_uav: {
-                assert(NULL != descriptor->buffers);
+                break;
 
-                writes[write_index].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
-                writes[write_index].pBufferInfo = &(buffer_views[buffer_view_index]);
-                for (uint32_t i = 0; i < descriptor->count; ++i) {
-                    memcpy(&(buffer_views[buffer_view_index]), 
-                           &(descriptor->buffers[i]->vk_buffer_info),
-                           sizeof(descriptor->buffers[i]->vk_buffer_info));
-                    ++buffer_view_index;
+                case tr_descriptor_type_uniform_texel_buffer_srv:
+                case tr_descriptor_type_storage_texel_buffer_uav: {
+                    const tr_buffer* p_buffer = descriptor->buffers[i];
+                    if (NULL != p_buffer) {
+                        assert(VK_NULL_HANDLE != p_buffer->vk_buffer_view);
+                        resource_id = p_buffer->vk_resource_id;
+                        p_descriptor_set->vk_texel_buffer_views[element] = p_buffer->vk_buffer_view;
+                    }
                 }
+                break;
             }
-            break;
 
-            case tr_descriptor_type_texture_srv: {
-                assert(NULL != descriptor->textures);
-
-                writes[write_index].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-                writes[write_index].pImageInfo = &(image_views[texture_view_index]);
-                for (uint32_t i = 0; i < descriptor->count; ++i) {
-                    memcpy(&(image_views[texture_view_index]), 
-                           &(descriptor->textures[i]->vk_texture_view),
-                           sizeof(descriptor->textures[i]->vk_texture_view));
-                    ++texture_view_index;
-                }
+            if ((0 == resource_id) || (resource_id == p_descriptor_set->vk_written_resource_ids[element])) {
+                p_write = NULL;
+                continue;
             }
-            break;
+            p_descriptor_set->vk_written_resource_ids[element] = resource_id;
 
-            case tr_descriptor_type_texture_uav: {
-                assert(NULL != descriptor->textures);
+            if (NULL == p_write) {
+                p_write = &(p_descriptor_set->vk_writes[write_count]);
+                ++write_count;
 
-                writes[write_index].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-                writes[write_index].pImageInfo = &(image_views[texture_view_index]);
-                for (uint32_t i = 0; i < descriptor->count; ++i) {
-                    memcpy(&(image_views[texture_view_index]), 
-                           &(descriptor->textures[i]->vk_texture_view),
-                           sizeof(descriptor->textures[i]->vk_texture_view));
-                    ++texture_view_index;
-                }
+                // Vulkan only reads the info pointer that matches the type
+                p_write->sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                p_write->pNext            = NULL;
+                p_write->dstSet           = p_descriptor_set->vk_descriptor_set;
+                p_write->dstBinding       = descriptor->binding;
+                p_write->dstArrayElement  = i;
+                p_write->descriptorCount  = 0;
+                p_write->descriptorType   = descriptor_type;
+                p_write->pImageInfo       = &(p_descriptor_set->vk_image_infos[element]);
+                p_write->pBufferInfo      = &(p_descriptor_set->vk_buffer_infos[element]);
+                p_write->pTexelBufferView = &(p_descriptor_set->vk_texel_buffer_views[element]);
             }
-            break;
-
+            p_write->descriptorCount += 1;
         }
-
-        ++write_index;
     }
 
-    uint32_t copy_count = 0;
-    VkCopyDescriptorSet* copies = NULL;
-
-    vkUpdateDescriptorSets(p_renderer->vk_device, write_count, writes, copy_count, copies);
-
-    TINY_RENDERER_SAFE_FREE(sampler_views);
-    TINY_RENDERER_SAFE_FREE(image_views);
-    TINY_RENDERER_SAFE_FREE(buffer_views);
-    TINY_RENDERER_SAFE_FREE(writes);
+    if (write_count > 0) {
+        vkUpdateDescriptorSets(p_renderer->vk_device, write_count, p_descriptor_set->vk_writes, 0, NULL);
+    }
 }
 
 // -------------------------------------------------------------------------------------------------
 // Internal command buffer functions
 // -------------------------------------------------------------------------------------------------
-void tr_internal_vk_begin_cmd(tr_cmd* p_cmd)
+void tr_internal_vk_begin_cmd(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_cmd_usage_flags usage)
 {
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+    assert((NULL == p_render_target) || p_cmd->secondary);
+
+    // Secondary command buffers always need inheritance info, it only names
+    // a render pass when they continue one.
+    TINY_RENDERER_DECLARE_ZERO(VkCommandBufferInheritanceInfo, inheritance_info);
+    inheritance_info.sType                = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.pNext                = NULL;
+    inheritance_info.renderPass           = VK_NULL_HANDLE;
+    inheritance_info.subpass              = 0;
+    inheritance_info.framebuffer          = VK_NULL_HANDLE;
+    inheritance_info.occlusionQueryEnable = VK_FALSE;
+    if (NULL != p_render_target) {
+        assert(VK_NULL_HANDLE != p_render_target->vk_render_pass);
+        assert(VK_NULL_HANDLE != p_render_target->vk_framebuffer);
+        inheritance_info.renderPass  = p_render_target->vk_render_pass;
+        inheritance_info.framebuffer = p_render_target->vk_framebuffer;
+    }
 
     TINY_RENDERER_DECLARE_ZERO(VkCommandBufferBeginInfo, begin_info);
     begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;;
     begin_info.pNext            = NULL;
-    begin_info.flags            = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-    begin_info.pInheritanceInfo = NULL;
+    begin_info.flags            = 0;
+    begin_info.pInheritanceInfo = p_cmd->secondary ? &inheritance_info : NULL;
+    if (usage & tr_cmd_usage_one_time_submit) {
+        begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    }
+    if (usage & tr_cmd_usage_simultaneous_use) {
+        begin_info.flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    }
+    if (NULL != p_render_target) {
+        begin_info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    }
     VkResult vk_res = vkBeginCommandBuffer(p_cmd->vk_cmd_buf, &begin_info);
     assert(VK_SUCCESS == vk_res);
+
+    // Nothing is bound in a freshly begun command buffer
+    memset(&(p_cmd->state), 0, sizeof(p_cmd->state));
+    p_cmd->skip_draws = false;
+    p_cmd->state_emitted_count  = 0;
+    p_cmd->state_filtered_count = 0;
+
+    p_cmd->bound_render_target          = NULL;
+    p_cmd->pending_buffer_barrier_count = 0;
+    p_cmd->pending_image_barrier_count  = 0;
+    p_cmd->vk_pending_src_stage_mask    = 0;
+    p_cmd->vk_pending_dst_stage_mask    = 0;
+    p_cmd->transition_count             = 0;
+    p_cmd->barrier_count                = 0;
 }
 
 void tr_internal_vk_end_cmd(tr_cmd* p_cmd)
 {
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
 
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+
     VkResult vk_res = vkEndCommandBuffer(p_cmd->vk_cmd_buf);
     assert(VK_SUCCESS == vk_res);
 }
 
-void tr_internal_vk_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_target)
+void tr_internal_vk_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_target, VkSubpassContents vk_contents)
 {
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
     assert(VK_NULL_HANDLE != p_render_target->vk_render_pass);
@@ -4974,7 +7724,11 @@ void tr_internal_vk_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_t
     begin_info.clearValueCount = clear_value_count;
     begin_info.pClearValues    = clear_values;
 
-    vkCmdBeginRenderPass(p_cmd->vk_cmd_buf, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+
+    vkCmdBeginRenderPass(p_cmd->vk_cmd_buf, &begin_info, vk_contents);
+
+    p_cmd->bound_render_target = p_render_target;
 }
 
 void tr_internal_vk_cmd_end_render(tr_cmd* p_cmd)
@@ -4982,6 +7736,48 @@ void tr_internal_vk_cmd_end_render(tr_cmd* p_cmd)
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
 
     vkCmdEndRenderPass(p_cmd->vk_cmd_buf);
+
+    // Attachments are left in the render pass's final layouts
+    tr_render_target* p_render_target = p_cmd->bound_render_target;
+    if (NULL != p_render_target) {
+        for (uint32_t i = 0; i < p_render_target->color_attachment_count; ++i) {
+            tr_texture* p_attachment = p_render_target->color_attachments[i];
+            p_attachment->current_usage = (p_attachment->usage & tr_texture_usage_present) ? tr_texture_usage_present : tr_texture_usage_color_attachment;
+            if (p_render_target->sample_count > tr_sample_count_1) {
+                p_render_target->color_attachments_multisample[i]->current_usage = tr_texture_usage_color_attachment;
+            }
+        }
+        if (NULL != p_render_target->depth_stencil_attachment) {
+            p_render_target->depth_stencil_attachment->current_usage = tr_texture_usage_depth_stencil_attachment;
+        }
+        if (NULL != p_render_target->depth_stencil_attachment_multisample) {
+            p_render_target->depth_stencil_attachment_multisample->current_usage = tr_texture_usage_depth_stencil_attachment;
+        }
+    }
+    p_cmd->bound_render_target = NULL;
+}
+
+void tr_internal_vk_cmd_execute(tr_cmd* p_cmd, uint32_t cmd_count, tr_cmd** pp_cmds)
+{
+    assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+
+    VkCommandBuffer* vk_cmd_bufs = (VkCommandBuffer*)calloc(cmd_count, sizeof(*vk_cmd_bufs));
+    assert(NULL != vk_cmd_bufs);
+
+    for (uint32_t i = 0; i < cmd_count; ++i) {
+        assert(NULL != pp_cmds[i]);
+        assert(pp_cmds[i]->secondary);
+        assert(VK_NULL_HANDLE != pp_cmds[i]->vk_cmd_buf);
+        vk_cmd_bufs[i] = pp_cmds[i]->vk_cmd_buf;
+    }
+
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+    vkCmdExecuteCommands(p_cmd->vk_cmd_buf, cmd_count, vk_cmd_bufs);
+
+    TINY_RENDERER_SAFE_FREE(vk_cmd_bufs);
+
+    // State doesn't carry over from secondary command buffers
+    memset(&(p_cmd->state), 0, sizeof(p_cmd->state));
 }
 
 void tr_internal_vk_cmd_set_viewport(tr_cmd* p_cmd, float x, float y, float width, float height, float min_depth, float max_depth)
@@ -5007,6 +7803,16 @@ void tr_internal_vk_cmd_set_viewport(tr_cmd* p_cmd, float x, float y, float widt
       viewport.minDepth = min_depth;
       viewport.maxDepth = max_depth;
     }
+
+    tr_cmd_state* p_state = &(p_cmd->state);
+    if (p_state->viewport_valid && (0 == memcmp(&(p_state->vk_viewport), &viewport, sizeof(viewport)))) {
+        p_cmd->state_filtered_count += 1;
+        return;
+    }
+    p_state->viewport_valid = true;
+    p_state->vk_viewport    = viewport;
+    p_cmd->state_emitted_count += 1;
+
     vkCmdSetViewport(p_cmd->vk_cmd_buf, 0, 1, &viewport);
 }
 
@@ -5019,6 +7825,16 @@ void tr_internal_vk_cmd_set_scissor(tr_cmd* p_cmd, uint32_t x, uint32_t y, uint3
     rect.offset.x = y;
     rect.extent.width = width;
     rect.extent.height = height;
+
+    tr_cmd_state* p_state = &(p_cmd->state);
+    if (p_state->scissor_valid && (0 == memcmp(&(p_state->vk_scissor), &rect, sizeof(rect)))) {
+        p_cmd->state_filtered_count += 1;
+        return;
+    }
+    p_state->scissor_valid = true;
+    p_state->vk_scissor    = rect;
+    p_cmd->state_emitted_count += 1;
+
     vkCmdSetScissor(p_cmd->vk_cmd_buf, 0, 1, &rect);
 }
 
@@ -5085,6 +7901,15 @@ void tr_internal_vk_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline)
         = (p_pipeline->type == tr_pipeline_type_compute) ? VK_PIPELINE_BIND_POINT_COMPUTE
                                                          : VK_PIPELINE_BIND_POINT_GRAPHICS;
 
+    uint32_t bind_point_index = (p_pipeline->type == tr_pipeline_type_compute) ? 1 : 0;
+    tr_cmd_state* p_state = &(p_cmd->state);
+    if (p_state->vk_pipelines[bind_point_index] == p_pipeline->vk_pipeline) {
+        p_cmd->state_filtered_count += 1;
+        return;
+    }
+    p_state->vk_pipelines[bind_point_index] = p_pipeline->vk_pipeline;
+    p_cmd->state_emitted_count += 1;
+
     vkCmdBindPipeline(p_cmd->vk_cmd_buf, pipeline_bind_point, p_pipeline->vk_pipeline);
 
     //switch (p_pipeline->type) {
@@ -5098,23 +7923,79 @@ void tr_internal_vk_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline)
     //}
 }
 
-void tr_internal_vk_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, tr_descriptor_set* p_descriptor_set)
+void tr_internal_vk_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t first_set, uint32_t descriptor_set_count, tr_descriptor_set** pp_descriptor_sets, uint32_t dynamic_offset_count, const uint32_t* p_dynamic_offsets)
 {
     assert(p_cmd != NULL);
     assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
     assert(p_pipeline != NULL);
     assert(p_pipeline->vk_pipeline_layout != VK_NULL_HANDLE);
-    assert(p_descriptor_set != NULL);
-    assert(p_descriptor_set->vk_descriptor_set != VK_NULL_HANDLE);
+    assert(descriptor_set_count <= tr_max_descriptor_sets);
+
+    TINY_RENDERER_DECLARE_ZERO(VkDescriptorSet, vk_descriptor_sets[tr_max_descriptor_sets]);
+    for (uint32_t i = 0; i < descriptor_set_count; ++i) {
+        assert(pp_descriptor_sets[i] != NULL);
+        assert(pp_descriptor_sets[i]->vk_descriptor_set != VK_NULL_HANDLE);
+        vk_descriptor_sets[i] = pp_descriptor_sets[i]->vk_descriptor_set;
+    }
 
     VkPipelineBindPoint pipeline_bind_point 
         = (p_pipeline->type == tr_pipeline_type_compute) ? VK_PIPELINE_BIND_POINT_COMPUTE
                                                          : VK_PIPELINE_BIND_POINT_GRAPHICS;
 
-    // @TODO: Add dynamic offsets support
+    // Redundant if every set in the range is already bound with the same
+    // layout. Dynamic offsets aren't tracked, binds with them are always
+    // recorded.
+    uint32_t bind_point_index = (p_pipeline->type == tr_pipeline_type_compute) ? 1 : 0;
+    VkDescriptorSet* p_bound_sets = p_cmd->state.vk_descriptor_sets[bind_point_index];
+    VkPipelineLayout* p_bound_layouts = p_cmd->state.vk_descriptor_set_layouts[bind_point_index];
+    if (0 == dynamic_offset_count) {
+        bool redundant = true;
+        for (uint32_t i = 0; redundant && (i < descriptor_set_count); ++i) {
+            redundant = (p_bound_layouts[first_set + i] == p_pipeline->vk_pipeline_layout) && (p_bound_sets[first_set + i] == vk_descriptor_sets[i]);
+        }
+        if (redundant) {
+            p_cmd->state_filtered_count += 1;
+            return;
+        }
+    }
+    // Sets bound with another layout may be disturbed, forget them
+    for (uint32_t i = 0; i < tr_max_descriptor_sets; ++i) {
+        if ((i >= first_set) && (i < (first_set + descriptor_set_count))) {
+            p_bound_sets[i]    = (0 == dynamic_offset_count) ? vk_descriptor_sets[i - first_set] : VK_NULL_HANDLE;
+            p_bound_layouts[i] = p_pipeline->vk_pipeline_layout;
+        }
+        else if (p_bound_layouts[i] != p_pipeline->vk_pipeline_layout) {
+            p_bound_sets[i]    = VK_NULL_HANDLE;
+            p_bound_layouts[i] = VK_NULL_HANDLE;
+        }
+    }
+    p_cmd->state_emitted_count += 1;
+
+    // Sets outside [first_set, first_set + count) stay bound as long as the
+    // layouts agree up to that set. Dynamic offsets are consumed set by set,
+    // in binding order within each set.
     vkCmdBindDescriptorSets(p_cmd->vk_cmd_buf, pipeline_bind_point, 
-                            p_pipeline->vk_pipeline_layout, 0, 
-                            1, &(p_descriptor_set->vk_descriptor_set), 0, NULL);
+                            p_pipeline->vk_pipeline_layout, first_set, 
+                            descriptor_set_count, vk_descriptor_sets, 
+                            dynamic_offset_count, p_dynamic_offsets);
+}
+
+void tr_internal_vk_cmd_push_constants(tr_cmd* p_cmd, tr_pipeline* p_pipeline, uint32_t offset, uint32_t size, const void* p_values)
+{
+    assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+    assert(VK_NULL_HANDLE != p_pipeline->vk_pipeline_layout);
+
+    // Vulkan wants the stages of every range the update overlaps
+    VkShaderStageFlags stage_flags = 0;
+    for (uint32_t i = 0; i < p_pipeline->settings.push_constant_range_count; ++i) {
+        const tr_push_constant_range* p_range = &(p_pipeline->settings.push_constant_ranges[i]);
+        if ((offset < (p_range->offset + p_range->size)) && (p_range->offset < (offset + size))) {
+            stage_flags |= tr_util_to_vk_shader_stages(p_range->shader_stages);
+        }
+    }
+    assert(0 != stage_flags);
+
+    vkCmdPushConstants(p_cmd->vk_cmd_buf, p_pipeline->vk_pipeline_layout, stage_flags, offset, size, p_values);
 }
 
 void tr_internal_vk_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer)
@@ -5122,6 +8003,16 @@ void tr_internal_vk_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer)
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
 
     VkIndexType vk_index_type = (tr_index_type_uint16 == p_buffer->index_type) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+    tr_cmd_state* p_state = &(p_cmd->state);
+    if ((p_state->vk_index_buffer == p_buffer->vk_buffer) && (p_state->vk_index_type == vk_index_type)) {
+        p_cmd->state_filtered_count += 1;
+        return;
+    }
+    p_state->vk_index_buffer = p_buffer->vk_buffer;
+    p_state->vk_index_type   = vk_index_type;
+    p_cmd->state_emitted_count += 1;
+
     vkCmdBindIndexBuffer(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, 0, vk_index_type);
 }
 
@@ -5142,417 +8033,428 @@ void tr_internal_vk_cmd_bind_vertex_buffers(tr_cmd* p_cmd, uint32_t buffer_count
         buffers[i] = pp_buffers[i]->vk_buffer;
     }
 
+    // Only tr_max_vertex_bindings buffers are tracked, larger binds are always recorded
+    tr_cmd_state* p_state = &(p_cmd->state);
+    if ((capped_buffer_count <= tr_max_vertex_bindings) && (p_state->vertex_buffer_count == capped_buffer_count) && (0 == memcmp(p_state->vk_vertex_buffers, buffers, capped_buffer_count * sizeof(*buffers)))) {
+        p_cmd->state_filtered_count += 1;
+        return;
+    }
+    if (capped_buffer_count <= tr_max_vertex_bindings) {
+        p_state->vertex_buffer_count = capped_buffer_count;
+        memcpy(p_state->vk_vertex_buffers, buffers, capped_buffer_count * sizeof(*buffers));
+    }
+    else {
+        p_state->vertex_buffer_count = 0;
+    }
+    p_cmd->state_emitted_count += 1;
+
     vkCmdBindVertexBuffers(p_cmd->vk_cmd_buf, 0, capped_buffer_count, buffers, offsets);
 }
 
-void tr_internal_vk_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex)
+void tr_internal_vk_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance)
 {
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
 
-    vkCmdDraw(p_cmd->vk_cmd_buf, vertex_count, 1, first_vertex, 0);
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+    vkCmdDraw(p_cmd->vk_cmd_buf, vertex_count, instance_count, first_vertex, first_instance);
 }
 
-void tr_internal_vk_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index)
+void tr_internal_vk_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index, int32_t vertex_offset, uint32_t instance_count, uint32_t first_instance)
 {
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
 
-    vkCmdDrawIndexed(p_cmd->vk_cmd_buf, index_count, 1, first_index, 0, 0);
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+    vkCmdDrawIndexed(p_cmd->vk_cmd_buf, index_count, instance_count, first_index, vertex_offset, first_instance);
 }
 
-void tr_internal_vk_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
+// Tessellation stages are only valid in barriers when the feature is enabled
+static VkPipelineStageFlags tr_internal_vk_all_shader_stages(tr_renderer* p_renderer)
 {
-    assert(p_cmd != NULL);
-    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
-
-    VkPipelineStageFlags src_stage_mask = 0;
-    VkPipelineStageFlags dst_stage_mask = 0;
-    VkDependencyFlags dependency_flags = 0;
-    TINY_RENDERER_DECLARE_ZERO(VkBufferMemoryBarrier , barrier);
-    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-    barrier.pNext               = NULL;
-    barrier.srcQueueFamilyIndex = 0;
-    barrier.dstQueueFamilyIndex = 0;
-    barrier.buffer              = p_buffer->vk_buffer;
-    barrier.offset              = 0;
-    barrier.size                = VK_WHOLE_SIZE;
-
-    const VkPipelineStageFlags all_shader_stages =
+    VkPipelineStageFlags result =
         VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
-        VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
-        VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT |
         VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT |
         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    if (p_renderer->vk_active_gpu_features.tessellationShader) {
+        result |= VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+                  VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT;
+    }
+    return result;
+}
 
-    switch (old_usage) {
-        case tr_buffer_usage_index: {
-            src_stage_mask = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-            barrier.srcAccessMask = VK_ACCESS_INDEX_READ_BIT;
-        }
-        break;
+static const VkAccessFlags tr_internal_vk_write_access_mask =
+    VK_ACCESS_SHADER_WRITE_BIT |
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT |
+    VK_ACCESS_HOST_WRITE_BIT |
+    VK_ACCESS_MEMORY_WRITE_BIT;
 
-        case tr_buffer_usage_vertex: {
-            src_stage_mask = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-            barrier.srcAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
-        }
-        break;
+// Buffers can be in several read usages at once, so every bit of usage
+// adds its stages and accesses.
+static void tr_internal_vk_buffer_usage_access(tr_buffer_usage usage, VkPipelineStageFlags all_shader_stages, VkPipelineStageFlags* p_stage_mask, VkAccessFlags* p_access_mask)
+{
+    VkPipelineStageFlags stage_mask = 0;
+    VkAccessFlags access_mask = 0;
 
-        case tr_buffer_usage_indirect: {
-            src_stage_mask = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
-            barrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
-        }
-        break;
+    if (usage & tr_buffer_usage_index) {
+        stage_mask  |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        access_mask |= VK_ACCESS_INDEX_READ_BIT;
+    }
+    if (usage & tr_buffer_usage_vertex) {
+        stage_mask  |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        access_mask |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    }
+    if (usage & tr_buffer_usage_indirect) {
+        stage_mask  |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        access_mask |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    }
+    if (usage & tr_buffer_usage_transfer_src) {
+        stage_mask  |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        access_mask |= VK_ACCESS_TRANSFER_READ_BIT;
+    }
+    if (usage & tr_buffer_usage_transfer_dst) {
+        stage_mask  |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        access_mask |= VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+    if (usage & tr_buffer_usage_uniform_cbv) {
+        stage_mask  |= all_shader_stages;
+        access_mask |= VK_ACCESS_UNIFORM_READ_BIT;
+    }
+    if (usage & (tr_buffer_usage_storage_srv | tr_buffer_usage_uniform_texel_srv)) {
+        stage_mask  |= all_shader_stages;
+        access_mask |= VK_ACCESS_SHADER_READ_BIT;
+    }
+    if (usage & (tr_buffer_usage_storage_uav | tr_buffer_usage_storage_texel_uav)) {
+        stage_mask  |= all_shader_stages;
+        access_mask |= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    }
 
-        case tr_buffer_usage_transfer_src: {
-            src_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        }
-        break;
+    *p_stage_mask  = stage_mask;
+    *p_access_mask = access_mask;
+}
 
-        case tr_buffer_usage_transfer_dst: {
-            src_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        }
-        break;
+static void tr_internal_vk_texture_usage_access(const tr_texture* p_texture, tr_texture_usage usage, VkPipelineStageFlags all_shader_stages, VkPipelineStageFlags* p_stage_mask, VkAccessFlags* p_access_mask, VkImageLayout* p_layout)
+{
+    VkPipelineStageFlags stage_mask = 0;
+    VkAccessFlags access_mask = 0;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL;
 
-        case tr_buffer_usage_uniform_cbv: {
-            src_stage_mask = all_shader_stages;
-            barrier.srcAccessMask = VK_ACCESS_UNIFORM_READ_BIT;
+    switch (usage) {
+        case tr_texture_usage_undefined: {
+            layout = VK_IMAGE_LAYOUT_UNDEFINED;
         }
         break;
 
-        case tr_buffer_usage_storage_srv: {
-            src_stage_mask = all_shader_stages;
-            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        case tr_texture_usage_transfer_src: {
+            stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+            layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
         }
         break;
 
-        case tr_buffer_usage_storage_uav: {
-            src_stage_mask = all_shader_stages;
-            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-        }
-        break;
-        case tr_buffer_usage_uniform_texel_srv: {
-            src_stage_mask = all_shader_stages;
-            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        case tr_texture_usage_transfer_dst: {
+            stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         }
         break;
 
-        case tr_buffer_usage_storage_texel_uav: {
-            src_stage_mask = all_shader_stages;
-            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        case tr_texture_usage_sampled_image: {
+            stage_mask  = all_shader_stages;
+            access_mask = VK_ACCESS_SHADER_READ_BIT;
+            layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         }
         break;
-    }
 
-    switch (new_usage) {
-        case tr_buffer_usage_index: {
-            dst_stage_mask = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-            barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT;
+        case tr_texture_usage_storage_image: {
+            stage_mask  = all_shader_stages;
+            access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            layout      = VK_IMAGE_LAYOUT_GENERAL;
         }
         break;
 
-        case tr_buffer_usage_vertex: {
-            dst_stage_mask = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        case tr_texture_usage_color_attachment: {
+            stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         }
         break;
 
-        case tr_buffer_usage_indirect: {
-            dst_stage_mask = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
-            barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        case tr_texture_usage_depth_stencil_attachment: {
+            stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
         }
         break;
 
-        case tr_buffer_usage_transfer_src: {
-            dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        case tr_texture_usage_resolve_src: {
+            stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+            layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         }
         break;
 
-        case tr_buffer_usage_transfer_dst: {
-            dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        case tr_texture_usage_resolve_dst: {
+            stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         }
         break;
 
-        case tr_buffer_usage_uniform_cbv: {
-            dst_stage_mask = all_shader_stages;
-            barrier.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT;
+        // Presentation is ordered by semaphores, not by the barrier
+        case tr_texture_usage_present: {
+            layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
         }
         break;
+    }
 
-        case tr_buffer_usage_storage_srv: {
-            dst_stage_mask = all_shader_stages;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        }
-        break;
+    // Descriptors of storage capable textures always use the general layout
+    if ((p_texture->usage & tr_texture_usage_storage_image) && (tr_texture_usage_sampled_image == usage)) {
+        layout = VK_IMAGE_LAYOUT_GENERAL;
+    }
 
-        case tr_buffer_usage_storage_uav: {
-            dst_stage_mask = all_shader_stages;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-        }
-        break;
-        case tr_buffer_usage_uniform_texel_srv: {
-            dst_stage_mask = all_shader_stages;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        }
-        break;
+    *p_stage_mask  = stage_mask;
+    *p_access_mask = access_mask;
+    *p_layout      = layout;
+}
 
-        case tr_buffer_usage_storage_texel_uav: {
-            dst_stage_mask = all_shader_stages;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-        }
-        break;
+void tr_internal_vk_cmd_flush_barriers(tr_cmd* p_cmd)
+{
+    assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+
+    if ((0 == p_cmd->pending_buffer_barrier_count) && (0 == p_cmd->pending_image_barrier_count)) {
+        return;
     }
 
+    // Nothing before the first queued usage means top of pipe, nothing
+    // after the last one means bottom of pipe.
+    VkPipelineStageFlags src_stage_mask = (0 != p_cmd->vk_pending_src_stage_mask) ? p_cmd->vk_pending_src_stage_mask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    VkPipelineStageFlags dst_stage_mask = (0 != p_cmd->vk_pending_dst_stage_mask) ? p_cmd->vk_pending_dst_stage_mask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
     vkCmdPipelineBarrier(p_cmd->vk_cmd_buf,
                          src_stage_mask,
                          dst_stage_mask,
-                         dependency_flags,
                          0,
-                         NULL,
-                         1,
-                         &barrier,
                          0,
-                         NULL);
+                         NULL,
+                         p_cmd->pending_buffer_barrier_count,
+                         p_cmd->vk_pending_buffer_barriers,
+                         p_cmd->pending_image_barrier_count,
+                         p_cmd->vk_pending_image_barriers);
+
+    p_cmd->pending_buffer_barrier_count = 0;
+    p_cmd->pending_image_barrier_count  = 0;
+    p_cmd->vk_pending_src_stage_mask    = 0;
+    p_cmd->vk_pending_dst_stage_mask    = 0;
+    p_cmd->barrier_count += 1;
 }
 
-void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
+void tr_internal_vk_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
 {
-    assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
-    assert(VK_NULL_HANDLE != p_texture->vk_image);
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+    assert(VK_NULL_HANDLE != p_buffer->vk_buffer);
+    // Pipeline barriers inside a render pass need a subpass self dependency
+    assert(NULL == p_cmd->bound_render_target);
 
+    p_buffer->current_usage = new_usage;
+
+    VkPipelineStageFlags all_shader_stages = tr_internal_vk_all_shader_stages(p_cmd->cmd_pool->renderer);
     VkPipelineStageFlags src_stage_mask = 0;
     VkPipelineStageFlags dst_stage_mask = 0;
-    VkDependencyFlags dependency_flags = 0;
-    TINY_RENDERER_DECLARE_ZERO(VkImageMemoryBarrier, barrier);
-
-    barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.pNext                           = NULL;
-    barrier.oldLayout                       = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.newLayout                       = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image                           = p_texture->vk_image;
-    barrier.subresourceRange.aspectMask     = p_texture->vk_aspect_mask;
-    barrier.subresourceRange.baseMipLevel   = 0;
-    barrier.subresourceRange.levelCount     = p_texture->mip_levels;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount     = 1;
-
-    const VkPipelineStageFlags all_shader_stages =
-        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
-        VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
-        VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT |
-        VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT |
-        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    VkAccessFlags src_access_mask = 0;
+    VkAccessFlags dst_access_mask = 0;
+    tr_internal_vk_buffer_usage_access(old_usage, all_shader_stages, &src_stage_mask, &src_access_mask);
+    tr_internal_vk_buffer_usage_access(new_usage, all_shader_stages, &dst_stage_mask, &dst_access_mask);
+
+    // Only writes need to be made available, reads just need to finish
+    src_access_mask &= tr_internal_vk_write_access_mask;
+
+    // A buffer that stays in the same read only usage has nothing to wait on,
+    // everything else needs at least an execution dependency. Usages without
+    // stages wait on top of pipe when the batch is flushed.
+    if ((old_usage == new_usage) && (0 == src_access_mask)) {
+        return;
+    }
 
-    // source stage/access/layout
-    switch (old_usage)
-    {
-        case tr_texture_usage_undefined: {
-            src_stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-            barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        }
-        break;
+    // A buffer can only be in a batch once, and the batch has a fixed size
+    bool pending = false;
+    for (uint32_t i = 0; i < p_cmd->pending_buffer_barrier_count; ++i) {
+        pending |= (p_cmd->pending_buffers[i] == p_buffer);
+    }
+    if (pending || (p_cmd->pending_buffer_barrier_count >= tr_max_pending_barriers)) {
+        tr_internal_vk_cmd_flush_barriers(p_cmd);
+    }
 
-        case tr_texture_usage_transfer_src: {
-            src_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        }
-        break;
+    VkBufferMemoryBarrier* p_barrier = &(p_cmd->vk_pending_buffer_barriers[p_cmd->pending_buffer_barrier_count]);
+    memset(p_barrier, 0, sizeof(*p_barrier));
+    p_barrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    p_barrier->pNext               = NULL;
+    p_barrier->srcAccessMask       = src_access_mask;
+    p_barrier->dstAccessMask       = dst_access_mask;
+    p_barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    p_barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    p_barrier->buffer              = p_buffer->vk_buffer;
+    p_barrier->offset              = 0;
+    p_barrier->size                = VK_WHOLE_SIZE;
+    p_cmd->pending_buffers[p_cmd->pending_buffer_barrier_count] = p_buffer;
+    p_cmd->pending_buffer_barrier_count += 1;
 
-        case tr_texture_usage_transfer_dst: {
-            src_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        }
-        break;
+    p_cmd->vk_pending_src_stage_mask |= src_stage_mask;
+    p_cmd->vk_pending_dst_stage_mask |= dst_stage_mask;
+    p_cmd->transition_count += 1;
+}
 
-        case tr_texture_usage_sampled_image: {
-            src_stage_mask = all_shader_stages;
-            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        }
-        break;
+void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
+{
+    assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+    assert(VK_NULL_HANDLE != p_texture->vk_image);
+    // Pipeline barriers inside a render pass need a subpass self dependency
+    assert(NULL == p_cmd->bound_render_target);
 
-        case tr_texture_usage_storage_image: {
-            src_stage_mask = all_shader_stages;
-            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-        }
-        break;
+    p_texture->current_usage = new_usage;
 
-        case tr_texture_usage_color_attachment: {
-            src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        }
-        break;
+    VkPipelineStageFlags all_shader_stages = tr_internal_vk_all_shader_stages(p_cmd->cmd_pool->renderer);
+    VkPipelineStageFlags src_stage_mask = 0;
+    VkPipelineStageFlags dst_stage_mask = 0;
+    VkAccessFlags src_access_mask = 0;
+    VkAccessFlags dst_access_mask = 0;
+    VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    tr_internal_vk_texture_usage_access(p_texture, old_usage, all_shader_stages, &src_stage_mask, &src_access_mask, &old_layout);
+    tr_internal_vk_texture_usage_access(p_texture, new_usage, all_shader_stages, &dst_stage_mask, &dst_access_mask, &new_layout);
+
+    // Only writes need to be made available, reads just need to finish
+    src_access_mask &= tr_internal_vk_write_access_mask;
+
+    // Same layout and no writes to wait on
+    if ((old_usage == new_usage) && (old_layout == new_layout) && (0 == src_access_mask)) {
+        return;
+    }
 
-        case tr_texture_usage_depth_stencil_attachment: {
-            src_stage_mask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-            barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        }
-        break;
+    // An image can only be in a batch once, and the batch has a fixed size
+    bool pending = false;
+    for (uint32_t i = 0; i < p_cmd->pending_image_barrier_count; ++i) {
+        pending |= (p_cmd->pending_textures[i] == p_texture);
+    }
+    if (pending || (p_cmd->pending_image_barrier_count >= tr_max_pending_barriers)) {
+        tr_internal_vk_cmd_flush_barriers(p_cmd);
+    }
 
-        case tr_texture_usage_resolve_src: {
-            src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        }
-        break;
+    VkImageMemoryBarrier* p_barrier = &(p_cmd->vk_pending_image_barriers[p_cmd->pending_image_barrier_count]);
+    memset(p_barrier, 0, sizeof(*p_barrier));
+    p_barrier->sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    p_barrier->pNext                           = NULL;
+    p_barrier->srcAccessMask                   = src_access_mask;
+    p_barrier->dstAccessMask                   = dst_access_mask;
+    p_barrier->oldLayout                       = old_layout;
+    p_barrier->newLayout                       = new_layout;
+    p_barrier->srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    p_barrier->dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    p_barrier->image                           = p_texture->vk_image;
+    p_barrier->subresourceRange.aspectMask     = p_texture->vk_aspect_mask;
+    p_barrier->subresourceRange.baseMipLevel   = 0;
+    p_barrier->subresourceRange.levelCount     = p_texture->mip_levels;
+    p_barrier->subresourceRange.baseArrayLayer = 0;
+    p_barrier->subresourceRange.layerCount     = 1;
+    p_cmd->pending_textures[p_cmd->pending_image_barrier_count] = p_texture;
+    p_cmd->pending_image_barrier_count += 1;
 
-        case tr_texture_usage_resolve_dst: {
-            src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        }
-        break;
+    p_cmd->vk_pending_src_stage_mask |= src_stage_mask;
+    p_cmd->vk_pending_dst_stage_mask |= dst_stage_mask;
+    p_cmd->transition_count += 1;
+}
 
-        case tr_texture_usage_present: {
-            src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            barrier.srcAccessMask = 0;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-        }
-        break;
+void tr_internal_vk_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage)
+{
+    assert(NULL != p_cmd->vk_cmd_buf);
+
+    // Only swapchains move between present and color attachment. The single sample 
+    // attachment is the one presented, even for multisample swapchains.
+    if (1 != p_render_target->color_attachment_count) {
+        return;
     }
 
-    // destination stage/access/layout
-    switch (new_usage)
-    {
-        case tr_texture_usage_undefined: {
-            dst_stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        }
-        break;
+    tr_texture* attachment = p_render_target->color_attachments[0];
+    if (tr_texture_usage_present != (attachment->usage & tr_texture_usage_present)) {
+        return;
+    }
 
-       case tr_texture_usage_transfer_src: {
-            dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        }
-        break;
+    if ((tr_texture_usage_present != new_usage) && (tr_texture_usage_color_attachment != new_usage)) {
+        return;
+    }
 
-        case tr_texture_usage_transfer_dst: {
-            dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        }
-        break;
+    // Ending a render pass already leaves the attachment in present
+    if (attachment->current_usage == new_usage) {
+        return;
+    }
 
-        case tr_texture_usage_sampled_image: {
-            dst_stage_mask = all_shader_stages;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        }
-        break;
+    tr_internal_vk_cmd_image_transition(p_cmd, attachment, attachment->current_usage, new_usage);
+}
 
-        case tr_texture_usage_storage_image: {
-            dst_stage_mask = all_shader_stages;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-        }
-        break;
+void tr_internal_vk_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
 
-        case tr_texture_usage_color_attachment: {
-            dst_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        }
-        break;
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+    vkCmdDispatch(p_cmd->vk_cmd_buf, group_count_x, group_count_y, group_count_z);
+}
 
-        case tr_texture_usage_depth_stencil_attachment: {
-            dst_stage_mask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-            barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        }
-        break;
+void tr_internal_vk_cmd_draw_indirect(tr_cmd* p_cmd, bool indexed, tr_buffer* p_buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
+{
+    assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+    assert(VK_NULL_HANDLE != p_buffer->vk_buffer);
+    assert(tr_buffer_usage_indirect == (p_buffer->usage & tr_buffer_usage_indirect));
+    assert(0 == (offset % 4));
 
-        case tr_texture_usage_resolve_src: {
-            dst_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        }
-        break;
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
 
-        case tr_texture_usage_resolve_dst: {
-            dst_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    // Without multiDrawIndirect each draw is recorded on its own
+    const VkPhysicalDeviceFeatures* p_features = &(p_cmd->cmd_pool->renderer->vk_active_gpu_features);
+    uint32_t batch_count = p_features->multiDrawIndirect ? draw_count : 1;
+    for (uint32_t i = 0; i < draw_count; i += batch_count) {
+        VkDeviceSize batch_offset = (VkDeviceSize)(offset + (uint64_t)i * stride);
+        if (indexed) {
+            vkCmdDrawIndexedIndirect(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, batch_offset, batch_count, stride);
         }
-        break;
-
-        case tr_texture_usage_present: {
-            dst_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            barrier.dstAccessMask = 0;
-            barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        else {
+            vkCmdDrawIndirect(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, batch_offset, batch_count, stride);
         }
-        break;
-     }
-
-    vkCmdPipelineBarrier(p_cmd->vk_cmd_buf,
-                         src_stage_mask,
-                         dst_stage_mask,
-                         dependency_flags,
-                         0,
-                         NULL,
-                         0,
-                         NULL,
-                         1,
-                         &barrier);
+    }
 }
 
-void tr_internal_vk_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage)
+void tr_internal_vk_cmd_draw_indirect_count(tr_cmd* p_cmd, bool indexed, tr_buffer* p_buffer, uint64_t offset, tr_buffer* p_count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride)
 {
-    assert(NULL != p_cmd->vk_cmd_buf);
-    
-    if (p_render_target->sample_count > tr_sample_count_1) {
-        if (1 == p_render_target->color_attachment_count) {
-            tr_texture* ss_attachment = p_render_target->color_attachments[0];
-            tr_texture* ms_attachment = p_render_target->color_attachments_multisample[0];
-
-            // This means we're dealing with a multisample swapchain
-            if (tr_texture_usage_present == (ss_attachment->usage & tr_texture_usage_present)) {
-                if ((tr_texture_usage_present == old_usage) && (tr_texture_usage_color_attachment == new_usage)) {
-                    tr_internal_vk_cmd_image_transition(p_cmd, ss_attachment, tr_texture_usage_present, tr_texture_usage_color_attachment);
-                }
+    assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+    assert(VK_NULL_HANDLE != p_buffer->vk_buffer);
+    assert(VK_NULL_HANDLE != p_count_buffer->vk_buffer);
+    assert(tr_buffer_usage_indirect == (p_buffer->usage & tr_buffer_usage_indirect));
+    assert(tr_buffer_usage_indirect == (p_count_buffer->usage & tr_buffer_usage_indirect));
+    assert(0 == (offset % 4));
+    assert(0 == (count_offset % 4));
+    assert(p_cmd->cmd_pool->renderer->vk_device_ext_VK_KHR_draw_indirect_count);
 
-                if ((tr_texture_usage_color_attachment == old_usage) && (tr_texture_usage_present == new_usage)) {
-                    tr_internal_vk_cmd_image_transition(p_cmd, ss_attachment, tr_texture_usage_color_attachment, tr_texture_usage_present);
-                }
-            }
-        }
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+
+    if (indexed) {
+        trVkCmdDrawIndexedIndirectCountKHR(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, offset, p_count_buffer->vk_buffer, count_offset, max_draw_count, stride);
     }
     else {
-        if (1 == p_render_target->color_attachment_count) {
-            tr_texture* attachment = p_render_target->color_attachments[0];
-            // This means we're dealing with a single sample swapchain
-            if (tr_texture_usage_present == (attachment->usage & tr_texture_usage_present)) {
-                if ((tr_texture_usage_present == old_usage) && (tr_texture_usage_color_attachment == new_usage)) {
-                    tr_internal_vk_cmd_image_transition(p_cmd, attachment, tr_texture_usage_present, tr_texture_usage_color_attachment);
-                }
-
-                if ((tr_texture_usage_color_attachment == old_usage) && (tr_texture_usage_present == new_usage)) {
-                    tr_internal_vk_cmd_image_transition(p_cmd, attachment, tr_texture_usage_color_attachment, tr_texture_usage_present);
-                }
-            }
-        }
+        trVkCmdDrawIndirectCountKHR(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, offset, p_count_buffer->vk_buffer, count_offset, max_draw_count, stride);
     }
 }
 
-void tr_internal_vk_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+void tr_internal_vk_cmd_dispatch_indirect(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t offset)
 {
-    assert(p_cmd != NULL);
-    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+    assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+    assert(VK_NULL_HANDLE != p_buffer->vk_buffer);
+    assert(tr_buffer_usage_indirect == (p_buffer->usage & tr_buffer_usage_indirect));
+    assert(0 == (offset % 4));
 
-    vkCmdDispatch(p_cmd->vk_cmd_buf, group_count_x, group_count_y, group_count_z);
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
+    vkCmdDispatchIndirect(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, offset);
 }
 
 void tr_internal_vk_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t height, uint32_t row_pitch, uint64_t buffer_offset, uint32_t mip_level, tr_buffer* p_buffer, tr_texture* p_texture)
@@ -5575,6 +8477,7 @@ void tr_internal_vk_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width,
     regions.imageExtent.height              = height;
     regions.imageExtent.depth               = 1;
 
+    tr_internal_vk_cmd_flush_barriers(p_cmd);
     vkCmdCopyBufferToImage(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, p_texture->vk_image,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &regions);
 }
@@ -5585,24 +8488,37 @@ void tr_internal_vk_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width,
 void tr_internal_vk_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
-    assert(VK_NULL_HANDLE != p_renderer->vk_swapchain);
 
     VkSemaphore semaphore = (NULL != p_signal_semaphore) ? p_signal_semaphore->vk_semaphore : VK_NULL_HANDLE;
     VkFence fence = (NULL != p_fence) ? p_fence->vk_fence : VK_NULL_HANDLE;
 
-    VkResult vk_res = vkAcquireNextImageKHR(p_renderer->vk_device, 
-                                            p_renderer->vk_swapchain, 
-                                            UINT64_MAX, 
-                                            semaphore, 
-                                            fence, 
-                                            &(p_renderer->swapchain_image_index));
-    assert(VK_SUCCESS == vk_res);
+    VkResult vk_res = VK_SUCCESS;
+    if (p_renderer->settings.headless) {
+        // Offscreen images are used round robin, an empty submit signals
+        // the semaphore and fence the way vkAcquireNextImageKHR would.
+        p_renderer->swapchain_image_index = (p_renderer->swapchain_image_index + 1) % p_renderer->settings.swapchain.image_count;
+        tr_internal_vk_queue_submit(p_renderer->graphics_queue, 0, NULL, 0, NULL, (NULL != p_signal_semaphore) ? 1 : 0, &p_signal_semaphore, p_fence);
+    }
+    else {
+        assert(VK_NULL_HANDLE != p_renderer->vk_swapchain);
+
+        vk_res = vkAcquireNextImageKHR(p_renderer->vk_device, 
+                                       p_renderer->vk_swapchain, 
+                                       UINT64_MAX, 
+                                       semaphore, 
+                                       fence, 
+                                       &(p_renderer->swapchain_image_index));
+        assert(VK_SUCCESS == vk_res);
+    }
 
-    vk_res = vkWaitForFences(p_renderer->vk_device, 1, &fence, VK_TRUE, UINT64_MAX);
-    assert(VK_SUCCESS == vk_res);
+    // Without a fence the caller relies on p_signal_semaphore alone
+    if (VK_NULL_HANDLE != fence) {
+        vk_res = vkWaitForFences(p_renderer->vk_device, 1, &fence, VK_TRUE, UINT64_MAX);
+        assert(VK_SUCCESS == vk_res);
 
-    vk_res = vkResetFences(p_renderer->vk_device, 1, &fence);
-    assert(VK_SUCCESS == vk_res);
+        vk_res = vkResetFences(p_renderer->vk_device, 1, &fence);
+        assert(VK_SUCCESS == vk_res);
+    }
 }
 
 void tr_internal_vk_queue_submit(
@@ -5612,7 +8528,8 @@ void tr_internal_vk_queue_submit(
     uint32_t       wait_semaphore_count,
     tr_semaphore** pp_wait_semaphores,
     uint32_t       signal_semaphore_count,
-    tr_semaphore** pp_signal_semaphores
+    tr_semaphore** pp_signal_semaphores,
+    tr_fence*      p_signal_fence
 )
 {
     assert(VK_NULL_HANDLE != p_queue->vk_queue);
@@ -5633,7 +8550,7 @@ void tr_internal_vk_queue_submit(
 
     TINY_RENDERER_DECLARE_ZERO(VkSemaphore, signal_semaphores[tr_max_submit_signal_semaphores]);
     signal_semaphore_count = signal_semaphore_count > tr_max_submit_signal_semaphores ? tr_max_submit_signal_semaphores : signal_semaphore_count;
-    for (uint32_t i = 0; i < wait_semaphore_count; ++i) {
+    for (uint32_t i = 0; i < signal_semaphore_count; ++i) {
         signal_semaphores[i] = pp_signal_semaphores[i]->vk_semaphore;
     }
 
@@ -5647,7 +8564,9 @@ void tr_internal_vk_queue_submit(
     submit_info.pCommandBuffers      = cmds;
     submit_info.signalSemaphoreCount = signal_semaphore_count;
     submit_info.pSignalSemaphores    = signal_semaphores;
-    VkResult vk_res = vkQueueSubmit(p_queue->vk_queue, 1, &submit_info, VK_NULL_HANDLE);
+
+    VkFence fence = (NULL != p_signal_fence) ? p_signal_fence->vk_fence : VK_NULL_HANDLE;
+    VkResult vk_res = vkQueueSubmit(p_queue->vk_queue, 1, &submit_info, fence);
     assert(VK_SUCCESS == vk_res);
 }
 
@@ -5657,6 +8576,12 @@ void tr_internal_vk_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_cou
 
     tr_renderer* renderer = p_queue->renderer;
 
+    // Nothing to display, but the wait semaphores still have to be consumed
+    if (renderer->settings.headless) {
+        tr_internal_vk_queue_submit(p_queue, 0, NULL, wait_semaphore_count, pp_wait_semaphores, 0, NULL, NULL);
+        return;
+    }
+
     TINY_RENDERER_DECLARE_ZERO(VkSemaphore, wait_semaphores[tr_max_present_wait_semaphores]);
     wait_semaphore_count = wait_semaphore_count > tr_max_present_wait_semaphores ? wait_semaphore_count : wait_semaphore_count;
     for (uint32_t i = 0; i < wait_semaphore_count; ++i) {